@@ -0,0 +1,783 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "OVR_CAPI.h"
+#include "Kernel/OVR_Lockless.h"
+#include "pv/SkeletonFilter.h"
+#include "pv/TrackedPose.h"
+#include "pvmm/WindowSystem.h"
+#include "pvmm/MidOpenGL.h"
+#include "pvmm/RenderCommandList.h"
+#ifdef _WIN32
+#include "pv/HmdManager.h"
+#endif
+
+using namespace PV;
+
+/**
+ * Where benchmarks add up the values they read, so the reads are not optimized away.
+ */
+static volatile unsigned int benchmarkSink;
+
+/**
+ * Creates a window with an OpenGL context for a benchmark to draw with, and makes the context current.
+ * @param window The window to create.
+ * @param title The window's title, which must differ between windows since it names the window's class.
+ * @param settings The settings to create the context with.
+ * @param width The width of the window.
+ * @param height The height of the window.
+ * @return Returns true if the context is current, false otherwise.
+ */
+static bool createBenchmarkWindow(PV::Window& window, const wchar_t* title, const ContextSettings& settings, unsigned int width, unsigned int height)
+{
+	window.setContextSettings(settings);
+#ifdef _WIN32
+	if (window.create(title, width, height, false, *(windowProcessCallback*)NULL) != OK)
+#else
+	if (window.createHeadless(width, height) != OK)
+#endif
+	{
+		return false;
+	}
+	if (window.setWindowDrawingStateGL() != OK)
+	{
+		return false;
+	}
+	initMidGL();
+	return true;
+}
+
+/**
+ * Records a frame of 10,000 draws spread over 8 programs, 64 textures, 32 vertex arrays and 2 passes in a random
+ * order, then counts the state changes made executing it before and after sorting, and times the sort.
+ */
+static void benchmarkCommandSorting()
+{
+	const int programCount = 8;
+	const int textureCount = 64;
+	const int vertexArrayCount = 32;
+	const int drawCount = 10000;
+	const int sortRepeats = 100;
+	const int executeRepeats = 10;
+
+	PV::Window window;
+	if (!createBenchmarkWindow(window, L"Project Virtua - Sorting Benchmark", GetDefaultContextSettings(), 64, 64))
+	{
+		printf("Command sorting: could not create an OpenGL context\n");
+		return;
+	}
+
+	// Programs are compiled without the cache, so the benchmark leaves nothing behind.
+	setShaderCacheDirectory(NULL);
+	unsigned int programs[programCount];
+	int mvpLocations[programCount];
+	for (int i = 0; i < programCount; i += 1)
+	{
+		programs[i] = createShadersFromSource(
+			"#version 150\nin vec3 position;\nuniform mat4 mvp;\nvoid main() { gl_Position = mvp * vec4(position, 1.0); }\n",
+			"#version 150\nout vec4 color;\nvoid main() { color = vec4(PROGRAM / 8.0); }\n",
+			(i & 1) ? "#define PROGRAM 1.0" : "#define PROGRAM 0.0");
+		mvpLocations[i] = pv_glGetUniformLocation(programs[i], "mvp");
+	}
+
+	unsigned int textures[textureCount];
+	unsigned char pixel[4] = { 255, 255, 255, 255 };
+	glGenTextures(textureCount, textures);
+	for (int i = 0; i < textureCount; i += 1)
+	{
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+	}
+
+	float triangle[9] = { -0.01f, -0.01f, 0.0f, 0.01f, -0.01f, 0.0f, 0.0f, 0.01f, 0.0f };
+	unsigned int vertexBuffer;
+	unsigned int vertexArrays[vertexArrayCount];
+	pv_glGenBuffers(1, &vertexBuffer);
+	pv_glBindBuffer(PV_GL_ARRAY_BUFFER, vertexBuffer);
+	pv_glBufferData(PV_GL_ARRAY_BUFFER, sizeof(triangle), triangle, PV_GL_STATIC_DRAW);
+	pv_glGenVertexArrays(vertexArrayCount, vertexArrays);
+	for (int i = 0; i < vertexArrayCount; i += 1)
+	{
+		pv_glBindVertexArray(vertexArrays[i]);
+		pv_glEnableVertexAttribArray(0);
+		pv_glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	}
+	pv_glBindVertexArray(0);
+
+	float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	RenderCommandList frame;
+	srand(1);
+	for (int i = 0; i < drawCount; i += 1)
+	{
+		int program = rand() % programCount;
+		frame.Draw(rand() % 2, (rand() % 1000) / 1000.0f, programs[program], mvpLocations[program], vertexArrays[rand() % vertexArrayCount],
+			textures[rand() % textureCount], GL_TRIANGLES, 0, 3, identity);
+	}
+
+	// The first execution also pays for the driver finishing the programs, so it is left out of the timing.
+	RenderStats unsortedStats = { 0, 0, 0, 0 };
+	frame.Execute(identity, NULL, &unsortedStats);
+	glFinish();
+	double start = ovr_GetTimeInSeconds();
+	for (int i = 0; i < executeRepeats; i += 1)
+	{
+		frame.Execute(identity, NULL);
+	}
+	glFinish();
+	double unsortedTime = (ovr_GetTimeInSeconds() - start) / executeRepeats;
+
+	start = ovr_GetTimeInSeconds();
+	for (int i = 0; i < sortRepeats; i += 1)
+	{
+		frame.Sort();
+	}
+	double sortTime = (ovr_GetTimeInSeconds() - start) / sortRepeats;
+
+	RenderStats sortedStats = { 0, 0, 0, 0 };
+	frame.Execute(identity, NULL, &sortedStats);
+	glFinish();
+	start = ovr_GetTimeInSeconds();
+	for (int i = 0; i < executeRepeats; i += 1)
+	{
+		frame.Execute(identity, NULL);
+	}
+	glFinish();
+	double sortedTime = (ovr_GetTimeInSeconds() - start) / executeRepeats;
+
+	printf("Command sorting, %d draws over %d programs, %d textures and %d vertex arrays:\n", drawCount, programCount, textureCount, vertexArrayCount);
+	printf("  unsorted: %u program, %u texture and %u vertex array changes, executed in %.2f ms\n",
+		unsortedStats.programChanges, unsortedStats.textureChanges, unsortedStats.vertexArrayChanges, unsortedTime * 1000.0);
+	printf("  sorted:   %u program, %u texture and %u vertex array changes, executed in %.2f ms\n",
+		sortedStats.programChanges, sortedStats.textureChanges, sortedStats.vertexArrayChanges, sortedTime * 1000.0);
+	printf("  sort:     %.3f ms\n", sortTime * 1000.0);
+
+	pv_glDeleteVertexArrays(vertexArrayCount, vertexArrays);
+	pv_glDeleteBuffers(1, &vertexBuffer);
+	glDeleteTextures(textureCount, textures);
+	for (int i = 0; i < programCount; i += 1)
+	{
+		pv_glDeleteProgram(programs[i]);
+	}
+	window.destroyGLSystem();
+	window.destroy();
+}
+
+/**
+ * The head pose double buffer read by the tracked pose benchmark.
+ */
+static OVR::LocklessUpdater<TrackedPose, TrackedPose> benchmarkPose;
+/**
+ * A boolean telling the tracked pose benchmark's writer to keep going.
+ */
+static std::atomic<bool> benchmarkPublishing;
+
+/**
+ * Publishes head poses the way the Oculus Rift's tracking thread does, until told to stop.
+ * @param rate The number of poses to publish per second, or 0 to publish them as fast as possible.
+ */
+static void publishPoses(unsigned int rate)
+{
+	TrackedPose pose;
+	memset(&pose, 0, sizeof(pose));
+	while (benchmarkPublishing)
+	{
+		pose.sampleIndex += 1;
+		pose.time = ovr_GetTimeInSeconds();
+		benchmarkPose.SetState(pose);
+		if (rate > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(1000000 / rate));
+		}
+	}
+}
+
+/**
+ * Times reading the newest head pose with nothing publishing, with poses published at the tracking thread's
+ * default rate, and with poses published as fast as possible, which makes readers retry torn reads.
+ */
+static void benchmarkTrackedPoseReads()
+{
+	const int readCount = 20000000;
+	const char* writers[3] = { "writer idle", "writer at 1 kHz", "writer flat out" };
+	unsigned int rates[3] = { 0, PV_TRACKING_RATE, 0 };
+
+	printf("Tracked pose reads:\n");
+	for (int i = 0; i < 3; i += 1)
+	{
+		std::thread writer;
+		benchmarkPublishing = i > 0;
+		if (i > 0)
+		{
+			writer = std::thread(publishPoses, rates[i]);
+		}
+
+		unsigned int sum = 0;
+		double start = ovr_GetTimeInSeconds();
+		for (int read = 0; read < readCount; read += 1)
+		{
+			sum += benchmarkPose.GetState().sampleIndex;
+		}
+		double elapsed = ovr_GetTimeInSeconds() - start;
+		benchmarkSink += sum;
+
+		benchmarkPublishing = false;
+		if (writer.joinable())
+		{
+			writer.join();
+		}
+		printf("  %-16s %.1f ns per read\n", writers[i], elapsed * 1000000000.0 / readCount);
+	}
+}
+
+/**
+ * Filters 100 seconds of made up skeletons, 6 people at 30 frames per second with 5 millimeters of noise like the
+ * Kinect's, with each kind of filter.  Every joint sways side to side at its own pace while staying still up and
+ * down, so the error from side to side shows how far the filter lags and the error up and down how much jitter
+ * it lets through.
+ */
+static void benchmarkSkeletonFilter()
+{
+	const int frameCount = 3000;
+	const int settleFrames = 30;
+	const char* names[3] = { "none", "Holt", "One Euro" };
+
+	printf("Skeleton filter, %d people at 30 frames per second:\n", PV_SKELETON_PEOPLE);
+	for (int type = FilterNone; type <= FilterOneEuro; type += 1)
+	{
+		SkeletonFilter filter;
+		filter.SetType((SkeletonFilterType)type);
+		filter.SetHoltParameters(-1, 0.5f, 0.5f, 0.5f);
+
+		// The same noise for every filter, so they are compared on the same input.
+		std::mt19937 random(1);
+		std::normal_distribution<float> noise(0.0f, 0.005f);
+		SkeletonFrame frame;
+		float truth[PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		double movingError = 0.0;
+		double stillError = 0.0;
+		int samples = 0;
+		double filterTime = 0.0;
+		for (int i = 0; i < frameCount; i += 1)
+		{
+			memset(&frame, 0, sizeof(frame));
+			frame.time = 1.0 + i / 30.0;
+			frame.mainPerson = 0;
+			for (int person = 0; person < PV_SKELETON_PEOPLE; person += 1)
+			{
+				frame.tracked[person] = true;
+				for (int joint = 0; joint < PV_SKELETON_JOINTS; joint += 1)
+				{
+					truth[person][joint] = 0.2f * sinf(2.0f * 3.14159265f * (0.5f + 0.05f * joint) * (i / 30.0f) + person);
+					frame.x[person][joint] = truth[person][joint] + noise(random);
+					frame.y[person][joint] = 1.0f + noise(random);
+					frame.z[person][joint] = 2.0f + noise(random);
+				}
+			}
+
+			double start = ovr_GetTimeInSeconds();
+			filter.Apply(frame);
+			filterTime += ovr_GetTimeInSeconds() - start;
+
+			if (i >= settleFrames)
+			{
+				for (int person = 0; person < PV_SKELETON_PEOPLE; person += 1)
+				{
+					for (int joint = 0; joint < PV_SKELETON_JOINTS; joint += 1)
+					{
+						double moving = frame.x[person][joint] - truth[person][joint];
+						double still = frame.y[person][joint] - 1.0f;
+						movingError += moving * moving;
+						stillError += still * still;
+						samples += 1;
+					}
+				}
+			}
+		}
+		printf("  %-9s %.2f mm error moving, %.2f mm jitter still, %.0f ns per frame\n", names[type],
+			1000.0 * sqrt(movingError / samples), 1000.0 * sqrt(stillError / samples), filterTime * 1000000000.0 / frameCount);
+	}
+}
+
+/**
+ * Times 2,000,000 rounds of setting a uniform, binding a buffer and binding a texture, the calls a frame makes
+ * most, with the given context settings.  The best of 5 runs is printed along with the context the driver gave.
+ * @param name The name to print the results under.
+ * @param title The title of the benchmark's window, which must differ between calls.
+ * @param settings The settings to create the context with.
+ */
+static void benchmarkContext(const char* name, const wchar_t* title, const ContextSettings& settings)
+{
+	const int callCount = 2000000;
+	const int runCount = 5;
+
+	PV::Window window;
+	if (!createBenchmarkWindow(window, title, settings, 64, 64))
+	{
+		printf("  %-24s could not create the context\n", name);
+		return;
+	}
+
+	setShaderCacheDirectory(NULL);
+	unsigned int program = createShadersFromSource(
+		"#version 150\nuniform vec4 position;\nvoid main() { gl_Position = position; }\n",
+		"#version 150\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n", NULL);
+	pv_glUseProgram(program);
+	int positionLocation = pv_glGetUniformLocation(program, "position");
+	unsigned int buffers[2];
+	unsigned int textures[2];
+	pv_glGenBuffers(2, buffers);
+	glGenTextures(2, textures);
+
+	double best = 0.0;
+	for (int run = 0; run < runCount; run += 1)
+	{
+		double start = ovr_GetTimeInSeconds();
+		for (int i = 0; i < callCount; i += 1)
+		{
+			pv_glUniform4f(positionLocation, (float)i, 0.0f, 0.0f, 1.0f);
+			pv_glBindBuffer(PV_GL_ARRAY_BUFFER, buffers[i & 1]);
+			glBindTexture(GL_TEXTURE_2D, textures[i & 1]);
+		}
+		glFinish();
+		double elapsed = ovr_GetTimeInSeconds() - start;
+		if (run == 0 || elapsed < best)
+		{
+			best = elapsed;
+		}
+	}
+
+	ContextSettings given = window.GetContextSettings();
+	printf("  %-24s %.1f ns per call, given %d.%d %s%s\n", name, best * 1000000000.0 / (callCount * 3),
+		given.majorVersion, given.minorVersion, given.profile == ProfileCore ? "core" : "compatibility", given.noError ? " without errors" : "");
+
+	glDeleteTextures(2, textures);
+	pv_glDeleteBuffers(2, buffers);
+	pv_glDeleteProgram(program);
+	window.destroyGLSystem();
+	window.destroy();
+}
+
+/**
+ * Compares the cost of common calls with and without KHR_no_error, in both a compatibility and a core context.
+ */
+static void benchmarkContextSettings()
+{
+	printf("Context settings, uniform and bind calls:\n");
+	ContextSettings settings = GetDefaultContextSettings();
+	settings.debug = false;
+	settings.noError = false;
+	benchmarkContext("compatibility", L"Project Virtua - Compatibility Benchmark", settings);
+	settings.noError = true;
+	benchmarkContext("compatibility, no error", L"Project Virtua - Compatibility No Error Benchmark", settings);
+
+	settings.profile = ProfileCore;
+	settings.majorVersion = 4;
+	settings.minorVersion = 5;
+	settings.noError = false;
+	benchmarkContext("core 4.5", L"Project Virtua - Core Benchmark", settings);
+	settings.noError = true;
+	benchmarkContext("core 4.5, no error", L"Project Virtua - Core No Error Benchmark", settings);
+}
+
+/**
+ * Times building a frame's camera matrices 1,000,000 times, first for one eye the way the demo used to with Matrix
+ * objects and operator*, then for both eyes with the array builders and createEyeMatrices.
+ */
+static void benchmarkCameraMatrices()
+{
+	const int frameCount = 1000000;
+	Math::vec3 rotation = { 0.4f, -1.1f, 0.25f };
+	float sum = 0.0f;
+
+	double start = ovr_GetTimeInSeconds();
+	for (int i = 0; i < frameCount; i += 1)
+	{
+		Math::vec3 position = { 0.3f + i * 0.000001f, -1.2f, 4.0f };
+		Math::Matrix<float> view(4, 4);
+		Math::Matrix<float> projection(4, 4);
+		createLookAtMatrix(view, position, rotation);
+		createPerspectiveMatrix(projection, 45.0f, 1.6f, 0.1f, 1000.0f);
+		Math::Matrix<float> viewProjection = projection * view;
+		sum += viewProjection[5];
+	}
+	double matrixTime = (ovr_GetTimeInSeconds() - start) / frameCount;
+
+	start = ovr_GetTimeInSeconds();
+	for (int i = 0; i < frameCount; i += 1)
+	{
+		Math::vec3 position = { 0.3f + i * 0.000001f, -1.2f, 4.0f };
+		float headView[16];
+		EyeMatrices eyes[2];
+		createLookAtMatrix(headView, position, rotation);
+		for (int eye = 0; eye < 2; eye += 1)
+		{
+			Math::vec3 viewAdjust = { (eye == 0) ? -0.032f : 0.032f, 0.0f, 0.0f };
+			createEyeMatrices(eyes[eye], headView, viewAdjust, 1.2f, 1.3f, 1.05f, 0.9f, 0.1f, 1000.0f);
+		}
+		sum += eyes[0].viewProjection[5] + eyes[1].viewProjection[5];
+	}
+	double arrayTime = (ovr_GetTimeInSeconds() - start) / frameCount;
+	benchmarkSink += (unsigned int)sum;
+
+	printf("Camera matrices:\n");
+	printf("  Matrix, one eye:  %.1f ns per frame\n", matrixTime * 1000000000.0);
+	printf("  arrays, two eyes: %.1f ns per frame\n", arrayTime * 1000000000.0);
+}
+
+#ifdef _WIN32
+/**
+ * The number of layers in the headset benchmarks' scene.
+ */
+#define PV_BENCHMARK_LAYERS 16
+/**
+ * The most headsets the headset benchmark adds.
+ */
+#define PV_BENCHMARK_HEADSETS 4
+
+/**
+ * The scene the headset benchmarks draw: layers of quads filling the view one behind the other, drawn back to
+ * front so every layer is shaded and the eyes are bound by fill-rate.
+ */
+struct BenchmarkScene
+{
+	/**
+	 * The program the quads are drawn with.
+	 */
+	unsigned int program;
+	/**
+	 * The buffer holding the quad's vertices.
+	 */
+	unsigned int vertexBuffer;
+	/**
+	 * The vertex array of the quad, which only exists on the context the scene was created on.
+	 */
+	unsigned int vertexArray;
+	/**
+	 * The model matrices of the layers, column major.
+	 */
+	float modelMatrices[PV_BENCHMARK_LAYERS][16];
+	/**
+	 * The recorded draws of the layers.
+	 */
+	RenderCommandList commands;
+};
+
+/**
+ * Creates the headset benchmarks' scene on the current OpenGL context.
+ * @param scene The scene to create.
+ */
+static void createBenchmarkScene(BenchmarkScene& scene)
+{
+	setShaderCacheDirectory(NULL);
+	scene.program = createShadersFromSource(
+		"#version 150\nin vec3 position;\nuniform mat4 mvp;\nvoid main() { gl_Position = mvp * vec4(position, 1.0); }\n",
+		"#version 150\nout vec4 color;\nvoid main() { color = vec4(gl_FragCoord.z, 0.5, 1.0, 1.0); }\n", NULL);
+	int mvpLocation = pv_glGetUniformLocation(scene.program, "mvp");
+
+	float quad[12] = { -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, -1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f };
+	pv_glGenBuffers(1, &scene.vertexBuffer);
+	pv_glBindBuffer(PV_GL_ARRAY_BUFFER, scene.vertexBuffer);
+	pv_glBufferData(PV_GL_ARRAY_BUFFER, sizeof(quad), quad, PV_GL_STATIC_DRAW);
+	pv_glGenVertexArrays(1, &scene.vertexArray);
+	pv_glBindVertexArray(scene.vertexArray);
+	pv_glEnableVertexAttribArray(0);
+	pv_glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	pv_glBindVertexArray(0);
+	pv_glBindBuffer(PV_GL_ARRAY_BUFFER, 0);
+
+	// Each layer is scaled with its distance so it covers the same wide view, furthest first.
+	for (int i = 0; i < PV_BENCHMARK_LAYERS; i += 1)
+	{
+		float distance = 1.0f + 0.25f * (PV_BENCHMARK_LAYERS - 1 - i);
+		float* model = scene.modelMatrices[i];
+		memset(model, 0, sizeof(scene.modelMatrices[i]));
+		model[0] = 4.0f * distance;
+		model[5] = 4.0f * distance;
+		model[10] = 1.0f;
+		model[14] = -distance;
+		model[15] = 1.0f;
+		scene.commands.Draw(scene.program, mvpLocation, scene.vertexArray, 0, GL_TRIANGLE_STRIP, 0, 4, model);
+	}
+}
+
+/**
+ * Deletes the headset benchmarks' scene, with the context it was created on current.
+ * @param scene The scene to delete.
+ */
+static void destroyBenchmarkScene(BenchmarkScene& scene)
+{
+	pv_glDeleteVertexArrays(1, &scene.vertexArray);
+	pv_glDeleteBuffers(1, &scene.vertexBuffer);
+	pv_glDeleteProgram(scene.program);
+}
+
+/**
+ * Renders one frame of the scene to an Oculus Rift the same way the demo does, finishing the GPU's work before
+ * the left eye and after the right one so the time spent on the eyes can be measured.
+ * @param rift The Oculus Rift to render to, whose OpenGL context must be current.
+ * @param scene The scene to draw in each eye.
+ * @return The time from starting the left eye until the GPU finished the right eye, in seconds.
+ */
+static double renderBenchmarkFrame(OculusRift& rift, const BenchmarkScene& scene)
+{
+	Math::Matrix<float> viewMatrix(4, 4);
+	Math::Matrix<float> perspectiveMatrix(4, 4);
+	if (!rift.StartRender())
+	{
+		return 0.0;
+	}
+
+	glFinish();
+	double start = ovr_GetTimeInSeconds();
+	for (int eye = Left; eye <= Right; eye += 1)
+	{
+		rift.StartEyeRender((RiftEye)eye, viewMatrix);
+		for (unsigned int region = 0; region < rift.GetEyeRegionCount((RiftEye)eye); region += 1)
+		{
+			rift.StartEyeRegion((RiftEye)eye, region, perspectiveMatrix);
+			glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+			glClear(rift.IsHiddenAreaMasking() ? GL_COLOR_BUFFER_BIT : (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+			scene.commands.Execute(perspectiveMatrix.getArray(), viewMatrix.getArray());
+		}
+		rift.EndEyeRender((RiftEye)eye);
+	}
+	glFinish();
+	double eyeTime = ovr_GetTimeInSeconds() - start;
+
+	pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
+	glDisable(GL_DEPTH_TEST);
+	rift.EndRender();
+	glEnable(GL_DEPTH_TEST);
+	return eyeTime;
+}
+
+/**
+ * Adds virtual headsets to a HmdManager one at a time, up to PV_BENCHMARK_HEADSETS, each with its own window and
+ * context.  After each one is added every headset renders PV_FRAME_RECORDS frames of the scene, so each headset's
+ * frame records all come from that round, and what each headset costs per frame is printed.
+ */
+static void benchmarkHeadsetCount()
+{
+	const wchar_t* titles[PV_BENCHMARK_HEADSETS] = { L"Project Virtua - Headset Benchmark 1", L"Project Virtua - Headset Benchmark 2",
+		L"Project Virtua - Headset Benchmark 3", L"Project Virtua - Headset Benchmark 4" };
+	PV::Window windows[PV_BENCHMARK_HEADSETS];
+	BenchmarkScene scenes[PV_BENCHMARK_HEADSETS];
+	double eyeTimes[PV_BENCHMARK_HEADSETS];
+	unsigned int count = 0;
+
+	printf("Virtual headsets, %d layers per eye:\n", PV_BENCHMARK_LAYERS);
+	{
+		// Declared in its own block so it destroys the headsets before their windows are destroyed.
+		HmdManager manager;
+		while (count < PV_BENCHMARK_HEADSETS)
+		{
+			// Each context must not have created any objects before it is added, so the scene comes afterwards.
+			if (!createBenchmarkWindow(windows[count], titles[count], GetDefaultContextSettings(), 1280, 800))
+			{
+				printf("  could not create a window for headset %u\n", count + 1);
+				break;
+			}
+			windows[count].setVisible(true);
+			if (manager.Add(true, windows[count].renderingContext, windows[count].windowHandle, windows[count].deviceContext) == NULL)
+			{
+				printf("  could not add headset %u\n", count + 1);
+				windows[count].destroyGLSystem();
+				windows[count].destroy();
+				break;
+			}
+			createBenchmarkScene(scenes[count]);
+			count += 1;
+
+			for (unsigned int i = 0; i < count; i += 1)
+			{
+				eyeTimes[i] = 0.0;
+			}
+			for (int frame = 0; frame < PV_FRAME_RECORDS; frame += 1)
+			{
+				for (unsigned int i = 0; i < count; i += 1)
+				{
+					windows[i].MakeCurrentGLContext();
+					eyeTimes[i] += renderBenchmarkFrame(*manager[i], scenes[i]);
+				}
+			}
+
+			printf("  %u headset%s:\n", count, (count == 1) ? "" : "s");
+			double total = 0.0;
+			for (unsigned int i = 0; i < count; i += 1)
+			{
+				double averageEyeTime = eyeTimes[i] / PV_FRAME_RECORDS;
+				total += averageEyeTime;
+				printf("    headset %u: %.3f ms rendering both eyes, %.3f ms until the GPU finished\n", i + 1,
+					manager.GetAverageRenderTime(i) * 1000.0, averageEyeTime * 1000.0);
+			}
+			printf("    all:       %.3f ms until the GPU finished every headset\n", total * 1000.0);
+		}
+
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			windows[i].MakeCurrentGLContext();
+			destroyBenchmarkScene(scenes[i]);
+		}
+	}
+	for (unsigned int i = 0; i < count; i += 1)
+	{
+		windows[i].destroyGLSystem();
+		windows[i].destroy();
+	}
+}
+
+/**
+ * Renders the scene to a virtual Oculus Rift with and without masking the hidden area and with and without
+ * rendering at multiple resolutions, and prints the samples shaded for both eyes, the fraction of each eye's
+ * pixels rendered, and the time until the GPU finished the eyes, for each.
+ */
+static void benchmarkEyeFillRate()
+{
+	const int settleFrames = 30;
+	const int frameCount = 120;
+	const char* names[4] = { "whole eye", "hidden area masked", "multiple resolutions", "both" };
+
+	PV::Window window;
+	InitRift();
+	if (!createBenchmarkWindow(window, L"Project Virtua - Fill Rate Benchmark", GetDefaultContextSettings(), 1280, 800))
+	{
+		printf("Eye fill rate: could not create an OpenGL context\n");
+		ShutdownRift();
+		return;
+	}
+	window.setVisible(true);
+
+	printf("Eye fill rate, %d layers per eye:\n", PV_BENCHMARK_LAYERS);
+	{
+		// Declared in its own block so it is destroyed before its window.
+		OculusRift rift(true, window.renderingContext, window.windowHandle, window.deviceContext);
+		BenchmarkScene scene;
+		createBenchmarkScene(scene);
+		for (int i = 0; i < 4 && rift.isConnected(); i += 1)
+		{
+			rift.SetHiddenAreaMask((i & 1) != 0);
+			if ((i & 2) != 0)
+			{
+				rift.SetMultiResolution(0.6f, 0.5f);
+			}
+			else
+			{
+				rift.SetMultiResolution(1.0f, 1.0f);
+			}
+
+			// The sample counts come from queries a few frames old, so let them catch up with the change first.
+			for (int frame = 0; frame < settleFrames; frame += 1)
+			{
+				renderBenchmarkFrame(rift, scene);
+			}
+			double eyeTime = 0.0;
+			for (int frame = 0; frame < frameCount; frame += 1)
+			{
+				eyeTime += renderBenchmarkFrame(rift, scene);
+			}
+			printf("  %-21s %u samples shaded, %.2f of the pixels rendered, %.3f ms until the GPU finished\n", names[i],
+				rift.GetShadedSamples(Left) + rift.GetShadedSamples(Right), rift.GetRenderedPixelRatio(Left), eyeTime * 1000.0 / frameCount);
+		}
+		destroyBenchmarkScene(scene);
+	}
+
+	window.destroyGLSystem();
+	window.destroy();
+	ShutdownRift();
+}
+
+/**
+ * Mirrors both eyes of a virtual Oculus Rift to a 1280x720 spectator window the way the demo does, and prints how
+ * long Mirror took to submit on the CPU and how long until the GPU finished the blit, against the 0.3 ms a frame
+ * mirroring is allowed to cost.
+ */
+static void benchmarkMirror()
+{
+	const int settleFrames = 30;
+	const int frameCount = 120;
+	const double budget = 0.0003;
+
+	PV::Window window;
+	PV::Window mirrorWindow;
+	InitRift();
+	if (!createBenchmarkWindow(window, L"Project Virtua - Mirror Benchmark", GetDefaultContextSettings(), 1280, 800))
+	{
+		printf("Mirror: could not create an OpenGL context\n");
+		ShutdownRift();
+		return;
+	}
+	window.setVisible(true);
+
+	{
+		// Declared in its own block so it is destroyed before its window.
+		OculusRift rift(true, window.renderingContext, window.windowHandle, window.deviceContext);
+		if (rift.isConnected() && createBenchmarkWindow(mirrorWindow, L"Project Virtua - Mirror Benchmark Spectator", GetDefaultContextSettings(), 1280, 720))
+		{
+			// The same setup as the demo's -mirror, drawn with the headset's context and never waiting for vsync.
+			mirrorWindow.setVisible(true);
+			mirrorWindow.SetSwapInterval(0);
+			window.MakeCurrentGLContext();
+			rift.SetMirror(MirrorBothEyes, 0.1f);
+
+			BenchmarkScene scene;
+			createBenchmarkScene(scene);
+			double submitTime = 0.0;
+			double finishTime = 0.0;
+			for (int frame = 0; frame < settleFrames + frameCount; frame += 1)
+			{
+				renderBenchmarkFrame(rift, scene);
+				wglMakeCurrent(mirrorWindow.deviceContext, window.renderingContext);
+				glFinish();
+				double start = ovr_GetTimeInSeconds();
+				rift.Mirror(1280, 720);
+				glFinish();
+				if (frame >= settleFrames)
+				{
+					finishTime += ovr_GetTimeInSeconds() - start;
+					submitTime += rift.GetMirrorTime();
+				}
+				mirrorWindow.Update();
+				window.MakeCurrentGLContext();
+			}
+			destroyBenchmarkScene(scene);
+
+			submitTime /= frameCount;
+			finishTime /= frameCount;
+			printf("Mirror, both eyes to 1280x720:\n");
+			printf("  %.3f ms to submit, %.3f ms until the GPU finished, %s the %.1f ms budget\n", submitTime * 1000.0, finishTime * 1000.0,
+				(finishTime < budget) ? "within" : "over", budget * 1000.0);
+			mirrorWindow.destroyGLSystem();
+			mirrorWindow.destroy();
+		}
+		else
+		{
+			printf("Mirror: could not create the spectator window\n");
+		}
+	}
+
+	window.destroyGLSystem();
+	window.destroy();
+	ShutdownRift();
+}
+#endif
+
+int runBenchmarks()
+{
+	benchmarkCommandSorting();
+	benchmarkTrackedPoseReads();
+	benchmarkSkeletonFilter();
+	benchmarkContextSettings();
+	benchmarkCameraMatrices();
+#ifdef _WIN32
+	benchmarkHeadsetCount();
+	benchmarkEyeFillRate();
+	benchmarkMirror();
+#endif
+	return 0;
+}
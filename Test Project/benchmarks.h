@@ -0,0 +1,12 @@
+#ifndef _BENCHMARKS_H_
+#define _BENCHMARKS_H_
+
+/**
+ * Runs the benchmarks behind the performance numbers given for the engine's optimizations and prints their
+ * results, so they can be measured again on any machine.  Each benchmark makes whatever window, context or
+ * data it needs, and none of them needs an Oculus Rift or a Kinect.
+ * @return Returns 0 once every benchmark has run.
+ */
+int runBenchmarks();
+
+#endif
@@ -1,9 +1,15 @@
 #include <stdio.h>
+#include <string.h>
+#include <atomic>
 #include "pv/Kinect1.h"
 #include "pv/OculusRift.h"
-#include "pvmm/windowSystem.h"
+#include "pv/SyntheticSkeletons.h"
+#include "pvmm/WindowSystem.h"
 #include "pvmm/MidOpenGL.h"
 #include "pvmm/WavefrontObject.h"
+#include "pvmm/FramePipeline.h"
+#include "pvmm/MirrorRecorder.h"
+#include "benchmarks.h"
 
 using namespace PV;
 
@@ -18,6 +24,24 @@ unsigned int colorsBufferHandle;
 unsigned int texCoordsBufferHandle;
 unsigned int verticesArrayHandle;
 float rotation = 0.0f;
+Math::Matrix<float> modelMatrix(4, 4);
+
+/**
+ * Everything the render thread needs to turn a recorded frame into pixels.
+ */
+struct RenderState
+{
+	Window* window;
+	OculusRift* rift;
+	Math::Matrix<float>* perspectiveMatrix;
+	Math::Matrix<float>* viewMatrix;
+	Window* mirrorWindow;
+	MirrorRecorder* recorder;
+	const char* recordFileName;
+	//Set by the simulation thread when the warning screen should go away, since only the render thread may touch
+	//the Oculus Rift
+	std::atomic<bool> dismissWarning;
+};
 
 void initQuad()
 {
@@ -68,49 +92,45 @@ void initQuad()
 	pv_glBindBuffer(PV_GL_ARRAY_BUFFER, 0);
 }
 
-void handleInput(OculusRift* rift, Kinect1* kinect, Math::vec3 &position, Math::vec3 &rotation)
+void handleInput(const InputSnapshot& input, std::atomic<bool>& dismissWarning, SkeletonSource* skeletons, Math::vec3 &position, Math::vec3 &rotation)
 {
-	if (rift->isConnected())
-	{
-		rift->Update();
-	}
-
-	const NUI_SKELETON_DATA skeleton = kinect->getMainPerson();
-	if (skeleton.eTrackingState == NUI_SKELETON_TRACKED)
+	static SkeletonFrame skeletonFrame;
+	skeletons->GetLatestFrame(skeletonFrame);
+	if (skeletonFrame.mainPerson >= 0)
 	{
-		position.x = -skeleton.Position.x;
+		position.x = -skeletonFrame.center[skeletonFrame.mainPerson][0];
 		position.y = 0;
-		position.z = -skeleton.Position.z;
+		position.z = -skeletonFrame.center[skeletonFrame.mainPerson][2];
 	}
 
-	if ((1 << 16) & GetAsyncKeyState(VK_LEFT))
+	if (IsKeyDown(input, PV_KEY_LEFT))
 	{
-		rift->DismissWarningScreen();
+		dismissWarning = true;
 		rotation.y += 1.0f * (float)M_PI / 180.0f;
 	}
-	if ((1 << 16) & GetAsyncKeyState(VK_RIGHT))
+	if (IsKeyDown(input, PV_KEY_RIGHT))
 	{
-		rift->DismissWarningScreen();
+		dismissWarning = true;
 		rotation.y -= 1.0f * (float)M_PI / 180.0f;
 	}
-	if ((1 << 16) & GetAsyncKeyState(VK_UP))
+	if (IsKeyDown(input, PV_KEY_UP))
 	{
-		rift->DismissWarningScreen();
+		dismissWarning = true;
 		position.x += sin(rotation.y);
 		position.z += cos(rotation.y);
 	}
-	if ((1 << 16) & GetAsyncKeyState(VK_DOWN))
+	if (IsKeyDown(input, PV_KEY_DOWN))
 	{
-		rift->DismissWarningScreen();
+		dismissWarning = true;
 		position.x -= sin(rotation.y);
 		position.z -= cos(rotation.y);
 	}
 
 }
 
-void drawGLScene(unsigned int program, Math::Matrix<float> perspectiveMatrix, Math::Matrix<float> viewMatrix)
+void recordGLScene(RenderCommandList* frame, unsigned int program, int mvpLocation)
 {
-	Math::Matrix<float> modelMatrix(4, 4);
+	modelMatrix.SetIdentity();
 	modelMatrix.Translate(1.0f, 1.0f, 1.0f);
 	modelMatrix.Rotate(0, 0, 0);
 	modelMatrix.Translate(-1.0f, -1.0f, -1.0f);
@@ -121,26 +141,126 @@ void drawGLScene(unsigned int program, Math::Matrix<float> perspectiveMatrix, Ma
 	}
 	rotation += 0.01f;
 
-	pv_glUseProgram(program);
-
-	Math::Matrix<float> mvp = perspectiveMatrix * viewMatrix * modelMatrix;
-	unsigned int mvpLocation = pv_glGetUniformLocation(program, "mvp");
-	pv_glUniformMatrix4fv(mvpLocation, 1, false, mvp.getArray());
+	frame->Draw(program, mvpLocation, verticesArrayHandle, 0, GL_TRIANGLE_STRIP, 0, 4, modelMatrix.getArray());
+}
 
+void clearGLScene(bool clearDepth)
+{
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClear(clearDepth ? (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT) : GL_COLOR_BUFFER_BIT);
+}
 
-	pv_glEnableVertexAttribArray(0);
-	pv_glEnableVertexAttribArray(1);
-	pv_glEnableVertexAttribArray(2);
+void renderFrame(const RenderCommandList* frame, void* userData)
+{
+	RenderState* state = (RenderState*)userData;
+	OculusRift* rift = state->rift;
 
-	pv_glBindVertexArray(verticesArrayHandle);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	pv_glBindVertexArray(0);
+	//The Oculus Rift is only used on this thread, the simulation gets the head pose from the tracking thread
+	if (state->dismissWarning.exchange(false))
+	{
+		rift->DismissWarningScreen();
+	}
+	if (rift->isConnected())
+	{
+		rift->Update();
+	}
+
+	//Attempts to render to OculusRift
+	if (rift->StartRender())
+	{
+		//Renders left eye
+		rift->StartEyeRender(Left, *state->viewMatrix);
+		for (unsigned int region = 0; region < rift->GetEyeRegionCount(Left); region += 1)
+		{
+			rift->StartEyeRegion(Left, region, *state->perspectiveMatrix);
+			clearGLScene(!rift->IsHiddenAreaMasking());
+			frame->Execute(state->perspectiveMatrix->getArray(), state->viewMatrix->getArray());
+		}
+		rift->EndEyeRender(Left);
+
+		//Renders right eye
+		rift->StartEyeRender(Right, *state->viewMatrix);
+		for (unsigned int region = 0; region < rift->GetEyeRegionCount(Right); region += 1)
+		{
+			rift->StartEyeRegion(Right, region, *state->perspectiveMatrix);
+			clearGLScene(!rift->IsHiddenAreaMasking());
+			frame->Execute(state->perspectiveMatrix->getArray(), state->viewMatrix->getArray());
+		}
+		rift->EndEyeRender(Right);
+
+		//Frame buffering is not handled automatically!
+		pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
+		glDisable(GL_DEPTH_TEST);
+		rift->EndRender();
+		glEnable(GL_DEPTH_TEST);
+		glClearDepth(1);
+
+		//Show what the headset sees on the spectator window, using this context so the eye textures can be blitted
+		if (state->mirrorWindow != NULL)
+		{
+			wglMakeCurrent(state->mirrorWindow->deviceContext, state->window->renderingContext);
+			rift->Mirror(1280, 720);
+			if (state->recordFileName != NULL && !state->recorder->IsRecording())
+			{
+				state->recorder->Start(state->recordFileName, 1280, 720);
+			}
+			state->recorder->Capture();
+			state->mirrorWindow->Update();
+			state->window->MakeCurrentGLContext();
+		}
+	}
+	//Rendering to window if OculusRift fails
+	else
+	{
+		//The window's thread records resizes, but only this thread can set the viewport to match
+		InputSnapshot input = state->window->GetInput();
+		pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, input.windowWidth, input.windowHeight);
+		clearGLScene(true);
+		frame->Execute(state->perspectiveMatrix->getArray(), NULL);
+		state->window->Update();
+	}
 }
 
-int main()
+int main(int argc, char** argv)
 {
+	//Passing -virtualrift runs the stereo path on a virtual Oculus Rift when no headset is connected,
+	//optionally following a trajectory file recorded from a real one
+	bool useVirtualRift = argc > 1 && strcmp(argv[1], "-virtualrift") == 0;
+	//Passing -mirror shows the headset's eyes on a spectator window, and -record also records it to mirror.rgba
+	bool useMirror = false;
+	bool useRecorder = false;
+	//Passing -capture records the Kinect and headset input to capture.pvsc, and -replay <file> plays a capture
+	//back on a virtual Oculus Rift so that runs can be repeated without any hardware
+	bool useCapture = false;
+	const char* replayFileName = NULL;
+	//Passing -syntheticskeletons makes up the user's skeleton instead of reading it from the Kinect
+	bool useSyntheticSkeletons = false;
+	//Passing -oneeuro smooths the Kinect's skeletons with a One Euro filter instead of the Kinect's own smoothing
+	bool useOneEuro = false;
+	for (int i = 1; i < argc; i += 1)
+	{
+		useSyntheticSkeletons = useSyntheticSkeletons || strcmp(argv[i], "-syntheticskeletons") == 0;
+		useOneEuro = useOneEuro || strcmp(argv[i], "-oneeuro") == 0;
+		useMirror = useMirror || strcmp(argv[i], "-mirror") == 0 || strcmp(argv[i], "-record") == 0;
+		useRecorder = useRecorder || strcmp(argv[i], "-record") == 0;
+		useCapture = useCapture || strcmp(argv[i], "-capture") == 0;
+		if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+		{
+			replayFileName = argv[i + 1];
+			useVirtualRift = true;
+		}
+	}
+	//Passing -bench runs the benchmarks behind the engine's performance numbers instead of the demo
+	if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+	{
+		return runBenchmarks();
+	}
+	//Declared before the sensors, so they are destroyed after the sensor threads using them stop
+	SensorRecorder sensorRecorder;
+	SensorReplay sensorReplay;
+	SkeletonFilter skeletonFilter;
+
 	InitRift();
 	Window testWindow;
 	//Matrices to handle camera view and warping for OculusRift
@@ -153,79 +273,132 @@ int main()
 	Math::vec3 rotation = { 0, 0, 0 };
 
 	Kinect1* kinect = new Kinect1();
-	MSG msg;
-
+	SyntheticSkeletons syntheticSkeletons(1, 30);
+	SkeletonSource* skeletons = kinect;
+	if (useOneEuro)
+	{
+		skeletonFilter.SetType(FilterOneEuro);
+		kinect->SetFilter(&skeletonFilter);
+	}
+	if (useSyntheticSkeletons)
+	{
+		syntheticSkeletons.Start();
+		skeletons = &syntheticSkeletons;
+	}
 	testWindow.create(L"Project Virtua - Test Project", 1280, 800, false, *(windowProcessCallback*)NULL);
 	testWindow.setWindowDrawingStateGL();
 	testWindow.setVisible(true);
 
 	initMidGL();
-	wglSwapIntervalEXT(1);
+	testWindow.SetSwapInterval(1);
 
 	glEnable(GL_LINE_SMOOTH);
 
 	//Create OculusRift object, passing the rendering context, device context, and handle of this window
-	OculusRift rift(false, testWindow.renderingContext, testWindow.windowHandle, testWindow.deviceContext);
+	OculusRift rift(useVirtualRift, testWindow.renderingContext, testWindow.windowHandle, testWindow.deviceContext);
+	if (rift.isVirtuallyConnected() && argc > 2 && strcmp(argv[1], "-virtualrift") == 0 && argv[2][0] != '-')
+	{
+		rift.GetVirtualTrajectory().Load(argv[2]);
+	}
+	//Skip shading the parts of the eye textures that the lenses never show
+	rift.SetHiddenAreaMask(true);
+	//Render the outer part of each eye, which the lenses squeeze together, at half density
+	rift.SetMultiResolution(0.6f, 0.5f);
+	//Keep far away surfaces from z-fighting with floating point depth that is most precise in the distance
+	rift.SetReverseDepth(true);
+	//Sample the head pose on its own thread, so the simulation always reads the freshest one
+	rift.StartTracking(1000);
+	//Without a headset the window draws the scene itself, so tear rather than stutter on a late frame, and swap at
+	//most 60 times per second. This only limits the render thread; the simulation thread sleeps in BeginFrame
+	//until the renderer has taken its last frame, so it is held to the same rate.
+	if (!rift.isConnected())
+	{
+		testWindow.SetSwapInterval(-1);
+		testWindow.SetFrameLimit(60.0);
+	}
+
+	if (replayFileName != NULL && sensorReplay.Load(replayFileName))
+	{
+		sensorReplay.Start();
+		rift.SetReplay(&sensorReplay);
+		kinect->SetReplay(&sensorReplay);
+	}
+	else if (useCapture && sensorRecorder.Start("capture.pvsc"))
+	{
+		rift.SetRecorder(&sensorRecorder);
+		kinect->SetRecorder(&sensorRecorder);
+	}
+
+	//The spectator window is drawn with the main window's context, and never waits for vsync so the headset does not
+	//wait on it either
+	Window mirrorWindow;
+	MirrorRecorder recorder;
+	if (useMirror && rift.isConnected())
+	{
+		mirrorWindow.create(L"Project Virtua - Spectator", 1280, 720, false, *(windowProcessCallback*)NULL);
+		mirrorWindow.setWindowDrawingStateGL();
+		mirrorWindow.setVisible(true);
+		mirrorWindow.SetSwapInterval(0);
+		testWindow.MakeCurrentGLContext();
+		rift.SetMirror(MirrorBothEyes, 0.1f);
+	}
 
 	initQuad();
+	//Shader programs are cached as binaries after the first run, which this shows by how long startup takes
+	double shaderStart = ovr_GetTimeInSeconds();
 	unsigned int program = createShaders("vertexShader.vs", "fragShader.fs");
+	printf("Shaders ready in %.2f ms\n", (ovr_GetTimeInSeconds() - shaderStart) * 1000.0);
 	createPerspectiveMatrix(perspectiveMatrix, 45.0f, 1280.0f / 800.0f, 0.1f, 1000.0f);
 
+	int mvpLocation = pv_glGetUniformLocation(program, "mvp");
+
+	//The render thread owns the OpenGL context from here on, and draws frame N-1 while frame N is built here
+	RenderState renderState = { &testWindow, &rift, &perspectiveMatrix, &viewMatrix,
+		(rift.GetMirrorMode() != MirrorNone) ? &mirrorWindow : NULL, &recorder, useRecorder ? "mirror.rgba" : NULL };
+	renderState.dismissWarning = false;
+	FramePipeline pipeline(1);
+	RenderThread renderThread;
+	testWindow.ReleaseGLContext();
+	renderThread.Start(&testWindow, &pipeline, renderFrame, &renderState);
+
 	while (1)
 	{
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		// Handles every waiting message at once rather than one per frame.
+		testWindow.PumpEvents();
+		InputSnapshot input = testWindow.GetInput();
+		if (input.closeRequested)
 		{
-			if (msg.message == WM_QUIT)
-			{
-				break;
-			}
-			else
-			{
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
-			}
+			break;
 		}
 
-		handleInput(&rift, kinect, position, rotation);
+		handleInput(input, renderState.dismissWarning, skeletons, position, rotation);
 		createLookAtMatrix(viewOffsetMatrix, position, rotation);
 
-		testWindow.MakeCurrentGLContext();
-		//Attempts to render to OculusRift
-		if (rift.StartRender())
-		{
-			//Renders left eye
-			rift.StartEyeRender(Left, viewMatrix);
-			{
-				rift.getPerspectiveMatrix(Left, perspectiveMatrix);
-				drawGLScene(program, perspectiveMatrix, viewMatrix * viewOffsetMatrix);
-			}
-			rift.EndEyeRender(Left);
-
-			//Renders right eye
-			rift.StartEyeRender(Right, viewMatrix);
-			{
-				rift.getPerspectiveMatrix(Right, perspectiveMatrix);
-				drawGLScene(program, perspectiveMatrix, viewMatrix * viewOffsetMatrix);
-			}
-			rift.EndEyeRender(Right);
-
-			//Frame buffering is not handled automatically!
-			pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
-			glDisable(GL_DEPTH_TEST);
-			rift.EndRender();
-			glEnable(GL_DEPTH_TEST);
-			glClearDepth(1);
-		}
-		//Rendering to window if OculusRift fails
-		else
-		{
-			pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
-			drawGLScene(program, perspectiveMatrix, viewMatrix);
-			testWindow.Update();
-		}
+		//Records the frame and hands it to the render thread
+		RenderCommandList* frame = pipeline.BeginFrame();
+		frame->SetViewMatrix(viewOffsetMatrix.getArray());
+		recordGLScene(frame, program, mvpLocation);
+		frame->Sort();
+		pipeline.Publish();
 	}
 
+	renderThread.Stop();
+	if (rift.isConnected())
+	{
+		//Keep the frame timing of the last few seconds around for charting
+		rift.SaveFrameRecordsCSV("frameTiming.csv");
+	}
+	testWindow.MakeCurrentGLContext();
+	recorder.Stop();
 	testWindow.destroyGLSystem();
 	testWindow.destroy();
+	if (renderState.mirrorWindow != NULL)
+	{
+		mirrorWindow.destroyGLSystem();
+		mirrorWindow.destroy();
+	}
+	delete kinect;
+	//The Oculus Rift keeps its own reference to the SDK until it is destroyed
+	ShutdownRift();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef _HMD_MANAGER_H_
+#define _HMD_MANAGER_H_
+
+#include "pv/OculusRift.h"
+#include <vector>
+
+namespace PV
+{
+	/**
+	 * Manages every head mounted display used by the application, for spectator and multi-user rigs.  Each
+	 * headset renders with its own OpenGL context, and every context after the first shares its objects with
+	 * the first one, so programs, textures and meshes created on any of them can be drawn by all of them.
+	 * The Oculus VR SDK is kept initialized for as long as the manager exists.
+	 */
+	class HmdManager
+	{
+	public:
+		/**
+		 * Creates a manager with no headsets, initializing the Oculus VR SDK.
+		 */
+		HmdManager();
+		/**
+		 * Destroys all of the headsets, newest first, and releases the Oculus VR SDK.
+		 */
+		~HmdManager();
+		/**
+		 * Gets the number of Oculus Rifts connected to the computer.
+		 * @return The number of connected headsets.
+		 */
+		const int DetectDevices() const;
+		/**
+		 * Creates an Oculus Rift for the next headset and adds it to the manager.  The OpenGL context is made
+		 * current on the calling thread while the Oculus Rift is set up.  Any context after the first is made
+		 * to share objects with the first, so it must not have created any objects of its own yet.
+		 * @param useDemoRift Creates a virtual Oculus Rift when true and there are no more connected headsets.
+		 * @param openGlContext The OpenGL context to render this headset with.
+		 * @param window The window that contains the OpenGL context.
+		 * @param deviceContext The device context that is used for the window.
+		 * @return The new Oculus Rift, or NULL if no headset could be set up.
+		 */
+		OculusRift* Add(bool useDemoRift, HGLRC openGlContext, HWND window, HDC deviceContext);
+		/**
+		 * Gets the number of headsets added to the manager.
+		 * @return The number of headsets.
+		 */
+		const unsigned int Size() const;
+		/**
+		 * Gets one of the headsets.
+		 * @param index The index of the headset, in the order they were added.
+		 * @return The Oculus Rift at the index.
+		 */
+		OculusRift* operator[](const unsigned int index) const;
+		/**
+		 * Updates the tracking data of every headset.
+		 */
+		void Update();
+		/**
+		 * Turns masking the hidden area of each eye on or off for every headset, with a single shared program.
+		 * The OpenGL context of each headset is made current while its mask is set up.
+		 * @param enabled True to mask the hidden area, false to render the whole eye.
+		 */
+		void SetHiddenAreaMask(bool enabled);
+		/**
+		 * Gets the average time a headset took to render both of its eyes over its recorded frames, which is
+		 * the cost each additional headset adds to a frame.
+		 * @param index The index of the headset.
+		 * @return The average time spent rendering both eyes per frame, in seconds.
+		 */
+		const double GetAverageRenderTime(const unsigned int index) const;
+	protected:
+		/**
+		 * The headsets, in the order they were added.
+		 */
+		std::vector<OculusRift*> rifts;
+		/**
+		 * The OpenGL contexts of the headsets, indexed the same as the headsets.
+		 */
+		std::vector<HGLRC> contexts;
+		/**
+		 * The device contexts of the headsets' windows, indexed the same as the headsets.
+		 */
+		std::vector<HDC> deviceContexts;
+		/**
+		 * The number of connected headsets already handed out to Oculus Rifts.
+		 */
+		unsigned int nextHmd;
+	};
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef _IMAGE_SOURCE_H_
+#define _IMAGE_SOURCE_H_
+
+#include <atomic>
+
+/**
+ * The alignment in bytes of the start of every image buffer and every row in it, a cache line, so rows can be
+ * read with aligned SIMD loads and two frames never share a cache line.
+ */
+#define PV_IMAGE_ALIGNMENT 64
+/**
+ * The number of frames preallocated for each image stream.  The stream itself keeps one as the newest and the
+ * producer fills one, which leaves two that readers can hold at once before new frames start being dropped.
+ */
+#define PV_IMAGE_POOL_SIZE 4
+/**
+ * The number of bits the Kinect shifts each depth value left by, making room for the player index.
+ */
+#define PV_DEPTH_SHIFT 3
+
+namespace PV
+{
+	/**
+	 * The layouts of image pixels.
+	 */
+	enum ImageFormat
+	{
+		/**
+		 * 16 bit depth in the Kinect's packed layout: the depth in millimeters shifted left by PV_DEPTH_SHIFT,
+		 * with the index of the player seen at that pixel in the low bits.  A depth of 0 means unknown.
+		 */
+		ImageDepthPacked = 0,
+		/**
+		 * 32 bit color, one byte each of blue, green, red and unused, the same as the Kinect's color stream.
+		 */
+		ImageColorBGRA = 1
+	};
+
+	class ImagePool;
+
+	/**
+	 * A frame of a depth or color stream, in a buffer preallocated by an ImagePool.  Frames are reference counted
+	 * so any number of threads can read the same frame without copying it, and the buffer is reused once the
+	 * last of them releases it with ReleaseImage.
+	 */
+	struct ImageFrame
+	{
+		/**
+		 * The pixels, aligned to PV_IMAGE_ALIGNMENT bytes.
+		 */
+		unsigned char* pixels;
+		/**
+		 * The width of the image in pixels.
+		 */
+		unsigned int width;
+		/**
+		 * The height of the image in pixels.
+		 */
+		unsigned int height;
+		/**
+		 * The number of bytes from the start of one row to the start of the next, a multiple of PV_IMAGE_ALIGNMENT.
+		 */
+		unsigned int pitch;
+		/**
+		 * The layout of the pixels.
+		 */
+		ImageFormat format;
+		/**
+		 * The time the frame was seen, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double time;
+		/**
+		 * The number of frames the stream published before this one.
+		 */
+		unsigned int frameIndex;
+		/**
+		 * The pool the frame belongs to.
+		 */
+		ImagePool* pool;
+		/**
+		 * The number of holders of the frame.  The frame is free to be refilled when this reaches 0.
+		 */
+		std::atomic<int> references;
+	};
+
+	/**
+	 * A fixed set of frames for one image stream, allocated once up front, along with the newest frame of the
+	 * stream.  A single producer thread acquires a free frame, fills it in and publishes it, while any thread
+	 * can take a reference to the newest frame without locking.  When every frame is held the producer's frame
+	 * is dropped rather than anything being allocated.
+	 */
+	class ImagePool
+	{
+	public:
+		/**
+		 * Allocates the frames of a stream.
+		 * @param format The layout of the pixels.
+		 * @param width The width of the images in pixels.
+		 * @param height The height of the images in pixels.
+		 */
+		ImagePool(ImageFormat format, unsigned int width, unsigned int height);
+		/**
+		 * Takes a free frame for the producer to fill in.
+		 * @return A frame holding one reference, or NULL if every frame is in use.
+		 */
+		ImageFrame* Acquire();
+		/**
+		 * Makes a filled in frame the newest frame of the stream, handing over the producer's reference.
+		 * @param frame The frame returned by Acquire.
+		 */
+		void Publish(ImageFrame* frame);
+		/**
+		 * Takes a reference to the newest frame of the stream.  It must be given back with ReleaseImage.
+		 * @return The newest frame, or NULL if none has been published yet.
+		 */
+		ImageFrame* AcquireLatest();
+		/**
+		 * Gives back a reference to a frame, freeing it to be refilled if it was the last.
+		 * @param frame The frame to release.
+		 */
+		void Release(ImageFrame* frame);
+		/**
+		 * Gets the number of frames the producer had to drop because every frame was in use.
+		 * @return The number of dropped frames.
+		 */
+		const unsigned int GetDroppedCount() const;
+		/**
+		 * Frees the frames.  No frame may still be held.
+		 */
+		~ImagePool();
+	protected:
+		/**
+		 * The frames.
+		 */
+		ImageFrame frames[PV_IMAGE_POOL_SIZE];
+		/**
+		 * The single allocation holding the pixels of every frame, before alignment.
+		 */
+		unsigned char* memory;
+		/**
+		 * The newest frame published, holding a reference of its own, or NULL.
+		 */
+		std::atomic<ImageFrame*> latest;
+		/**
+		 * The number of frames published.
+		 */
+		unsigned int published;
+		/**
+		 * The number of frames dropped because every frame was in use.
+		 */
+		std::atomic<unsigned int> dropped;
+	};
+
+	/**
+	 * Gives back a reference to a frame taken from an image source.
+	 * @param frame The frame to release, or NULL to do nothing.
+	 */
+	void ReleaseImage(ImageFrame* frame);
+
+	/**
+	 * The pinhole model of a depth camera, for turning depth pixels into points.
+	 */
+	struct DepthCamera
+	{
+		/**
+		 * The focal length in pixels along x and y.
+		 */
+		float focalX, focalY;
+		/**
+		 * The pixel the optical axis passes through.
+		 */
+		float centerX, centerY;
+	};
+
+	/**
+	 * Gets the camera model of a Kinect for Windows V1 depth stream at a given resolution.
+	 * @param width The width of the depth images in pixels.
+	 * @param height The height of the depth images in pixels.
+	 * @return The camera model.
+	 */
+	DepthCamera GetKinectDepthCamera(unsigned int width, unsigned int height);
+
+	/**
+	 * Turns every pixel of a depth image into a point in meters, with x to the right, y up and z away from the
+	 * camera, the same space as the Kinect's skeletons.  Points are written as separate x, y and z arrays in
+	 * row order, and pixels of unknown depth give the point (0, 0, 0).  Four pixels are converted per SIMD
+	 * instruction where the CPU supports it.
+	 * @param depth The depth image, in the ImageDepthPacked layout.
+	 * @param camera The model of the camera that saw the image.
+	 * @param x The array of width * height floats to write the x coordinates to.
+	 * @param y The array of width * height floats to write the y coordinates to.
+	 * @param z The array of width * height floats to write the z coordinates to.
+	 */
+	void DepthToPointCloud(const ImageFrame& depth, const DepthCamera& camera, float* x, float* y, float* z);
+
+	/**
+	 * Anything that produces depth and color images, such as a Kinect or a synthetic generator.  Sources produce
+	 * frames on their own threads into preallocated pools, and the newest one can be taken from any thread
+	 * without blocking or copying.
+	 */
+	class ImageSource
+	{
+	public:
+		/**
+		 * Checks whether the source is producing images.
+		 * @return Returns true if images are being produced, false otherwise.
+		 */
+		virtual const bool IsProducingImages() const = 0;
+		/**
+		 * Takes a reference to the newest image of a stream.  It must be given back with ReleaseImage, and should
+		 * not be held for long, or the source runs out of frames and drops new ones.
+		 * @param format The stream to get the image of.
+		 * @return The newest image, or NULL if the source has not produced one of that kind.
+		 */
+		virtual ImageFrame* AcquireLatestImage(ImageFormat format) = 0;
+		/**
+		 * Destroys the source.
+		 */
+		virtual ~ImageSource()
+		{
+		}
+	};
+};
+
+#endif
@@ -7,6 +7,13 @@
 #include <NuiApi.h>
 #include <NuiImageCamera.h>
 #include <NuiSensor.h>
+#include "pv/SensorCapture.h"
+#include "pv/SkeletonSource.h"
+#include "pv/SkeletonFilter.h"
+#include "pv/ImageSource.h"
+#include "Kernel/OVR_Lockless.h"
+#include <atomic>
+#include <thread>
 namespace PV
 {
 	/**
@@ -29,11 +36,34 @@ namespace PV
 		  Ready = 1
 	}KinectStatus;
 
+	/**
+	 * A set of skeletons published by the skeleton thread.
+	 */
+	struct KinectSkeletons
+	{
+		/**
+		 * The smoothed skeleton frame, holding every skeleton slot.
+		 */
+		NUI_SKELETON_FRAME frame;
+		/**
+		 * The slot of the first tracked skeleton in the frame, or -1 if nobody is tracked.
+		 */
+		int mainPerson;
+		/**
+		 * The time the frame was received, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double time;
+		/**
+		 * The number of skeleton frames received before this one, 0 if no frame has been received yet.
+		 */
+		unsigned int frameIndex;
+	};
+
 	/**
 	 * A class for connecting to and obtaining data from a Microsoft Kinect for Windows Version 1 sensor.  Using this class, you can
 	 * obtain data for the skeletal features of a person, as well as the depth and color images seen by the sensor itself.
 	 */
-	class Kinect1
+	class Kinect1 : public SkeletonSource, public ImageSource
 	{
 	public:
 		/**
@@ -65,14 +95,71 @@ namespace PV
 		const KinectStatus Status() const;
 
 		/**
-		 * Returns the person data from a Kinect sensor.
+		 * Returns the person data from a Kinect sensor.  This only copies the newest skeleton published by the
+		 * skeleton thread, so it never waits on the sensor.
+		 * @return The first tracked skeleton, or a skeleton whose tracking state is NUI_SKELETON_NOT_TRACKED
+		 * if nobody is tracked.
+		 */
+		const NUI_SKELETON_DATA getMainPerson() const;
+
+		/**
+		 * Gets the newest set of skeletons published by the skeleton thread.  This never blocks and is safe to
+		 * call from any thread.
+		 * @return The newest skeletons, with a frame index of 0 if no frame has been received yet.
+		 */
+		const KinectSkeletons GetSkeletons() const;
+
+		/**
+		 * Checks whether the skeleton thread is running, either reading from the sensor or playing a capture back.
+		 * @return Returns true if skeleton frames are being produced, false otherwise.
+		 */
+		virtual const bool IsProducing() const;
+		/**
+		 * Gets the newest skeletons in the platform independent layout.
+		 * @param frame The frame to copy the newest skeletons into.
+		 */
+		virtual void GetLatestFrame(SkeletonFrame& frame) const;
+
+		/**
+		 * Records the main person of every skeleton frame as read, before smoothing, or stops recording them.
+		 * @param recorder The recorder to add skeletons to, or NULL to stop.
+		 */
+		void SetRecorder(SensorRecorder* recorder);
+		/**
+		 * Plays skeletons back from a capture instead of reading them from the sensor, or goes back to the sensor.
+		 * This works without a sensor connected, so recorded motion can be replayed on any machine.  Replayed
+		 * skeletons are smoothed like live ones, except that NuiTransformSmooth needs a sensor.
+		 * @param replay The capture to play back, or NULL to use the sensor.
+		 */
+		void SetReplay(SensorReplay* replay);
+		/**
+		 * Smooths the skeletons with a filter on the skeleton thread instead of with NuiTransformSmooth, or goes
+		 * back to NuiTransformSmooth.  The filter must not be used by anything else while it is set.
+		 * @param filter The filter to smooth with, or NULL to use NuiTransformSmooth.
+		 */
+		void SetFilter(SkeletonFilter* filter);
+
+		/**
+		 * Checks whether the image thread is reading depth and color images from the sensor.
+		 * @return Returns true if images are being produced, false otherwise.
 		 */
-		const NUI_SKELETON_DATA getMainPerson();
+		virtual const bool IsProducingImages() const;
+		/**
+		 * Takes a reference to the newest 640x480 depth or color image read from the sensor, without copying it.
+		 * @param format ImageDepthPacked for the depth stream, or ImageColorBGRA for the color stream.
+		 * @return The newest image, which must be given back with ReleaseImage, or NULL if none has arrived yet.
+		 */
+		virtual ImageFrame* AcquireLatestImage(ImageFormat format);
+		/**
+		 * Gets the number of images dropped because readers were holding every frame of a stream.
+		 * @return The number of dropped depth and color images.
+		 */
+		const unsigned int GetDroppedImageCount() const;
 
 		/**
 		 * Destroys this instance of the Kinect for Windows V1 sensor, disconnecting it and releasing its data.
 		 */
-		~Kinect1();
+		virtual ~Kinect1();
 	protected:
 		/**
 		 * A pointer to the actual sensor itself.  This is not exposed publically for safety reasons within this class.
@@ -87,9 +174,66 @@ namespace PV
 		 */
 		HANDLE nextSkeletonEvent;
 		/**
-		 * The skeleton data that is currently be tracked.
+		 * Handles signalled when the sensor has a new depth or color image.
+		 */
+		HANDLE nextDepthEvent, nextColorEvent;
+		/**
+		 * The sensor's depth and color streams.
+		 */
+		HANDLE depthStream, colorStream;
+		/**
+		 * The newest skeletons received by the skeleton thread.  Reading it retries instead of locking if the
+		 * skeleton thread publishes a new frame in the middle of the read.
+		 */
+		OVR::LocklessUpdater<KinectSkeletons, KinectSkeletons> skeletons;
+		/**
+		 * The thread waiting on the sensor for skeleton frames and smoothing them.
+		 */
+		std::thread skeletonThread;
+		/**
+		 * The thread waiting on the sensor for depth and color images and copying them into the pools.
+		 */
+		std::thread imageThread;
+		/**
+		 * The preallocated depth images.
+		 */
+		ImagePool depthImages;
+		/**
+		 * The preallocated color images.
+		 */
+		ImagePool colorImages;
+		/**
+		 * A boolean telling the skeleton thread to keep going.
+		 */
+		std::atomic<bool> streaming;
+		/**
+		 * The recorder skeleton frames are added to, or NULL.
+		 */
+		std::atomic<SensorRecorder*> recorder;
+		/**
+		 * The capture skeletons are played back from, or NULL to read them from the sensor.
+		 */
+		std::atomic<SensorReplay*> replay;
+		/**
+		 * The filter the skeletons are smoothed with, or NULL to use NuiTransformSmooth.
+		 */
+		std::atomic<SkeletonFilter*> filter;
+
+		/**
+		 * The body of the skeleton thread.
+		 */
+		void runSkeletons();
+		/**
+		 * The body of the image thread.
+		 */
+		void runImages();
+		/**
+		 * Copies the next image of a stream out of the sensor into a pooled frame and publishes it.
+		 * @param stream The stream to read.
+		 * @param event The stream's next frame event, which is reset if the image cannot be read.
+		 * @param images The pool to copy the image into.
 		 */
-		NUI_SKELETON_DATA mainSkeleton;
+		void readImage(HANDLE stream, HANDLE event, ImagePool& images);
 	};
 };
 #endif
@@ -37,8 +37,15 @@ inline void* glGetProcAddress(const char* name)
 
 #elif __linux
 #define __stdcall
-#include <GL/glx.h>
-#define glGetProcAddress(funcname) glXGetProcAddress((const GLubyte*)funcname)
+// Contexts on Linux come from EGL, which can also look up core functions, with or without an X11 display.
+#ifndef EGL_NO_X11
+#define EGL_NO_X11
+#endif
+#include <stddef.h>
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include <EGL/egl.h>
+#define glGetProcAddress(funcname) eglGetProcAddress(funcname)
 
 #elif __unix
 #define __stdcall
@@ -77,6 +84,53 @@ namespace PV
 #define PV_GL_RENDERBUFFER 0x8D41
 #define PV_GL_DEPTH_ATTACHMENT 0x8D00
 #define PV_GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define PV_GL_UNIFORM_BUFFER 0x8A11
+#define PV_GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+#define PV_GL_DYNAMIC_DRAW 0x88E8
+#define PV_GL_MAP_WRITE_BIT 0x0002
+#define PV_GL_MAP_PERSISTENT_BIT 0x0040
+#define PV_GL_MAP_COHERENT_BIT 0x0080
+#define PV_GL_DYNAMIC_STORAGE_BIT 0x0100
+#define PV_GL_SAMPLES_PASSED 0x8914
+#define PV_GL_QUERY_RESULT 0x8866
+#define PV_GL_QUERY_RESULT_AVAILABLE 0x8867
+#define PV_GL_READ_FRAMEBUFFER 0x8CA8
+#define PV_GL_DRAW_FRAMEBUFFER 0x8CA9
+#define PV_GL_PIXEL_PACK_BUFFER 0x88EB
+#define PV_GL_STREAM_READ 0x88E1
+#define PV_GL_MAP_READ_BIT 0x0001
+#define PV_GL_CONTEXT_FLAGS 0x821E
+#define PV_GL_CONTEXT_PROFILE_MASK 0x9126
+#define PV_GL_CONTEXT_CORE_PROFILE_BIT 0x00000001
+#define PV_GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#define PV_GL_CONTEXT_FLAG_NO_ERROR_BIT 0x00000008
+#define PV_GL_DEBUG_OUTPUT 0x92E0
+#define PV_GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define PV_GL_DEBUG_SEVERITY_HIGH 0x9146
+#define PV_GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define PV_GL_DEBUG_SEVERITY_LOW 0x9148
+#define PV_GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define PV_GL_DONT_CARE 0x1100
+#define PV_GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE 0x8216
+#define PV_GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE 0x8217
+#define PV_GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define PV_GL_ALREADY_SIGNALED 0x911A
+#define PV_GL_TIMEOUT_EXPIRED 0x911B
+#define PV_GL_CONDITION_SATISFIED 0x911C
+#define PV_GL_WAIT_FAILED 0x911D
+#define PV_GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define PV_GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define PV_GL_PROGRAM_BINARY_LENGTH 0x8741
+#define PV_GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define PV_GL_NUM_EXTENSIONS 0x821D
+#define PV_GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define PV_GL_COMPLETION_STATUS_KHR 0x91B1
+#define PV_GL_LOWER_LEFT 0x8CA1
+#define PV_GL_NEGATIVE_ONE_TO_ONE 0x935E
+#define PV_GL_ZERO_TO_ONE 0x935F
+#define PV_GL_CLIP_ORIGIN 0x935C
+#define PV_GL_CLIP_DEPTH_MODE 0x935D
+#define PV_GL_DEPTH_COMPONENT32F 0x8CAC
 
 /**
  * Specifies to the glCreateShader function to create a fragment shader.
@@ -254,6 +308,138 @@ typedef unsigned int(__stdcall* pv_glCheckFramebufferStatusFunction) (unsigned i
 * A function pointer for the glGenerateMipmap function.
 */
 typedef void(__stdcall* pv_glGenerateMipmapFunction) (unsigned int target);
+/**
+* A function pointer for the glBufferSubData function.
+*/
+typedef void(__stdcall* pv_glBufferSubDataFunction) (GLenum target, ptrdiff_t offset, ptrdiff_t size, const GLvoid* data);
+/**
+* A function pointer for the glDeleteBuffers function.
+*/
+typedef void(__stdcall* pv_glDeleteBuffersFunction) (GLsizei n, const GLuint* buffers);
+/**
+* A function pointer for the glBindBufferRange function.
+*/
+typedef void(__stdcall* pv_glBindBufferRangeFunction) (GLenum target, GLuint index, GLuint buffer, ptrdiff_t offset, ptrdiff_t size);
+/**
+* A function pointer for the glGetUniformBlockIndex function.
+*/
+typedef GLuint(__stdcall* pv_glGetUniformBlockIndexFunction) (GLuint program, const char* uniformBlockName);
+/**
+* A function pointer for the glUniformBlockBinding function.
+*/
+typedef void(__stdcall* pv_glUniformBlockBindingFunction) (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+/**
+* A function pointer for the glBufferStorage function.
+*/
+typedef void(__stdcall* pv_glBufferStorageFunction) (GLenum target, ptrdiff_t size, const GLvoid* data, GLbitfield flags);
+/**
+* A function pointer for the glMapBufferRange function.
+*/
+typedef void*(__stdcall* pv_glMapBufferRangeFunction) (GLenum target, ptrdiff_t offset, ptrdiff_t length, GLbitfield access);
+/**
+* A function pointer for the glUnmapBuffer function.
+*/
+typedef GLboolean(__stdcall* pv_glUnmapBufferFunction) (GLenum target);
+/**
+* A function pointer for the glDeleteProgram function.
+*/
+typedef void(__stdcall* pv_glDeleteProgramFunction) (GLuint program);
+/**
+* A function pointer for the glDeleteVertexArrays function.
+*/
+typedef void(__stdcall* pv_glDeleteVertexArraysFunction) (GLsizei n, const GLuint* arrays);
+/**
+* A function pointer for the glGenQueries function.
+*/
+typedef void(__stdcall* pv_glGenQueriesFunction) (GLsizei n, GLuint* ids);
+/**
+* A function pointer for the glDeleteQueries function.
+*/
+typedef void(__stdcall* pv_glDeleteQueriesFunction) (GLsizei n, const GLuint* ids);
+/**
+* A function pointer for the glBeginQuery function.
+*/
+typedef void(__stdcall* pv_glBeginQueryFunction) (GLenum target, GLuint id);
+/**
+* A function pointer for the glEndQuery function.
+*/
+typedef void(__stdcall* pv_glEndQueryFunction) (GLenum target);
+/**
+* A function pointer for the glGetQueryObjectuiv function.
+*/
+typedef void(__stdcall* pv_glGetQueryObjectuivFunction) (GLuint id, GLenum pname, GLuint* params);
+/**
+* A function pointer for the glBlitFramebuffer function.
+*/
+typedef void(__stdcall* pv_glBlitFramebufferFunction) (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
+/**
+* A function pointer for the glDeleteFramebuffers function.
+*/
+typedef void(__stdcall* pv_glDeleteFramebuffersFunction) (GLsizei n, const GLuint* framebuffers);
+/**
+* A function pointer for the glDeleteRenderbuffers function.
+*/
+typedef void(__stdcall* pv_glDeleteRenderbuffersFunction) (GLsizei n, const GLuint* renderbuffers);
+/**
+* The callback given messages from the driver by glDebugMessageCallback.
+*/
+typedef void(__stdcall* pv_GLDEBUGPROC) (GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+/**
+* A function pointer for the glDebugMessageCallback function.
+*/
+typedef void(__stdcall* pv_glDebugMessageCallbackFunction) (pv_GLDEBUGPROC callback, const void* userParam);
+/**
+* A function pointer for the glDebugMessageControl function.
+*/
+typedef void(__stdcall* pv_glDebugMessageControlFunction) (GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint* ids, GLboolean enabled);
+/**
+* A function pointer for the glGetFramebufferAttachmentParameteriv function.
+*/
+typedef void(__stdcall* pv_glGetFramebufferAttachmentParameterivFunction) (GLenum target, GLenum attachment, GLenum pname, GLint* params);
+/**
+* A fence placed in the command stream by glFenceSync, signaled once every command before it has finished.
+*/
+typedef struct __GLsync* pv_GLsync;
+/**
+* A function pointer for the glFenceSync function.
+*/
+typedef pv_GLsync(__stdcall* pv_glFenceSyncFunction) (GLenum condition, GLbitfield flags);
+/**
+* A function pointer for the glClientWaitSync function.
+*/
+typedef GLenum(__stdcall* pv_glClientWaitSyncFunction) (pv_GLsync sync, GLbitfield flags, unsigned long long timeout);
+/**
+* A function pointer for the glDeleteSync function.
+*/
+typedef void(__stdcall* pv_glDeleteSyncFunction) (pv_GLsync sync);
+/**
+* A function pointer for the glDetachShader function.
+*/
+typedef void(__stdcall* pv_glDetachShaderFunction) (GLuint program, GLuint shader);
+/**
+* A function pointer for the glGetProgramBinary function.
+*/
+typedef void(__stdcall* pv_glGetProgramBinaryFunction) (GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+/**
+* A function pointer for the glProgramBinary function.
+*/
+typedef void(__stdcall* pv_glProgramBinaryFunction) (GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+/**
+* A function pointer for the glProgramParameteri function.
+*/
+typedef void(__stdcall* pv_glProgramParameteriFunction) (GLuint program, GLenum pname, GLint value);
+/**
+* A function pointer for the glGetStringi function.
+*/
+typedef const GLubyte*(__stdcall* pv_glGetStringiFunction) (GLenum name, GLuint index);
+/**
+* A function pointer for the glMaxShaderCompilerThreadsKHR function.
+*/
+typedef void(__stdcall* pv_glMaxShaderCompilerThreadsKHRFunction) (GLuint count);
+/**
+* A function pointer for the glClipControl function.
+*/
+typedef void(__stdcall* pv_glClipControlFunction) (GLenum origin, GLenum depth);
 
 	/**
 	 * The OpenGL method "glCreateShader", to be grabbed as an OpenGL extension.
@@ -595,6 +781,37 @@ typedef void(__stdcall* pv_glGenerateMipmapFunction) (unsigned int target);
 	extern pv_glFramebufferRenderbufferFunction pv_glFramebufferRenderbuffer;
 	extern pv_glCheckFramebufferStatusFunction pv_glCheckFramebufferStatus;
 	extern pv_glGenerateMipmapFunction pv_glGenerateMipmap;
+	extern pv_glBufferSubDataFunction pv_glBufferSubData;
+	extern pv_glDeleteBuffersFunction pv_glDeleteBuffers;
+	extern pv_glBindBufferRangeFunction pv_glBindBufferRange;
+	extern pv_glGetUniformBlockIndexFunction pv_glGetUniformBlockIndex;
+	extern pv_glUniformBlockBindingFunction pv_glUniformBlockBinding;
+	extern pv_glBufferStorageFunction pv_glBufferStorage;
+	extern pv_glMapBufferRangeFunction pv_glMapBufferRange;
+	extern pv_glUnmapBufferFunction pv_glUnmapBuffer;
+	extern pv_glDeleteProgramFunction pv_glDeleteProgram;
+	extern pv_glDeleteVertexArraysFunction pv_glDeleteVertexArrays;
+	extern pv_glGenQueriesFunction pv_glGenQueries;
+	extern pv_glDeleteQueriesFunction pv_glDeleteQueries;
+	extern pv_glBeginQueryFunction pv_glBeginQuery;
+	extern pv_glEndQueryFunction pv_glEndQuery;
+	extern pv_glGetQueryObjectuivFunction pv_glGetQueryObjectuiv;
+	extern pv_glBlitFramebufferFunction pv_glBlitFramebuffer;
+	extern pv_glDeleteFramebuffersFunction pv_glDeleteFramebuffers;
+	extern pv_glDeleteRenderbuffersFunction pv_glDeleteRenderbuffers;
+	extern pv_glDebugMessageCallbackFunction pv_glDebugMessageCallback;
+	extern pv_glDebugMessageControlFunction pv_glDebugMessageControl;
+	extern pv_glGetFramebufferAttachmentParameterivFunction pv_glGetFramebufferAttachmentParameteriv;
+	extern pv_glFenceSyncFunction pv_glFenceSync;
+	extern pv_glClientWaitSyncFunction pv_glClientWaitSync;
+	extern pv_glDeleteSyncFunction pv_glDeleteSync;
+	extern pv_glDetachShaderFunction pv_glDetachShader;
+	extern pv_glGetProgramBinaryFunction pv_glGetProgramBinary;
+	extern pv_glProgramBinaryFunction pv_glProgramBinary;
+	extern pv_glProgramParameteriFunction pv_glProgramParameteri;
+	extern pv_glGetStringiFunction pv_glGetStringi;
+	extern pv_glMaxShaderCompilerThreadsKHRFunction pv_glMaxShaderCompilerThreadsKHR;
+	extern pv_glClipControlFunction pv_glClipControl;
 
 	/**
 	 * Initializes the minimum required OpenGL functions for use with Project Virtua.  All of these methods are prefixed with pv_ in order
@@ -2,19 +2,139 @@
 
 #include "pv/types.h"
 #include "pv/Matrices.h"
+#include "pv/PoseTrajectory.h"
+#include "pv/SensorCapture.h"
+#include "pv/TrackedPose.h"
 #include "OVR_CAPI_GL.h"
+#include "Kernel/OVR_Lockless.h"
+#include <vector>
+#include <atomic>
+#include <thread>
+
+/**
+ * The uniform buffer binding point that the late-latched eye view matrix is bound to.
+ */
+#define PV_EYE_VIEW_BINDING 1
+/**
+ * The number of frames worth of eye view matrices kept in the late-latch buffer, so that
+ * the CPU never writes into a frame the GPU is still reading from.
+ */
+#define PV_EYE_VIEW_FRAMES 3
+/**
+ * The number of frame records kept by the Oculus Rift before the oldest ones are overwritten.
+ */
+#define PV_FRAME_RECORDS 512
+/**
+ * The number of occlusion queries cycled through per eye when counting shaded samples, so that reading
+ * a query's result never waits on the GPU.
+ */
+#define PV_SAMPLE_QUERIES 3
+/**
+ * The most regions an eye is split into when rendering at multiple resolutions: the center, and the bands
+ * below, above, left and right of it.
+ */
+#define PV_EYE_REGIONS 5
+/**
+ * The distance in meters of the near and far planes of the eyes' projections.  Reverse depth has no far plane.
+ */
+#define PV_RIFT_NEAR_PLANE 0.01f
+#define PV_RIFT_FAR_PLANE 10000.0f
 
 namespace PV
 {
 	/**
-	* Initializes the Oculus VR SDK.
+	 * The timing of a single frame rendered to the Oculus Rift.  All times are absolute, in seconds, on the same
+	 * clock as ovr_GetTimeInSeconds.
+	 */
+	struct FrameRecord
+	{
+		/**
+		 * The index of the frame.
+		 */
+		unsigned int frameIndex;
+		/**
+		 * The time StartRender was called.
+		 */
+		double beginTime;
+		/**
+		 * The time the frame was handed to the SDK for distortion, right before ovrHmd_EndFrame.
+		 */
+		double submitTime;
+		/**
+		 * The time ovrHmd_EndFrame returned.
+		 */
+		double endTime;
+		/**
+		 * The time the middle of the frame was predicted to be displayed at.  The difference between this and
+		 * the begin time is how far ahead the poses were predicted.
+		 */
+		double predictedDisplayTime;
+		/**
+		 * The time the CPU spent between StartEyeRender and EndEyeRender for each eye, indexed by ovrEyeType.
+		 */
+		double eyeRenderDuration[2];
+		/**
+		 * How long the SDK waited for the timewarp point before distorting the frame.  Zero means the frame was
+		 * submitted too late to wait at all.
+		 */
+		double timewarpWait;
+		/**
+		 * The most recent count of samples shaded for each eye when the frame ended, indexed by ovrEyeType.  These
+		 * lag a few frames behind, see OculusRift::GetShadedSamples.
+		 */
+		unsigned int shadedSamples[2];
+		/**
+		 * A boolean indicating whether the frame took more than one vsync interval, and so missed vsync.
+		 */
+		bool missedVsync;
+	};
+
+	/**
+	* Initializes the Oculus VR SDK.  Every call must be matched by a call to ShutdownRift, and the SDK is only
+	* shut down once the last one is made, so any number of Oculus Rifts can be created and destroyed in between.
+	* @return Returns true if the SDK is initialized, false otherwise.
 	*/
 	bool InitRift();
+	/**
+	 * Releases a reference to the Oculus VR SDK taken by InitRift, shutting it down once nothing uses it.
+	 */
+	void ShutdownRift();
 	/**
 	 * Checks to see if there is an Oculus Rift available.
 	 */
 	bool DetectDevice();
 
+	/**
+	 * A part of an eye's viewport rendered separately when rendering at multiple resolutions.  Positions and
+	 * sizes are in pixels of the eye's texture.
+	 */
+	struct EyeRegion
+	{
+		/**
+		 * The area of the eye's texture the region covers.
+		 */
+		int x, y, width, height;
+		/**
+		 * The area the region is rendered to in the reduced density texture, if it is reduced.
+		 */
+		int reducedX, reducedY, reducedWidth, reducedHeight;
+		/**
+		 * A boolean indicating whether the region is rendered at reduced density or straight into the eye's texture.
+		 */
+		bool reduced;
+	};
+
+	/**
+	 * What the Oculus Rift shows when mirroring its output to a desktop window.
+	 */
+	enum MirrorMode
+	{
+		MirrorNone = 0,
+		MirrorLeftEye = 1,
+		MirrorRightEye = 2,
+		MirrorBothEyes = 3
+	};
+
 	/**
 	 * A class for managing any Oculus Rift devices connected to the computer.  This structure can be used
 	 * to get various properties of the Oculus Rift, such as the head rotation, as well as to warp the output
@@ -29,20 +149,34 @@ namespace PV
 		 * This constructor will automatically attempt to initialize and setup an
 		 * Oculus Rift device that is connected to the computer.  Use the IsConnected
 		 * method to see if the device was successfully setup.
+		 *
+		 * When no Oculus Rift is found and useDemoRift is true, a virtual DK1 is created instead.  It goes
+		 * through the same eye rendering and distortion as real hardware, with its poses coming from
+		 * the virtual trajectory (see GetVirtualTrajectory).
 		 * @param useDemoRift Class creates a virtual Oculus Rift when true.
 		 * @param openGlContext The OpenGL context to use for rendering the final scene to.
 		 * @param window The window that contains the OpenGL context.
 		 * @param deviceContext The device context that is used for the window.
 		 */
 		OculusRift(bool useDemoRift, HGLRC openGlContext, HWND window, HDC deviceContext);
+		/**
+		 * Constructor used to create a new Oculus Rift device for one of several headsets connected to the computer.
+		 * @param hmdIndex The index of the headset to use, from 0 up to the number ovrHmd_Detect reports.
+		 * @param useDemoRift Class creates a virtual Oculus Rift when true and there is no headset at the index.
+		 * @param openGlContext The OpenGL context to use for rendering the final scene to.
+		 * @param window The window that contains the OpenGL context.
+		 * @param deviceContext The device context that is used for the window.
+		 */
+		OculusRift(unsigned int hmdIndex, bool useDemoRift, HGLRC openGlContext, HWND window, HDC deviceContext);
 		/**
 		 * Initializes the Oculus Rift headset.
 		 *
 		 * Connects to the Oculus Rift hardware. Then retrieves the sensor as well
 		 * as a sensor fusion, both of which can be used to retrieve data from the
 		 * Oculus Rift.
+		 * @param hmdIndex The index of the headset to connect to.
 		 */
-		void Initialize();
+		void Initialize(unsigned int hmdIndex = 0);
 
 		/**
 		 * Sets up the Oculus Rift for use.
@@ -65,6 +199,41 @@ namespace PV
 		 * @return Returns true if the Oculus Rift is connected, false otherwise.
 		 */
 		const bool isConnected() const;
+		/**
+		 * Checks to see if the Oculus Rift is a virtual one rather than hardware.
+		 * @return Returns true if the Oculus Rift is virtual, false otherwise.
+		 */
+		const bool isVirtuallyConnected() const;
+
+		/**
+		 * Gets the trajectory the poses of a virtual Oculus Rift are taken from.  It is scripted by default,
+		 * and can be changed or loaded from a recording at any time.
+		 * @return The virtual Oculus Rift's trajectory.
+		 */
+		PoseTrajectory& GetVirtualTrajectory();
+		/**
+		 * Starts or stops recording the head pose once per frame, so it can later be saved and replayed on a
+		 * virtual Oculus Rift.  Starting a recording clears the previous one.
+		 * @param recording True to start recording, false to stop.
+		 */
+		void SetRecordingTrajectory(bool recording);
+		/**
+		 * Gets the head poses recorded since recording was last started.
+		 * @return The recorded trajectory.
+		 */
+		const PoseTrajectory& GetRecordedTrajectory() const;
+		/**
+		 * Records every head pose sampled, by the tracking thread when tracking and by Update otherwise, or
+		 * stops recording them.
+		 * @param recorder The recorder to add poses to, or NULL to stop.
+		 */
+		void SetRecorder(SensorRecorder* recorder);
+		/**
+		 * Plays head poses back from a capture on a virtual Oculus Rift instead of following the virtual trajectory,
+		 * or goes back to the trajectory.  The replay must outlive its use here.
+		 * @param replay The capture to play back, or NULL to use the virtual trajectory.
+		 */
+		void SetReplay(SensorReplay* replay);
 
 		/**
 		 * Updates data recieved from the Oculus Rift.  It currently pulls the change in
@@ -72,6 +241,39 @@ namespace PV
 		 */
 		void Update();
 
+		/**
+		 * Starts sampling the head pose on a background thread.  Each sample is published so that any thread can
+		 * read the freshest pose without blocking, either with GetTrackedPose or through GetRotation and Update.
+		 * The virtual trajectory must not be changed while tracking a virtual Oculus Rift.
+		 * @param rate The number of times per second to sample the head pose.
+		 */
+		void StartTracking(unsigned int rate = PV_TRACKING_RATE);
+		/**
+		 * Stops the tracking thread and waits for it to finish.
+		 */
+		void StopTracking();
+		/**
+		 * Checks whether the tracking thread is running.
+		 * @return Returns true if the head pose is being sampled in the background, false otherwise.
+		 */
+		const bool IsTracking() const;
+		/**
+		 * Gets the newest head pose published by the tracking thread.  This never blocks and is safe to call from
+		 * any thread, including while the tracking thread is publishing.
+		 * @return The newest tracked pose, with a sample index of 0 if tracking has not published one yet.
+		 */
+		const TrackedPose GetTrackedPose() const;
+		/**
+		 * Gets the number of head poses the tracking thread has published since it was started.
+		 * @return The number of published poses.
+		 */
+		const unsigned int GetTrackingSampleCount() const;
+		/**
+		 * Gets the number of head poses the tracking thread published per second, measured since it was started.
+		 * @return The achieved sampling rate in samples per second.
+		 */
+		const double GetTrackingRate() const;
+
 		/**
 		 * Dismisses the warning screen shown when the application starts on the Oculus Rift.
 		 */
@@ -94,9 +296,185 @@ namespace PV
 		void EndEyeRender(RiftEye eye);
 		/**
 		 * Ends rendering the scene for the Oculus Rift, calling the updates to swap the window's buffers as well.
+		 * When late-latching is enabled, the eye poses are sampled here and written to the eye view buffer
+		 * right before the frame is submitted, and the same poses are handed to timewarp.
 		 */
 		void EndRender();
 
+		/**
+		 * Enables or disables late-latching of the eye poses.  While enabled, StartEyeRender hands back an
+		 * identity view matrix and the real eye view matrix is read by the shaders from a uniform block:
+		 *
+		 *     layout(std140) uniform PVEyeView { mat4 eyeView; };
+		 *
+		 * The block is filled in EndRender with the poses predicted for scan-out, as late as possible.  This
+		 * needs a persistently mapped buffer (GL 4.4 or ARB_buffer_storage); without one the pose is written
+		 * in StartEyeRender instead, which matches the non-late-latched timing.
+		 * @param enabled True to enable late-latching, false to sample the poses in StartEyeRender.
+		 */
+		void SetLateLatching(bool enabled);
+		/**
+		 * Checks whether the eye poses are being late-latched.
+		 * @return Returns true if late-latching is enabled, false otherwise.
+		 */
+		const bool IsLateLatching() const;
+		/**
+		 * Binds the PVEyeView uniform block of a program to the eye view buffer.  This only needs to be
+		 * called once per program after it is linked.
+		 * @param program The program to bind the eye view block for.
+		 */
+		void BindEyeViewBlock(unsigned int program);
+
+		/**
+		 * Enables or disables masking of the hidden area of each eye.  The hidden area is the part of an eye's
+		 * texture the lens distortion never samples from, worked out from the SDK's distortion mesh.  While
+		 * enabled, StartEyeRender clears the eye's depth buffer and fills the hidden area with the nearest depth,
+		 * so depth testing rejects any fragments there before they are shaded.  The application must not clear
+		 * the depth buffer after StartEyeRender while this is enabled.
+		 * @param enabled True to mask the hidden area, false to render the whole eye texture.
+		 */
+		void SetHiddenAreaMask(bool enabled);
+		/**
+		 * Checks whether the hidden area of each eye is being masked.
+		 * @return Returns true if the hidden area is masked, false otherwise.
+		 */
+		const bool IsHiddenAreaMasking() const;
+		/**
+		 * Uses the shader programs of another Oculus Rift instead of creating its own, for rigs with several
+		 * headsets.  Both Oculus Rifts' OpenGL contexts must share objects, and the other Oculus Rift must be
+		 * destroyed after this one.  Should be called before enabling any features that need the programs.
+		 * @param owner The Oculus Rift whose programs to use.
+		 */
+		void ShareResources(const OculusRift& owner);
+		/**
+		 * Gets how much of an eye's viewport is covered by its hidden area mask.
+		 * @param eye The eye to get the hidden area of.
+		 * @return The fraction of the eye's viewport which is hidden, from 0 to 1.
+		 */
+		const float GetHiddenAreaFraction(RiftEye eye) const;
+		/**
+		 * Gets the number of samples that passed the depth test while rendering an eye, which is the number of
+		 * fragments shaded for it including overdraw.  The count comes from an occlusion query a few frames old.
+		 * @param eye The eye to get the sample count of.
+		 * @return The number of samples shaded for the eye, or 0 if no query has finished yet.
+		 */
+		const unsigned int GetShadedSamples(RiftEye eye) const;
+
+		/**
+		 * Enables or disables reverse depth.  While enabled, the eyes' depth buffers hold 32 bit floats, and
+		 * getPerspectiveMatrix hands back a projection with no far plane which maps the near plane to a depth of 1
+		 * and infinity to 0.  Floats are most precise close to 0, which cancels out the perspective divide crowding
+		 * distant depths together, so far away surfaces stop z-fighting.  Between StartEyeRender and EndEyeRender
+		 * the depth range is set to 0 to 1 with glClipControl, the depth test passes nearer fragments with GL_GREATER,
+		 * and the depth buffer is cleared to 0; EndEyeRender puts back whatever was set before.  This needs OpenGL
+		 * 4.5 or ARB_clip_control on the current context, and is left disabled without it.
+		 * @param enabled True to use reverse depth, false to use the default depth range and test.
+		 */
+		void SetReverseDepth(bool enabled);
+		/**
+		 * Checks whether the eyes are rendered with reverse depth.
+		 * @return Returns true if reverse depth is enabled, false otherwise.
+		 */
+		const bool IsReverseDepth() const;
+
+		/**
+		 * Enables or disables rendering the eyes at multiple resolutions.  The center of each eye, around the
+		 * lens's center, is rendered at full density, while the rest of it, which the lens distortion squeezes
+		 * together, is rendered at a lower density and scaled up into the eye's texture in EndEyeRender.  While
+		 * enabled, each eye is drawn once per region, see StartEyeRegion.
+		 * @param centerSize The size of the full density center, as a fraction of the eye's width and height.
+		 * @param peripheryDensity The density to render the rest of the eye at, as a fraction of full density.
+		 * Passing 1 for either disables multiple resolutions.
+		 */
+		void SetMultiResolution(float centerSize, float peripheryDensity);
+		/**
+		 * Checks whether the eyes are being rendered at multiple resolutions.
+		 * @return Returns true if the periphery of each eye is rendered at reduced density, false otherwise.
+		 */
+		const bool IsMultiResolution() const;
+		/**
+		 * Gets the number of regions an eye is rendered in.  This is 1 unless rendering at multiple resolutions.
+		 * @param eye The eye to get the region count of.
+		 * @return The number of regions to render the eye in.
+		 */
+		const unsigned int GetEyeRegionCount(RiftEye eye) const;
+		/**
+		 * Begins rendering one region of an eye, between StartEyeRender and EndEyeRender.  This binds the region's
+		 * target with its viewport and scissor, so clearing only affects the region, and crops the eye's perspective
+		 * to the region.  The scene should be drawn once per region.
+		 * @param eye The eye being rendered.
+		 * @param region The index of the region to render, below GetEyeRegionCount.
+		 * @param perspectiveMatrix The matrix to store the region's perspective in.
+		 */
+		void StartEyeRegion(RiftEye eye, unsigned int region, Math::Matrix<float> &perspectiveMatrix);
+		/**
+		 * Gets the number of pixels rendered for an eye as a fraction of its full viewport, which is how much of the
+		 * full density fill-rate is being used.
+		 * @param eye The eye to get the ratio for.
+		 * @return The fraction of the eye's pixels which are rendered, 1 when not rendering at multiple resolutions.
+		 */
+		const float GetRenderedPixelRatio(RiftEye eye) const;
+
+		/**
+		 * Sets what is shown when mirroring to a desktop window.
+		 * @param mode The eyes to show, or MirrorNone to turn mirroring off.
+		 * @param crop The fraction of each eye's viewport to cut off of every side, from 0 (none) to below 0.5.
+		 * The edges of the eye textures are barely visible through the lenses, so cropping them fills the
+		 * window with the part the user actually sees.
+		 */
+		void SetMirror(MirrorMode mode, float crop);
+		/**
+		 * Gets what is shown when mirroring to a desktop window.
+		 * @return The current mirror mode.
+		 */
+		const MirrorMode GetMirrorMode() const;
+		/**
+		 * Copies the eye textures of the frame just rendered into the default framebuffer of the current
+		 * OpenGL context, scaled to fit and centered.  Nothing is rendered again, so this only costs a blit.
+		 * Call it after both eyes are rendered, with the desktop window's device context current, and swap
+		 * that window's buffers afterwards.
+		 * @param width The width of the window.
+		 * @param height The height of the window.
+		 */
+		void Mirror(int width, int height);
+		/**
+		 * Gets how long the last call to Mirror took to submit on the CPU.
+		 * @return The time spent mirroring, in seconds.
+		 */
+		const double GetMirrorTime() const;
+
+		/**
+		 * Gets the number of frame records available, which is at most PV_FRAME_RECORDS.  Frame records are
+		 * written by EndRender, so they should be read on the rendering thread or while it is not rendering.
+		 * @return The number of frame records available.
+		 */
+		const unsigned int GetFrameRecordCount() const;
+		/**
+		 * Gets one of the most recent frame records.
+		 * @param index The index of the record, where 0 is the oldest available record.
+		 * @return The frame record.
+		 */
+		const FrameRecord& GetFrameRecord(unsigned int index) const;
+		/**
+		 * Gets the number of frames that missed vsync since the Oculus Rift was created.
+		 * @return The number of frames that missed vsync.
+		 */
+		const unsigned int GetMissedVsyncCount() const;
+		/**
+		 * Saves the available frame records to a file, one frame per line with a header line, as comma separated
+		 * values.  Times are written in milliseconds relative to the oldest frame's begin time.
+		 * @param fileName The name of the file to save to.
+		 * @return Returns true if the file was written, false otherwise.
+		 */
+		bool SaveFrameRecordsCSV(const char* fileName) const;
+		/**
+		 * Saves the available frame records to a file as a JSON array of objects, with the same fields and units
+		 * as SaveFrameRecordsCSV.
+		 * @param fileName The name of the file to save to.
+		 * @return Returns true if the file was written, false otherwise.
+		 */
+		bool SaveFrameRecordsJSON(const char* fileName) const;
+
 		/** 
 		 * Retrieves the perspective matrix.
 		 * @param eye The eye to retrieve the perspective for.
@@ -185,6 +563,156 @@ namespace PV
 		*/
 		unsigned int rightDepthBuffer;
 
+		/**
+		 * The index of the frame currently being rendered.
+		 */
+		unsigned int frameIndex;
+
+		/**
+		 * The most recent frame records, used as a ring buffer.
+		 */
+		FrameRecord frameRecords[PV_FRAME_RECORDS];
+		/**
+		 * The total number of frame records written, the newest one is at this index minus one (wrapped).
+		 */
+		unsigned int frameRecordsWritten;
+		/**
+		 * The record of the frame currently being rendered.
+		 */
+		FrameRecord currentFrame;
+		/**
+		 * The timing the SDK reported for the current frame when it began.
+		 */
+		ovrFrameTiming frameTiming;
+		/**
+		 * The time each eye started rendering in the current frame, indexed by ovrEyeType.
+		 */
+		double eyeRenderStartTime[2];
+		/**
+		 * The number of frames that missed vsync.
+		 */
+		unsigned int missedVsyncCount;
+
+		/**
+		 * A boolean indicating whether the hidden area of each eye is masked or not.
+		 */
+		bool hiddenAreaMasking;
+		/**
+		 * The shader program used to draw the hidden area masks.
+		 */
+		unsigned int hiddenAreaProgram;
+		/**
+		 * The location of the hidden area program's uniform holding the depth of the near plane.
+		 */
+		int hiddenAreaDepthLocation;
+		/**
+		 * A boolean indicating whether the hidden area program was created by this Oculus Rift or shared with it.
+		 */
+		bool ownsHiddenAreaProgram;
+		/**
+		 * The vertex arrays of the hidden area masks, indexed by ovrEyeType.
+		 */
+		unsigned int hiddenAreaVertexArrays[2];
+		/**
+		 * The vertex buffers of the hidden area masks, indexed by ovrEyeType.
+		 */
+		unsigned int hiddenAreaBuffers[2];
+		/**
+		 * The number of vertices in each hidden area mask, indexed by ovrEyeType.
+		 */
+		unsigned int hiddenAreaVertexCounts[2];
+		/**
+		 * The fraction of each eye's viewport covered by its hidden area mask, indexed by ovrEyeType.
+		 */
+		float hiddenAreaFractions[2];
+		/**
+		 * The occlusion queries counting the samples shaded for each eye, indexed by ovrEyeType.
+		 */
+		unsigned int sampleQueries[2][PV_SAMPLE_QUERIES];
+		/**
+		 * The most recent number of samples shaded for each eye, indexed by ovrEyeType.
+		 */
+		unsigned int shadedSamples[2];
+
+		/**
+		 * A boolean indicating whether the eyes are rendered at multiple resolutions.
+		 */
+		bool multiResolution;
+		/**
+		 * The size of the full density center of each eye, as a fraction of the eye's width and height.
+		 */
+		float centerSize;
+		/**
+		 * The density the periphery of each eye is rendered at.
+		 */
+		float peripheryDensity;
+		/**
+		 * The regions each eye is rendered in, indexed by ovrEyeType.
+		 */
+		EyeRegion eyeRegions[2][PV_EYE_REGIONS];
+		/**
+		 * The number of regions each eye is rendered in, indexed by ovrEyeType.
+		 */
+		unsigned int eyeRegionCounts[2];
+		/**
+		 * The textures the reduced density regions of each eye are rendered to, indexed by ovrEyeType.
+		 */
+		unsigned int peripheryTextures[2];
+		/**
+		 * The frame buffers the reduced density regions of each eye are rendered to, indexed by ovrEyeType.
+		 */
+		unsigned int peripheryFrameBuffers[2];
+		/**
+		 * The depth buffers of the reduced density regions of each eye, indexed by ovrEyeType.
+		 */
+		unsigned int peripheryDepthBuffers[2];
+		/**
+		 * A boolean indicating whether the eyes are rendered with reverse depth.
+		 */
+		bool reverseDepth;
+		/**
+		 * The clip origin and depth mode, depth test and depth clear value set before StartEyeRender switched to
+		 * reverse depth, which EndEyeRender puts back.
+		 */
+		int savedClipOrigin;
+		int savedClipDepthMode;
+		int savedDepthFunction;
+		float savedClearDepth;
+
+		/**
+		 * What is shown when mirroring to a desktop window.
+		 */
+		MirrorMode mirrorMode;
+		/**
+		 * The fraction of each eye's viewport cut off of every side when mirroring.
+		 */
+		float mirrorCrop;
+		/**
+		 * How long the last mirror took to submit, in seconds.
+		 */
+		double mirrorTime;
+
+		/**
+		 * A boolean indicating whether the eye poses are late-latched or not.
+		 */
+		bool lateLatching;
+		/**
+		 * The uniform buffer holding the eye view matrices for the last few frames.
+		 */
+		unsigned int eyeViewBuffer;
+		/**
+		 * The persistently mapped memory of the eye view buffer, or NULL if it could not be mapped.
+		 */
+		unsigned char* eyeViewBufferData;
+		/**
+		 * The distance in bytes between two eye view matrices in the eye view buffer.
+		 */
+		unsigned int eyeViewBufferStride;
+		/**
+		 * Scratch matrix used when building the view matrices written to the eye view buffer.
+		 */
+		Math::Matrix<float> eyeViewMatrix;
+
 		/**
 		  * A boolean indicating whether an oculus rift is connected or not.
 		  */
@@ -195,6 +723,57 @@ namespace PV
 		*/
 		bool virtuallyConnected;
 
+		/**
+		 * The trajectory the poses of a virtual Oculus Rift follow.
+		 */
+		PoseTrajectory virtualTrajectory;
+		/**
+		 * The time the virtual Oculus Rift was created, which is the start of its trajectory.
+		 */
+		double virtualStartTime;
+		/**
+		 * The head poses recorded while recording is enabled.
+		 */
+		PoseTrajectory recordedTrajectory;
+		/**
+		 * A boolean indicating whether the head poses are being recorded.
+		 */
+		bool recordingTrajectory;
+		/**
+		 * The recorder head poses are added to, or NULL.
+		 */
+		std::atomic<SensorRecorder*> recorder;
+		/**
+		 * The capture a virtual Oculus Rift plays back, or NULL to follow the virtual trajectory.
+		 */
+		std::atomic<SensorReplay*> replay;
+
+		/**
+		 * The newest pose sampled by the tracking thread.  Reading it retries instead of locking if the tracking
+		 * thread publishes a new pose in the middle of the read.
+		 */
+		OVR::LocklessUpdater<TrackedPose, TrackedPose> trackedPose;
+		/**
+		 * The thread sampling the head pose.
+		 */
+		std::thread trackingThread;
+		/**
+		 * A boolean telling the tracking thread to keep going.
+		 */
+		std::atomic<bool> tracking;
+		/**
+		 * The number of poses published by the tracking thread since it was started.
+		 */
+		std::atomic<unsigned int> trackingSamples;
+		/**
+		 * The number of times per second the tracking thread samples the head pose.
+		 */
+		unsigned int trackingRate;
+		/**
+		 * The time the tracking thread was started.
+		 */
+		double trackingStartTime;
+
 		/**
 		  * The orientation of the oculus rift. (yaw, pitch, roll)
 		  */
@@ -208,5 +787,73 @@ namespace PV
 		 * Sets up the frame buffers for the left and right eyes.
 		 */
 		void setupFrameBuffer();
+		/**
+		 * Creates the frame buffers the reduced density regions of each eye are rendered to.
+		 */
+		void setupPeripheryBuffers();
+		/**
+		 * Gives every depth buffer of the eyes storage in the format for the current depth mode.
+		 */
+		void allocateDepthBuffers();
+		/**
+		 * Splits each eye's viewport into the regions it is rendered in.
+		 */
+		void updateEyeRegions();
+		/**
+		 * Creates the occlusion queries used to count the samples shaded for each eye.
+		 */
+		void setupSampleQueries();
+		/**
+		 * Creates the shader program and the meshes used to mask the hidden area of each eye.
+		 */
+		void setupHiddenArea();
+		/**
+		 * Builds the hidden area mask of an eye from the outer edge of its distortion mesh.
+		 * @param eye The eye to build the mask for.
+		 * @param vertices The list to store the mask's triangles into, as x and y pairs in the eye viewport's
+		 * normalized device coordinates.
+		 */
+		void buildHiddenAreaMesh(ovrEyeType eye, std::vector<float> &vertices);
+		/**
+		 * Clears the depth buffer and draws the hidden area mask of an eye into it.
+		 * @param eye The eye to draw the mask for.
+		 */
+		void drawHiddenArea(ovrEyeType eye);
+		/**
+		 * Creates the uniform buffer used to hold the late-latched eye view matrices.
+		 */
+		void setupEyeViewBuffer();
+		/**
+		 * Finishes the record of the current frame and adds it to the frame records.
+		 */
+		void recordFrame();
+		/**
+		 * The body of the tracking thread.
+		 */
+		void runTracking();
+		/**
+		 * Gets the pose of an eye predicted for when it is scanned out, from the sensors or from the virtual trajectory.
+		 * @param eye The eye to get the pose of.
+		 * @return The predicted pose of the eye.
+		 */
+		ovrPosef getEyePose(ovrEyeType eye);
+		/**
+		 * Gets the pose of a virtual Oculus Rift at a time, from the replay if there is one and from the virtual
+		 * trajectory otherwise.
+		 * @param time The time to get the pose at, on the same clock as ovr_GetTimeInSeconds.
+		 * @return The head pose at that time.
+		 */
+		ovrPosef getVirtualPose(double time) const;
+		/**
+		 * Builds the view matrix for an eye from its current pose and updates the orientation with it.
+		 * @param eye The eye to build the view matrix for.
+		 * @param viewMatrix The matrix to store the view into.
+		 */
+		void getEyeViewMatrix(ovrEyeType eye, Math::Matrix<float> &viewMatrix);
+		/**
+		 * Writes the view matrix for an eye into the slot of the current frame in the eye view buffer.
+		 * @param eye The eye to write the view matrix for.
+		 */
+		void writeEyeView(ovrEyeType eye);
 	};
 };
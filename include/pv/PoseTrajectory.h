@@ -0,0 +1,92 @@
+#ifndef _POSE_TRAJECTORY_H_
+#define _POSE_TRAJECTORY_H_
+
+#include "pv/types.h"
+#include <vector>
+
+namespace PV
+{
+	/**
+	 * A head pose trajectory used to drive a virtual Oculus Rift.  A trajectory is either scripted, in which case
+	 * the head sweeps smoothly side to side and up and down, or recorded, in which case it plays back a list of
+	 * timestamped poses (looping once it reaches the end).  Recorded trajectories can be captured from a real
+	 * Oculus Rift and saved to a file, so the same motion can be replayed on machines without a headset.
+	 */
+	class PoseTrajectory
+	{
+	public:
+		/**
+		 * Creates a scripted trajectory with the default sweep.
+		 */
+		PoseTrajectory();
+		/**
+		 * Clears any recorded poses and switches to a scripted trajectory.
+		 * @param yawAmplitude How far the head turns to each side, in radians.
+		 * @param pitchAmplitude How far the head looks up and down, in radians.
+		 * @param period The number of seconds it takes to complete a full side to side sweep.
+		 */
+		void SetScripted(float yawAmplitude, float pitchAmplitude, float period);
+		/**
+		 * Adds a recorded pose to the end of the trajectory.  Poses must be added in order of time.
+		 * @param time The time of the pose in seconds.
+		 * @param pose The head pose at that time.
+		 */
+		void AddPose(double time, const ovrPosef& pose);
+		/**
+		 * Removes all of the recorded poses, making the trajectory scripted again.
+		 */
+		void Clear();
+		/**
+		 * Loads a recorded trajectory from a file written by Save.
+		 * @param fileName The name of the file to load.
+		 * @return Returns true if at least one pose was loaded, false otherwise.
+		 */
+		bool Load(const char* fileName);
+		/**
+		 * Saves the recorded poses to a file.  Each line holds the time, the orientation quaternion (x, y, z, w)
+		 * and the position (x, y, z) of a pose, separated by spaces.
+		 * @param fileName The name of the file to save to.
+		 * @return Returns true if the file was written, false otherwise.
+		 */
+		bool Save(const char* fileName) const;
+		/**
+		 * Checks whether the trajectory is scripted or recorded.
+		 * @return Returns true if there are no recorded poses, false otherwise.
+		 */
+		const bool IsScripted() const;
+		/**
+		 * Gets the number of recorded poses.
+		 * @return The number of recorded poses.
+		 */
+		const unsigned int Size() const;
+		/**
+		 * Gets the head pose at a specific time along the trajectory.  Recorded poses are interpolated between.
+		 * @param time The time in seconds since the start of the trajectory.
+		 * @return The head pose at that time.
+		 */
+		ovrPosef Sample(double time) const;
+	protected:
+		/**
+		 * The times of the recorded poses, in seconds.
+		 */
+		std::vector<double> times;
+		/**
+		 * The recorded poses.
+		 */
+		std::vector<ovrPosef> poses;
+		/**
+		 * How far the scripted head turns to each side, in radians.
+		 */
+		float yawAmplitude;
+		/**
+		 * How far the scripted head looks up and down, in radians.
+		 */
+		float pitchAmplitude;
+		/**
+		 * The number of seconds for a full scripted side to side sweep.
+		 */
+		float period;
+	};
+};
+
+#endif
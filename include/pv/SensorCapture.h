@@ -0,0 +1,275 @@
+#ifndef _SENSOR_CAPTURE_H_
+#define _SENSOR_CAPTURE_H_
+
+#include "pv/types.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace PV
+{
+	/**
+	 * The number of joints in a captured skeleton, the same as a Kinect for Windows V1 skeleton.
+	 */
+#define PV_CAPTURE_JOINTS 20
+	/**
+	 * The number of samples of each kind that can wait to be written before new ones are dropped.
+	 */
+#define PV_CAPTURE_QUEUE 256
+	/**
+	 * The version of the capture format written by SensorRecorder.
+	 */
+#define PV_CAPTURE_VERSION 1
+
+	/**
+	 * A skeleton as stored in a sensor capture.
+	 */
+	struct CapturedSkeleton
+	{
+		/**
+		 * The time of the skeleton in seconds since the capture started.
+		 */
+		double time;
+		/**
+		 * A boolean indicating whether anybody was tracked.  The joints are only meaningful when this is true.
+		 */
+		bool tracked;
+		/**
+		 * The position of each joint in meters (x, y, z), in the sensor's skeleton space.
+		 */
+		float joints[PV_CAPTURE_JOINTS][3];
+		/**
+		 * The tracking state of each joint, 0 for not tracked, 1 for inferred and 2 for tracked.
+		 */
+		unsigned char jointStates[PV_CAPTURE_JOINTS];
+	};
+
+	/**
+	 * A head pose as stored in a sensor capture.
+	 */
+	struct CapturedPose
+	{
+		/**
+		 * The time of the pose in seconds since the capture started.
+		 */
+		double time;
+		/**
+		 * The orientation and position of the head.
+		 */
+		ovrPosef pose;
+	};
+
+	/**
+	 * Records skeletons and head poses to a compact binary file on a background thread.  The sensor threads
+	 * only copy each sample into a queue, and the recorder's thread encodes and writes them, so recording never
+	 * slows the sensors down.  One thread may add skeletons and one other thread may add poses at the same time.
+	 *
+	 * The file starts with the characters "PVSC" and the format version as a 32 bit little endian integer,
+	 * followed by records.  Each record is a type byte ('K' for a skeleton, 'H' for a head pose), the time
+	 * since the previous record of the same type in microseconds, then its values.  Positions are stored in
+	 * tenths of a millimeter and quaternions in 1/32767ths, each as the difference from the same value in the
+	 * previous record of the same type.  All numbers are zigzag encoded variable length integers, so a
+	 * still user takes only a couple of bytes per value.  A skeleton record stores a tracked byte, and if
+	 * tracked the joint states packed 2 bits per joint followed by the joint positions.
+	 */
+	class SensorRecorder
+	{
+	public:
+		/**
+		 * Creates a recorder which is not recording.
+		 */
+		SensorRecorder();
+		/**
+		 * Starts recording to a file.  Times are measured from this call.
+		 * @param fileName The name of the file to record to.
+		 * @return Returns true if recording started, false otherwise.
+		 */
+		bool Start(const char* fileName);
+		/**
+		 * Stops recording, waiting for the queued samples to be written.
+		 */
+		void Stop();
+		/**
+		 * Checks whether the recorder is recording.
+		 * @return Returns true if recording, false otherwise.
+		 */
+		const bool IsRecording() const;
+		/**
+		 * Queues a skeleton to be recorded.  Its time is replaced with the time since recording started.
+		 * @param time The time the skeleton was seen, on the same clock as ovr_GetTimeInSeconds.
+		 * @param skeleton The skeleton to record.
+		 */
+		void AddSkeleton(double time, const CapturedSkeleton& skeleton);
+		/**
+		 * Queues a head pose to be recorded.
+		 * @param time The time of the pose, on the same clock as ovr_GetTimeInSeconds.
+		 * @param pose The head pose to record.
+		 */
+		void AddPose(double time, const ovrPosef& pose);
+		/**
+		 * Gets the number of bytes written to the file so far.
+		 * @return The size of the recording in bytes.
+		 */
+		const unsigned int GetBytesWritten() const;
+		/**
+		 * Gets the number of samples dropped because the writer thread fell behind.
+		 * @return The number of samples dropped.
+		 */
+		const unsigned int GetSamplesDropped() const;
+		/**
+		 * Stops recording if it is still going.
+		 */
+		~SensorRecorder();
+	protected:
+		/**
+		 * The body of the writer thread.
+		 */
+		void run();
+
+		/**
+		 * The file being recorded to.
+		 */
+		FILE* file;
+		/**
+		 * The time recording started, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double startTime;
+		/**
+		 * The skeletons waiting to be written, used as a ring.
+		 */
+		CapturedSkeleton skeletonQueue[PV_CAPTURE_QUEUE];
+		/**
+		 * The poses waiting to be written, used as a ring.
+		 */
+		CapturedPose poseQueue[PV_CAPTURE_QUEUE];
+		/**
+		 * The number of skeletons and poses queued.  Only written by the threads adding them.
+		 */
+		std::atomic<unsigned int> skeletonsQueued, posesQueued;
+		/**
+		 * The number of skeletons and poses written.  Only written by the writer thread.
+		 */
+		std::atomic<unsigned int> skeletonsWritten, posesWritten;
+		/**
+		 * The number of samples dropped because their queue was full.
+		 */
+		std::atomic<unsigned int> samplesDropped;
+		/**
+		 * The number of bytes written to the file.
+		 */
+		std::atomic<unsigned int> bytesWritten;
+		/**
+		 * The thread encoding and writing the samples.
+		 */
+		std::thread thread;
+		/**
+		 * A boolean telling the writer thread to keep going.
+		 */
+		std::atomic<bool> recording;
+	};
+
+	/**
+	 * Plays back a file written by SensorRecorder.  The whole file is decoded when loaded, so looking up a sample
+	 * during playback never touches the disk.  Playback runs on the same clock as ovr_GetTimeInSeconds at any
+	 * speed, or can be pinned to a specific time so that benchmark runs see exactly the same input every time.
+	 */
+	class SensorReplay
+	{
+	public:
+		/**
+		 * Creates an empty replay.
+		 */
+		SensorReplay();
+		/**
+		 * Loads and decodes a capture file.
+		 * @param fileName The name of the file to load.
+		 * @return Returns true if the file was a valid capture, false otherwise.
+		 */
+		bool Load(const char* fileName);
+		/**
+		 * Starts playing back from the beginning.
+		 * @param speed How fast to play back, 1 for real time and higher to play back faster.
+		 */
+		void Start(double speed = 1.0);
+		/**
+		 * Stops the playback clock at a specific time, until Start is called again.
+		 * @param time The time in seconds since the start of the capture.
+		 */
+		void SetTime(double time);
+		/**
+		 * Gets the playback time at a time on the same clock as ovr_GetTimeInSeconds, which can be in the future
+		 * when predicting.
+		 * @param clockTime The time to convert.
+		 * @return The time in seconds since the start of the capture.
+		 */
+		const double GetTimeAt(double clockTime) const;
+		/**
+		 * Gets the current playback time.
+		 * @return The time in seconds since the start of the capture.
+		 */
+		const double GetTime() const;
+		/**
+		 * Gets the length of the capture.
+		 * @return The time of the last sample in seconds.
+		 */
+		const double GetDuration() const;
+		/**
+		 * Finds the newest skeleton at or before a time.
+		 * @param time The time in seconds since the start of the capture.
+		 * @return The index of the skeleton, or -1 if there is none that early.
+		 */
+		const int FindSkeleton(double time) const;
+		/**
+		 * Finds the newest head pose at or before a time.
+		 * @param time The time in seconds since the start of the capture.
+		 * @return The index of the pose, or -1 if there is none that early.
+		 */
+		const int FindPose(double time) const;
+		/**
+		 * Gets a decoded skeleton.
+		 * @param index The index of the skeleton.
+		 * @return The skeleton at the index.
+		 */
+		const CapturedSkeleton& GetSkeleton(unsigned int index) const;
+		/**
+		 * Gets a decoded head pose.
+		 * @param index The index of the pose.
+		 * @return The pose at the index.
+		 */
+		const CapturedPose& GetPose(unsigned int index) const;
+		/**
+		 * Gets the number of skeletons in the capture.
+		 * @return The number of skeletons.
+		 */
+		const unsigned int SkeletonCount() const;
+		/**
+		 * Gets the number of head poses in the capture.
+		 * @return The number of poses.
+		 */
+		const unsigned int PoseCount() const;
+	protected:
+		/**
+		 * The decoded skeletons, in order of time.
+		 */
+		std::vector<CapturedSkeleton> skeletons;
+		/**
+		 * The decoded head poses, in order of time.
+		 */
+		std::vector<CapturedPose> poses;
+		/**
+		 * The clock time playback started at.
+		 */
+		double startTime;
+		/**
+		 * The playback time when playback started, or the pinned time when the speed is 0.
+		 */
+		double startPlaybackTime;
+		/**
+		 * How fast the capture is played back, 0 when pinned to a time.
+		 */
+		double speed;
+	};
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef _SKELETON_FILTER_H_
+#define _SKELETON_FILTER_H_
+
+#include "pv/SkeletonSource.h"
+
+namespace PV
+{
+	/**
+	 * The kinds of filter a SkeletonFilter can smooth joints with.
+	 */
+	enum SkeletonFilterType
+	{
+		/**
+		 * The joints are passed through untouched.
+		 */
+		FilterNone = 0,
+		/**
+		 * Holt double exponential smoothing, which tracks each joint's position and velocity and can predict
+		 * slightly ahead to hide its own lag.  This is the same kind of filter as NuiTransformSmooth.
+		 */
+		FilterHolt = 1,
+		/**
+		 * The One Euro filter, a low pass filter whose cutoff rises with the joint's speed, so that still joints
+		 * are smoothed heavily while fast moving joints barely lag.
+		 */
+		FilterOneEuro = 2
+	};
+
+	/**
+	 * Smooths the joints of every tracked person in skeleton frames.  Each filter runs on all 20 joints of a person
+	 * at once, four joints per SIMD instruction where the CPU supports it, and its parameters can be set for
+	 * each joint separately, such as smoothing the hands less than the hips.  A filter keeps state between
+	 * frames, so it must only be used by one thread and fed frames from one source in order.
+	 */
+	class SkeletonFilter
+	{
+	public:
+		/**
+		 * Creates a Holt filter with the same settings as the Kinect's very smooth parameters.
+		 */
+		SkeletonFilter();
+		/**
+		 * Sets the kind of filter to use, and forgets everything filtered so far.
+		 * @param type The kind of filter.
+		 */
+		void SetType(SkeletonFilterType type);
+		/**
+		 * Gets the kind of filter being used.
+		 * @return The kind of filter.
+		 */
+		const SkeletonFilterType GetType() const;
+		/**
+		 * Sets the parameters of the Holt filter for a joint.
+		 * @param joint The joint to set the parameters of, or -1 for every joint.
+		 * @param smoothing How much to smooth the position, from 0 (none) to below 1.
+		 * @param correction How quickly the velocity follows changes, from 0 to 1.
+		 * @param prediction How many frames ahead to predict the position.
+		 */
+		void SetHoltParameters(int joint, float smoothing, float correction, float prediction);
+		/**
+		 * Sets the parameters of the One Euro filter for a joint.
+		 * @param joint The joint to set the parameters of, or -1 for every joint.
+		 * @param minimumCutoff The cutoff frequency in hertz when the joint is still.  Lower is smoother.
+		 * @param speedCoefficient How much the cutoff frequency rises per meter per second of speed.  Higher lags less.
+		 * @param derivativeCutoff The cutoff frequency in hertz used when estimating the speed.
+		 */
+		void SetOneEuroParameters(int joint, float minimumCutoff, float speedCoefficient, float derivativeCutoff);
+		/**
+		 * Forgets everything filtered so far, so the next frame is passed through as is.
+		 */
+		void Reset();
+		/**
+		 * Filters the joints of every tracked person in a frame, in place.  People who stop being tracked are
+		 * forgotten, so somebody new in their slot does not get blended with them.
+		 * @param frame The frame to filter.
+		 */
+		void Apply(SkeletonFrame& frame);
+	protected:
+		/**
+		 * Filters the joints of one person with the Holt filter.
+		 * @param person The person to filter.
+		 * @param positions The x, y and z arrays of the person's joints.
+		 */
+		void applyHolt(int person, float** positions);
+		/**
+		 * Filters the joints of one person with the One Euro filter.
+		 * @param person The person to filter.
+		 * @param positions The x, y and z arrays of the person's joints.
+		 * @param elapsed The time since the previous frame, in seconds.
+		 */
+		void applyOneEuro(int person, float** positions, float elapsed);
+
+		/**
+		 * The kind of filter being used.
+		 */
+		SkeletonFilterType type;
+		/**
+		 * The Holt filter's weight of each new position (1 - smoothing), for each joint.
+		 */
+		float holtAlpha[PV_SKELETON_JOINTS];
+		/**
+		 * The Holt filter's correction, for each joint.
+		 */
+		float holtGamma[PV_SKELETON_JOINTS];
+		/**
+		 * The Holt filter's prediction, for each joint.
+		 */
+		float holtPrediction[PV_SKELETON_JOINTS];
+		/**
+		 * The One Euro filter's minimum cutoff, for each joint.
+		 */
+		float minimumCutoff[PV_SKELETON_JOINTS];
+		/**
+		 * The One Euro filter's speed coefficient, for each joint.
+		 */
+		float speedCoefficient[PV_SKELETON_JOINTS];
+		/**
+		 * The One Euro filter's derivative cutoff, for each joint.
+		 */
+		float derivativeCutoff[PV_SKELETON_JOINTS];
+		/**
+		 * The filtered position of each joint of each person, for the x, y and z axes.  Both filters use this.
+		 */
+		float position[3][PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		/**
+		 * The Holt filter's trend, or the One Euro filter's filtered speed, of each joint of each person.
+		 */
+		float trend[3][PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		/**
+		 * The unfiltered position of each joint of each person in the previous frame, used by the One Euro filter.
+		 */
+		float previous[3][PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		/**
+		 * A boolean for each person indicating whether there is anything filtered for them yet.
+		 */
+		bool initialized[PV_SKELETON_PEOPLE];
+		/**
+		 * The time of the previous frame filtered.
+		 */
+		double previousTime;
+	};
+};
+
+#endif
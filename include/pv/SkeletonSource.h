@@ -0,0 +1,115 @@
+#ifndef _SKELETON_SOURCE_H_
+#define _SKELETON_SOURCE_H_
+
+/**
+ * The number of joints in a skeleton.
+ */
+#define PV_SKELETON_JOINTS 20
+/**
+ * The most people a skeleton frame can hold.
+ */
+#define PV_SKELETON_PEOPLE 6
+
+namespace PV
+{
+	/**
+	 * The joints of a skeleton, in the same order as a Kinect for Windows V1 skeleton.
+	 */
+	enum SkeletonJoint
+	{
+		JointHipCenter = 0,
+		JointSpine = 1,
+		JointShoulderCenter = 2,
+		JointHead = 3,
+		JointShoulderLeft = 4,
+		JointElbowLeft = 5,
+		JointWristLeft = 6,
+		JointHandLeft = 7,
+		JointShoulderRight = 8,
+		JointElbowRight = 9,
+		JointWristRight = 10,
+		JointHandRight = 11,
+		JointHipLeft = 12,
+		JointKneeLeft = 13,
+		JointAnkleLeft = 14,
+		JointFootLeft = 15,
+		JointHipRight = 16,
+		JointKneeRight = 17,
+		JointAnkleRight = 18,
+		JointFootRight = 19
+	};
+
+	/**
+	 * The skeletons of everybody seen at one point in time.  Joint positions are stored as separate x, y and z
+	 * arrays for each person, so code working on every joint walks straight through memory and can process
+	 * several joints at once.  Positions are in meters, in the space of whatever is tracking the skeletons.
+	 */
+	struct SkeletonFrame
+	{
+		/**
+		 * The x coordinate of each joint of each person.
+		 */
+		float x[PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		/**
+		 * The y coordinate of each joint of each person.
+		 */
+		float y[PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		/**
+		 * The z coordinate of each joint of each person.
+		 */
+		float z[PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		/**
+		 * The tracking state of each joint of each person, 0 for not tracked, 1 for inferred and 2 for tracked.
+		 */
+		unsigned char jointStates[PV_SKELETON_PEOPLE][PV_SKELETON_JOINTS];
+		/**
+		 * The position of each person as a whole (x, y, z), which the tracker may work out separately from the
+		 * joints, such as the Kinect's center of mass.  It is not smoothed with the joints.
+		 */
+		float center[PV_SKELETON_PEOPLE][3];
+		/**
+		 * A boolean for each person indicating whether they are tracked.  The joints of people who are not
+		 * tracked are not meaningful.
+		 */
+		bool tracked[PV_SKELETON_PEOPLE];
+		/**
+		 * The person considered to be the user, or -1 if nobody is tracked.
+		 */
+		int mainPerson;
+		/**
+		 * The time the frame was seen, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double time;
+		/**
+		 * The number of frames the source produced before this one, 0 if it has not produced any yet.
+		 */
+		unsigned int frameIndex;
+	};
+
+	/**
+	 * Anything that tracks people's skeletons, such as a Kinect or a synthetic generator.  Sources produce
+	 * frames on their own threads, and the newest one can be read from any thread without blocking.
+	 */
+	class SkeletonSource
+	{
+	public:
+		/**
+		 * Checks whether the source is producing frames.
+		 * @return Returns true if frames are being produced, false otherwise.
+		 */
+		virtual const bool IsProducing() const = 0;
+		/**
+		 * Gets the newest skeleton frame.
+		 * @param frame The frame to copy the newest frame into.
+		 */
+		virtual void GetLatestFrame(SkeletonFrame& frame) const = 0;
+		/**
+		 * Destroys the source.
+		 */
+		virtual ~SkeletonSource()
+		{
+		}
+	};
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef _SYNTHETIC_IMAGES_H_
+#define _SYNTHETIC_IMAGES_H_
+
+#include "pv/ImageSource.h"
+#include <atomic>
+#include <thread>
+
+namespace PV
+{
+	/**
+	 * An image source which makes up depth and color images of a ball swinging in front of a wall, at any rate
+	 * up to 1000 frames per second.  It needs no sensor and runs on any platform, so the image path can be
+	 * stress tested and timed anywhere.  The ball is marked as player 1 in the depth images.
+	 */
+	class SyntheticImages : public ImageSource
+	{
+	public:
+		/**
+		 * Creates a synthetic source which is not producing images yet.
+		 * @param width The width of the images in pixels.
+		 * @param height The height of the images in pixels.
+		 * @param rate The number of frames of each kind to produce per second, at most 1000.
+		 */
+		SyntheticImages(unsigned int width, unsigned int height, unsigned int rate);
+		/**
+		 * Starts producing images on a new thread.
+		 */
+		void Start();
+		/**
+		 * Stops producing images and waits for the thread to finish.
+		 */
+		void Stop();
+		virtual const bool IsProducingImages() const;
+		virtual ImageFrame* AcquireLatestImage(ImageFormat format);
+		/**
+		 * Gets the number of frames of each kind produced per second, measured since the source was started.
+		 * @return The achieved rate in frames per second.
+		 */
+		const double GetRate() const;
+		/**
+		 * Gets the number of frames dropped because readers were holding every frame of a stream.
+		 * @return The number of dropped depth and color frames.
+		 */
+		const unsigned int GetDroppedCount() const;
+		/**
+		 * Stops producing images if the source still is.
+		 */
+		virtual ~SyntheticImages();
+	protected:
+		/**
+		 * The body of the generator thread.
+		 */
+		void run();
+		/**
+		 * Draws the scene at a point in time.
+		 * @param depth The depth frame to draw into.
+		 * @param color The color frame to draw into.
+		 * @param time The time in seconds since the source was started.
+		 */
+		void generate(ImageFrame& depth, ImageFrame& color, double time) const;
+
+		/**
+		 * The depth frames.
+		 */
+		ImagePool depthImages;
+		/**
+		 * The color frames.
+		 */
+		ImagePool colorImages;
+		/**
+		 * The thread producing the images.
+		 */
+		std::thread thread;
+		/**
+		 * A boolean telling the generator thread to keep going.
+		 */
+		std::atomic<bool> producing;
+		/**
+		 * The number of frames of each kind produced since the source was started.
+		 */
+		std::atomic<unsigned int> framesProduced;
+		/**
+		 * The number of frames of each kind produced per second.
+		 */
+		unsigned int rate;
+		/**
+		 * The time the source was started, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double startTime;
+	};
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef _SYNTHETIC_SKELETONS_H_
+#define _SYNTHETIC_SKELETONS_H_
+
+#include "pv/SkeletonSource.h"
+#include "Kernel/OVR_Lockless.h"
+#include <atomic>
+#include <thread>
+
+namespace PV
+{
+	/**
+	 * A skeleton source which makes up people walking on the spot and swinging their arms, at any rate up
+	 * to 1000 frames per second.  It needs no sensor and runs on any platform, so the skeleton processing
+	 * path can be stress tested and timed anywhere.
+	 */
+	class SyntheticSkeletons : public SkeletonSource
+	{
+	public:
+		/**
+		 * Creates a synthetic source which is not producing frames yet.
+		 * @param people The number of people to make up, at most PV_SKELETON_PEOPLE.
+		 * @param rate The number of frames to produce per second, at most 1000.
+		 */
+		SyntheticSkeletons(unsigned int people, unsigned int rate);
+		/**
+		 * Starts producing frames on a new thread.
+		 */
+		void Start();
+		/**
+		 * Stops producing frames and waits for the thread to finish.
+		 */
+		void Stop();
+		virtual const bool IsProducing() const;
+		virtual void GetLatestFrame(SkeletonFrame& frame) const;
+		/**
+		 * Gets the number of frames produced per second, measured since the source was started.
+		 * @return The achieved rate in frames per second.
+		 */
+		const double GetRate() const;
+		/**
+		 * Stops producing frames if the source still is.
+		 */
+		virtual ~SyntheticSkeletons();
+	protected:
+		/**
+		 * The body of the generator thread.
+		 */
+		void run();
+		/**
+		 * Fills in the skeletons of every person at a point in time.
+		 * @param frame The frame to fill in.
+		 * @param time The time in seconds since the source was started.
+		 */
+		void generate(SkeletonFrame& frame, double time) const;
+
+		/**
+		 * The newest frame produced.
+		 */
+		OVR::LocklessUpdater<SkeletonFrame, SkeletonFrame> latestFrame;
+		/**
+		 * The thread producing the frames.
+		 */
+		std::thread thread;
+		/**
+		 * A boolean telling the generator thread to keep going.
+		 */
+		std::atomic<bool> producing;
+		/**
+		 * The number of frames produced since the source was started.
+		 */
+		std::atomic<unsigned int> framesProduced;
+		/**
+		 * The number of people made up.
+		 */
+		unsigned int people;
+		/**
+		 * The number of frames produced per second.
+		 */
+		unsigned int rate;
+		/**
+		 * The time the source was started, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double startTime;
+	};
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _TRACKED_POSE_H_
+#define _TRACKED_POSE_H_
+
+#include "pv/types.h"
+#include "OVR_CAPI.h"
+
+/**
+ * The default number of times per second the tracking thread samples the head pose.
+ */
+#define PV_TRACKING_RATE 1000
+
+namespace PV
+{
+	/**
+	 * A head pose sampled by the tracking thread.
+	 */
+	struct TrackedPose
+	{
+		/**
+		 * The orientation and position of the head.
+		 */
+		ovrPosef pose;
+		/**
+		 * The orientation of the head in Euler angles, worked out on the tracking thread so readers do not have to.
+		 */
+		orientation_t rotation;
+		/**
+		 * The time the pose was sampled at, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double time;
+		/**
+		 * The tracking status flags at the time of the sample (ovrStatus_OrientationTracked, etc.)
+		 */
+		unsigned int statusFlags;
+		/**
+		 * The number of poses sampled since tracking started, counting this one, so the first sample is 1 and 0 means
+		 * no pose has been sampled yet.
+		 */
+		unsigned int sampleIndex;
+	};
+}
+
+#endif
@@ -9,7 +9,7 @@
 
 namespace PV
 {
-#ifdef _WIN32
+#if defined(_WIN32) || defined(__linux__)
 	/**
 	 * A list of potential errors when creating and destroy a window and it's parts.
 	 */
@@ -0,0 +1,142 @@
+#ifndef _FRAME_PACER_H_
+#define _FRAME_PACER_H_
+
+/**
+ * The number of most recent frames frame statistics are gathered over, about two seconds at 60 frames per second.
+ */
+#define PV_FRAME_HISTORY 120
+
+namespace PV
+{
+	/**
+	 * Statistics on how evenly frames were presented, over the last PV_FRAME_HISTORY frames.  All times are in seconds.
+	 */
+	struct FrameStats
+	{
+		/**
+		 * The number of frames the statistics cover.
+		 */
+		unsigned int frames;
+		/**
+		 * The average time from one swap to the next.
+		 */
+		double averageInterval;
+		/**
+		 * The shortest time from one swap to the next.
+		 */
+		double minimumInterval;
+		/**
+		 * The longest time from one swap to the next.
+		 */
+		double maximumInterval;
+		/**
+		 * The standard deviation of the time from one swap to the next, which is 0 for perfectly even frames.
+		 */
+		double jitter;
+		/**
+		 * The number of frames which took more than one and a half times the average interval, which a user sees
+		 * as a hitch.
+		 */
+		unsigned int hitches;
+		/**
+		 * The average time spent inside the swap, mostly waiting for vertical sync.
+		 */
+		double averageSwapTime;
+		/**
+		 * The average time the frame limiter spent waiting before the swap.
+		 */
+		double averageLimiterTime;
+	};
+
+	/**
+	 * Limits how often a window presents frames and keeps statistics on how evenly it does.  The limiter sleeps
+	 * until about 2 milliseconds before the next frame is due, then yields until it is, so it costs next to no CPU
+	 * yet is accurate to well under a millisecond.  A pacer must only be used by the thread that swaps the window.
+	 */
+	class FramePacer
+	{
+	public:
+		/**
+		 * Creates a pacer with no frame limit.
+		 */
+		FramePacer();
+		/**
+		 * Sets the most frames to present per second.
+		 * @param framesPerSecond The frame limit, or 0 to present frames as fast as they are drawn.
+		 */
+		void SetFrameLimit(double framesPerSecond);
+		/**
+		 * Gets the most frames presented per second.
+		 * @return The frame limit, or 0 if there is none.
+		 */
+		const double GetFrameLimit() const;
+		/**
+		 * Waits until the next frame is due, then notes when the swap started.  Called right before swapping.
+		 */
+		void BeginSwap();
+		/**
+		 * Notes when the swap finished and adds the frame to the statistics.  Called right after swapping.
+		 */
+		void EndSwap();
+		/**
+		 * Gets the statistics of the most recent frames.
+		 * @return The frame statistics.
+		 */
+		const FrameStats GetStats() const;
+		/**
+		 * Forgets every frame presented so far.
+		 */
+		void ResetStats();
+		/**
+		 * Restores the system timer resolution if the pacer raised it.
+		 */
+		~FramePacer();
+	protected:
+		/**
+		 * The time between frames when limited, or 0 for no limit.
+		 */
+		double interval;
+		/**
+		 * When the next frame is due, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double nextFrame;
+		/**
+		 * When the current swap started.
+		 */
+		double swapStart;
+		/**
+		 * When the last swap finished, or 0 before the first one.
+		 */
+		double lastSwap;
+		/**
+		 * How long the limiter waited before the current swap.
+		 */
+		double limiterTime;
+		/**
+		 * The time between swaps for each recent frame, as a ring.
+		 */
+		double intervals[PV_FRAME_HISTORY];
+		/**
+		 * The time spent in the swap for each recent frame, as a ring.
+		 */
+		double swapTimes[PV_FRAME_HISTORY];
+		/**
+		 * The time the limiter waited for each recent frame, as a ring.
+		 */
+		double limiterTimes[PV_FRAME_HISTORY];
+		/**
+		 * The number of frames in the rings.
+		 */
+		unsigned int count;
+		/**
+		 * The ring slot the next frame goes in.
+		 */
+		unsigned int next;
+		/**
+		 * A boolean indicating whether the pacer raised the system timer resolution so sleeps are accurate.
+		 */
+		bool raisedTimerResolution;
+	};
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+
+#include "pvmm/RenderCommandList.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace PV
+{
+	class Window;
+
+	/**
+	 * The number of frames the pipeline cycles through.  One is being recorded, one is being rendered,
+	 * and one holds the newest finished frame, so neither side ever has to wait on a lock.
+	 */
+#define PV_PIPELINE_FRAMES 3
+	/**
+	 * The bit set in a frame pipeline's shared index when the frame it points to has not been acquired yet.
+	 */
+#define PV_PIPELINE_NEW_FRAME 0x80000000
+
+	/**
+	 * A lock-free triple buffer of render command lists for handing frames from the simulation thread to
+	 * the render thread.  The simulation records frame N while the render thread submits frame N-1.  Only one
+	 * thread may record frames and only one thread may render them.  Handing frames over never takes a lock, only
+	 * a simulation held back by maxFramesAhead sleeps on one until the renderer acquires a frame.
+	 */
+	class FramePipeline
+	{
+	public:
+		/**
+		 * Creates a frame pipeline.
+		 * @param maxFramesAhead How many published frames the simulation may get ahead of the renderer before
+		 * BeginFrame waits.  Use 1 to keep the simulation locked to the renderer's (vsync) rate, or 0 to never wait.
+		 */
+		FramePipeline(unsigned int maxFramesAhead);
+		/**
+		 * Gets an empty command list to record the next frame into.  Called by the simulation thread.  While the
+		 * renderer is maxFramesAhead frames behind, this sleeps until it acquires one, so the renderer must keep
+		 * running until the simulation stops calling this.
+		 * @return The command list to record into.  It must not be used after Publish is called.
+		 */
+		RenderCommandList* BeginFrame();
+		/**
+		 * Publishes the frame recorded since BeginFrame, making it the newest frame for the renderer.  If the
+		 * renderer has not picked up the previously published frame yet, that frame is dropped.
+		 */
+		void Publish();
+		/**
+		 * Gets the newest published frame.  Called by the render thread.  If nothing new was published since
+		 * the last call, the same frame is returned again so it can be redrawn for the next vsync.
+		 * @return The newest frame, or NULL if no frame has been published yet.
+		 */
+		const RenderCommandList* Acquire();
+		/**
+		 * Checks whether a frame was published that the renderer has not acquired yet.
+		 * @return Returns true if a new frame is waiting, false otherwise.
+		 */
+		const bool HasNewFrame() const;
+		/**
+		 * Gets the number of frames published so far.
+		 */
+		const unsigned int FramesPublished() const;
+		/**
+		 * Gets the number of published frames the renderer has acquired so far.
+		 */
+		const unsigned int FramesAcquired() const;
+	protected:
+		/**
+		 * The command lists cycled between the simulation and the renderer.
+		 */
+		RenderCommandList frames[PV_PIPELINE_FRAMES];
+		/**
+		 * The index of the newest published frame in the low bits, and PV_PIPELINE_NEW_FRAME when the
+		 * renderer has not picked it up yet.  This is the only value both threads touch.
+		 */
+		std::atomic<unsigned int> shared;
+		/**
+		 * The sequence number of the frame held by each command list.
+		 */
+		unsigned int sequence[PV_PIPELINE_FRAMES];
+		/**
+		 * The index of the frame being recorded.  Only touched by the simulation thread.
+		 */
+		unsigned int recordIndex;
+		/**
+		 * The index of the frame being rendered.  Only touched by the render thread.
+		 */
+		unsigned int renderIndex;
+		/**
+		 * A boolean indicating whether a frame has ever been acquired.  Only touched by the render thread.
+		 */
+		bool rendering;
+		/**
+		 * How many frames the simulation may get ahead of the renderer.
+		 */
+		unsigned int maxFramesAhead;
+		/**
+		 * The number of frames published.
+		 */
+		std::atomic<unsigned int> published;
+		/**
+		 * The sequence number of the last frame acquired.  Frames dropped in favor of a newer one count as acquired.
+		 */
+		std::atomic<unsigned int> acquired;
+		/**
+		 * The lock and condition a held back simulation sleeps on until the renderer acquires a frame.
+		 */
+		std::mutex acquiredMutex;
+		std::condition_variable acquiredCondition;
+	};
+
+	/**
+	 * The function called by a render thread to submit a frame.
+	 * @param frame The frame to render.
+	 * @param userData The user data given when starting the render thread.
+	 */
+	typedef void renderFrameCallback(const RenderCommandList* frame, void* userData);
+
+	/**
+	 * A thread which owns a window's OpenGL context and renders the frames published to a frame pipeline.
+	 * The render callback is responsible for swapping the buffers (or ending the Oculus Rift frame), which
+	 * is what paces the thread to vsync.
+	 */
+	class RenderThread
+	{
+	public:
+		RenderThread();
+		/**
+		 * Starts rendering on a new thread.  The window's OpenGL context must not be current on any other thread,
+		 * see Window::ReleaseGLContext.
+		 * @param window The window whose OpenGL context the thread renders with.
+		 * @param pipeline The pipeline to take frames from.
+		 * @param callback The function which renders a frame.
+		 * @param userData Passed to the callback untouched.
+		 */
+		void Start(Window* window, FramePipeline* pipeline, renderFrameCallback* callback, void* userData);
+		/**
+		 * Stops the render thread and waits for it to finish, releasing the OpenGL context so that it can be
+		 * made current on the calling thread again.
+		 */
+		void Stop();
+		/**
+		 * Checks whether the render thread is running.
+		 * @return Returns true if the thread is running, false otherwise.
+		 */
+		const bool IsRunning() const;
+		/**
+		 * Stops the render thread if it is still running.
+		 */
+		~RenderThread();
+	protected:
+		/**
+		 * The body of the render thread.
+		 */
+		void run();
+
+		/**
+		 * The thread doing the rendering.
+		 */
+		std::thread thread;
+		/**
+		 * A boolean telling the render thread to keep going.
+		 */
+		std::atomic<bool> running;
+		/**
+		 * The window whose OpenGL context is used for rendering.
+		 */
+		Window* window;
+		/**
+		 * The pipeline frames are taken from.
+		 */
+		FramePipeline* pipeline;
+		/**
+		 * The function which renders a frame.
+		 */
+		renderFrameCallback* callback;
+		/**
+		 * The user data passed to the callback.
+		 */
+		void* userData;
+	};
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef _INPUT_SNAPSHOT_H_
+#define _INPUT_SNAPSHOT_H_
+
+/**
+ * The number of key codes an input snapshot tracks.  Key codes are the same as Windows' virtual key codes on every
+ * platform, so letters and digits are their upper case ASCII characters.
+ */
+#define PV_KEY_COUNT 256
+/**
+ * Key codes for the keys without a character, matching Windows' virtual key codes.
+ */
+#define PV_KEY_BACKSPACE 0x08
+#define PV_KEY_TAB 0x09
+#define PV_KEY_ENTER 0x0D
+#define PV_KEY_SHIFT 0x10
+#define PV_KEY_CONTROL 0x11
+#define PV_KEY_ALT 0x12
+#define PV_KEY_ESCAPE 0x1B
+#define PV_KEY_SPACE 0x20
+#define PV_KEY_LEFT 0x25
+#define PV_KEY_UP 0x26
+#define PV_KEY_RIGHT 0x27
+#define PV_KEY_DOWN 0x28
+#define PV_KEY_F1 0x70
+/**
+ * Bits for the mouse buttons in an input snapshot.
+ */
+#define PV_MOUSE_LEFT 0x1
+#define PV_MOUSE_RIGHT 0x2
+#define PV_MOUSE_MIDDLE 0x4
+
+namespace PV
+{
+	/**
+	 * The state of the keyboard and mouse after a window has handled every event that was waiting, along with what
+	 * changed since the previous snapshot.  Snapshots are small and flat, so they can be copied between threads.
+	 */
+	struct InputSnapshot
+	{
+		/**
+		 * A bit for each key code, set while the key is held.
+		 */
+		unsigned int keysDown[PV_KEY_COUNT / 32];
+		/**
+		 * A bit for each key code, set if the key went down since the previous snapshot, even if it was released
+		 * again before this one.
+		 */
+		unsigned int keysPressed[PV_KEY_COUNT / 32];
+		/**
+		 * A bit for each key code, set if the key was released since the previous snapshot.
+		 */
+		unsigned int keysReleased[PV_KEY_COUNT / 32];
+		/**
+		 * The mouse position in pixels from the top left of the window.
+		 */
+		int mouseX, mouseY;
+		/**
+		 * How far the mouse moved since the previous snapshot, in pixels.
+		 */
+		int mouseDeltaX, mouseDeltaY;
+		/**
+		 * How many notches the mouse wheel turned since the previous snapshot, positive away from the user.
+		 */
+		int wheelDelta;
+		/**
+		 * The PV_MOUSE_* bits of the mouse buttons held.
+		 */
+		unsigned int mouseButtons;
+		/**
+		 * The size of the window's drawing area in pixels.  The thread drawing to the window sets its viewport
+		 * from this, since the window's own thread may not have the OpenGL context.
+		 */
+		unsigned int windowWidth, windowHeight;
+		/**
+		 * The number of events handled since the previous snapshot.
+		 */
+		unsigned int events;
+		/**
+		 * A boolean indicating whether the user asked to close the window or quit.
+		 */
+		bool closeRequested;
+		/**
+		 * The time the snapshot was taken, on the same clock as ovr_GetTimeInSeconds.
+		 */
+		double time;
+		/**
+		 * The time the previous snapshot was taken, so the changes above cover time - previousTime.
+		 */
+		double previousTime;
+		/**
+		 * The number of snapshots taken before this one.
+		 */
+		unsigned int frameIndex;
+	};
+
+	/**
+	 * Checks whether a key is held in a snapshot.
+	 * @param input The snapshot to check.
+	 * @param key The key code.
+	 * @return Returns true if the key is held, false otherwise.
+	 */
+	inline const bool IsKeyDown(const InputSnapshot& input, unsigned int key)
+	{
+		return key < PV_KEY_COUNT && (input.keysDown[key / 32] & (1u << (key % 32))) != 0;
+	}
+
+	/**
+	 * Checks whether a key went down since the previous snapshot.
+	 * @param input The snapshot to check.
+	 * @param key The key code.
+	 * @return Returns true if the key was pressed, false otherwise.
+	 */
+	inline const bool WasKeyPressed(const InputSnapshot& input, unsigned int key)
+	{
+		return key < PV_KEY_COUNT && (input.keysPressed[key / 32] & (1u << (key % 32))) != 0;
+	}
+};
+
+#endif
@@ -5,7 +5,9 @@
 #include "pv/Matrices.h"
 
 #define _USE_MATH_DEFINES
-#include <Math.h>
+#include <math.h>
+#include <string>
+#include <vector>
 
 namespace PV
 {
@@ -29,6 +31,19 @@ namespace PV
 	 * @param shaderSource The shader's source code as a null terminated string.
 	 */
 	void compileShaders(unsigned int shader, const char* shaderSource);
+	/**
+	 * Prints the log of a shader if it failed to compile.  This waits for the shader to finish compiling.
+	 * @param shader The shader.
+	 * @param kind What kind of shader it is, such as "Vertex", for the message.
+	 */
+	void printShaderLog(unsigned int shader, const char* kind);
+	/**
+	 * Adds preprocessor definitions to shader source, after its #version line since nothing may come before that.
+	 * @param source The shader's source code.
+	 * @param defines The definitions to add, one per line.
+	 * @return The new source code.
+	 */
+	std::string addShaderDefines(const char* source, const char* defines);
 	/** 
 	 * Link a vertex shader and fragment shader to a specified program.
 	 * @param program The program to attach and link the shaders to.
@@ -43,6 +58,204 @@ namespace PV
 	 * @return Returns the program's handle ID on success.
 	 */
 	unsigned int createShaders(const char* vertexShader, const char* fragmentShader);
+	/**
+	 * Creates a vertex and fragment shader from the specified files, with some preprocessor definitions added after
+	 * their #version line, and attach them to a program.
+	 * @param vertexShader The filename of the vertex shader to load and attach to a program.
+	 * @param fragmentShader The filename of the fragment shader to load and attach to a program.
+	 * @param defines The definitions to add, such as "#define SKINNED 1\n", or NULL for none.
+	 * @return Returns the program's handle ID on success.
+	 */
+	unsigned int createShaders(const char* vertexShader, const char* fragmentShader, const char* defines);
+	/**
+	 * Creates a program from vertex and fragment shader source code.  When the driver supports program binaries,
+	 * the linked program is saved to the shader cache, and later calls with the same source, definitions and driver
+	 * load it from there instead of compiling anything.  If the driver rejects a cached binary, for example after
+	 * an update, the program is compiled again and the cache is replaced.
+	 * @param vertexSource The vertex shader's source code as a null terminated string.
+	 * @param fragmentSource The fragment shader's source code as a null terminated string.
+	 * @param defines The definitions to add after each shader's #version line, or NULL for none.
+	 * @return Returns the program's handle ID on success.
+	 */
+	unsigned int createShadersFromSource(const char* vertexSource, const char* fragmentSource, const char* defines);
+	/**
+	 * Sets the directory linked programs are cached in.  The directory must already exist.
+	 * @param directory The directory to cache programs in, or NULL to stop caching them.  Programs are cached in
+	 * the working directory until this is called.
+	 */
+	void setShaderCacheDirectory(const char* directory);
+
+	/**
+	 * Checks whether the current OpenGL context supports an extension.
+	 * @param name The extension's name, such as "GL_KHR_parallel_shader_compile".
+	 * @return Returns true if the extension is supported, false otherwise.
+	 */
+	bool hasGLExtension(const char* name);
+
+	/**
+	 * The states a program in a shader batch goes through.
+	 */
+	enum ShaderProgramState
+	{
+		/**
+		 * Added to the batch, but not submitted yet.
+		 */
+		ProgramQueued = 0,
+		/**
+		 * Submitted, and being compiled and linked by the driver.
+		 */
+		ProgramCompiling = 1,
+		/**
+		 * Linked and ready to use.
+		 */
+		ProgramReady = 2,
+		/**
+		 * Failed to compile or link, with the reason printed.
+		 */
+		ProgramFailed = 3
+	};
+
+	/**
+	 * A set of shader programs compiled together.  Every program is submitted to the driver at once, and Poll
+	 * collects the ones that have finished without waiting on the rest, so the driver can compile them on its own
+	 * threads (KHR_parallel_shader_compile) while the application loads everything else.  Programs found in the
+	 * shader cache are ready as soon as they are submitted.  A batch must only be used on the thread its context is
+	 * current on.
+	 */
+	class ShaderBatch
+	{
+	public:
+		ShaderBatch();
+		/**
+		 * Adds a program to the batch from shader source code.
+		 * @param vertexSource The vertex shader's source code as a null terminated string.
+		 * @param fragmentSource The fragment shader's source code as a null terminated string.
+		 * @param defines The definitions to add after each shader's #version line, or NULL for none.
+		 * @return The index of the program in the batch.
+		 */
+		unsigned int Add(const char* vertexSource, const char* fragmentSource, const char* defines);
+		/**
+		 * Adds a program to the batch from shader files.
+		 * @param vertexShader The filename of the vertex shader.
+		 * @param fragmentShader The filename of the fragment shader.
+		 * @param defines The definitions to add after each shader's #version line, or NULL for none.
+		 * @return The index of the program in the batch.
+		 */
+		unsigned int AddFiles(const char* vertexShader, const char* fragmentShader, const char* defines);
+		/**
+		 * Starts compiling and linking every program added since the last submit, without waiting for any of them.
+		 */
+		void Submit();
+		/**
+		 * Collects the programs that have finished, without waiting for the rest.  Where the driver cannot report
+		 * whether a program has finished, one program is collected per call, which may wait for it.
+		 * @return The number of programs collected, whether they became ready or failed.
+		 */
+		unsigned int Poll();
+		/**
+		 * Waits for every submitted program to finish.
+		 */
+		void Wait();
+		/**
+		 * Checks whether every submitted program has finished.
+		 * @return Returns true if none are still compiling, false otherwise.
+		 */
+		const bool IsComplete() const;
+		/**
+		 * Checks whether the driver is compiling the programs on its own threads.
+		 * @return Returns true if KHR_parallel_shader_compile is in use, false otherwise.
+		 */
+		const bool IsParallel() const;
+		/**
+		 * Gets the number of programs in the batch.
+		 * @return The number of programs.
+		 */
+		const unsigned int GetCount() const;
+		/**
+		 * Gets the state of a program.
+		 * @param index The program's index in the batch.
+		 * @return The program's state.
+		 */
+		const ShaderProgramState GetState(unsigned int index) const;
+		/**
+		 * Gets a program's handle once it is ready.
+		 * @param index The program's index in the batch.
+		 * @return The program's handle ID, or 0 if it is not ready.
+		 */
+		const unsigned int GetProgram(unsigned int index) const;
+	protected:
+		/**
+		 * A program in the batch.
+		 */
+		struct Entry
+		{
+			/**
+			 * The shaders' source code, with the definitions already added.
+			 */
+			std::string vertexSource, fragmentSource;
+			/**
+			 * The handles of the program and its shaders.  The shaders are deleted once the program finishes.
+			 */
+			unsigned int program, vertex, fragment;
+			/**
+			 * The program's state.
+			 */
+			ShaderProgramState state;
+			/**
+			 * Whether the program is cached, along with the hash and file it is cached under.
+			 */
+			bool cached;
+			unsigned long long key;
+			std::string cachePath;
+		};
+
+		/**
+		 * Checks a compiled program for errors, deletes its shaders and caches it.
+		 * @param entry The program.
+		 */
+		void finish(Entry& entry);
+
+		/**
+		 * The programs in the batch.
+		 */
+		std::vector<Entry> entries;
+		/**
+		 * Whether the driver compiles in parallel.
+		 */
+		bool parallel;
+		/**
+		 * The number of programs submitted that have not finished.
+		 */
+		unsigned int pending;
+	};
+
+	/**
+	 * Aligns a type or variable to 16 bytes, so whole columns of a matrix can be loaded into SIMD registers at once.
+	 */
+#if defined(_MSC_VER)
+#define PV_ALIGN16 __declspec(align(16))
+#else
+#define PV_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+	/**
+	 * The matrices an eye is rendered with, all 4x4 and column major.
+	 */
+	struct PV_ALIGN16 EyeMatrices
+	{
+		/**
+		 * The eye's view matrix.
+		 */
+		float view[16];
+		/**
+		 * The eye's projection matrix.
+		 */
+		float projection[16];
+		/**
+		 * The projection matrix multiplied by the view matrix.
+		 */
+		float viewProjection[16];
+	};
 
 	/**
 	* Creates a perspective matrix based on the given values and stores it in an array of floats.
@@ -53,9 +266,44 @@ namespace PV
 	* @param farValue The cutoff value for objects further from the screen.
 	*/
 	void createPerspectiveMatrix(float* array, float fieldOfView, float aspectRatio, float nearValue, float farValue);
+	/**
+	 * Creates an off center perspective matrix from the tangents of the angles between the center of an eye's view
+	 * and each edge of it, such as an ovrFovPort, and stores it in an array of floats.
+	 * @param array The array to store the perspective view in.
+	 * @param upTan The tangent of the angle to the top edge.
+	 * @param downTan The tangent of the angle to the bottom edge.
+	 * @param leftTan The tangent of the angle to the left edge.
+	 * @param rightTan The tangent of the angle to the right edge.
+	 * @param nearValue The cutoff value for objects closer to the screen.
+	 * @param farValue The cutoff value for objects further from the screen.
+	 */
+	void createPerspectiveMatrix(float* array, float upTan, float downTan, float leftTan, float rightTan, float nearValue, float farValue);
+	/**
+	 * Creates a reverse depth perspective matrix with no far plane and stores it in an array of floats.  The near
+	 * plane ends up at a depth of 1 and infinity at 0, which is only kept in range with the depth range set to 0 to 1
+	 * by glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE), and needs the depth test set to GL_GREATER and the depth buffer
+	 * cleared to 0.  With a floating point depth buffer this is far more precise than the standard perspective.
+	 * @param array The array to store the perspective view in.
+	 * @param fieldOfView The field of view angle for what the perspective view can see.
+	 * @param aspectRatio The aspect ratio for what the perspective view can see.
+	 * @param nearValue The cutoff value for objects closer to the screen.
+	 */
+	void createReverseDepthPerspectiveMatrix(float* array, float fieldOfView, float aspectRatio, float nearValue);
+	/**
+	 * Creates an off center reverse depth perspective matrix with no far plane from the tangents of the angles between
+	 * the center of an eye's view and each edge of it, and stores it in an array of floats.  It is used the same way
+	 * as the other reverse depth perspective matrix.
+	 * @param array The array to store the perspective view in.
+	 * @param upTan The tangent of the angle to the top edge.
+	 * @param downTan The tangent of the angle to the bottom edge.
+	 * @param leftTan The tangent of the angle to the left edge.
+	 * @param rightTan The tangent of the angle to the right edge.
+	 * @param nearValue The cutoff value for objects closer to the screen.
+	 */
+	void createReverseDepthPerspectiveMatrix(float* array, float upTan, float downTan, float leftTan, float rightTan, float nearValue);
 	/**
 	 * Creates a perspective matrix based on the given values and stores it in a matrix object.
-	 * @param matrix The matrix to store the perspective view in.
+	 * @param matrix The 4x4 matrix to store the perspective view in.
 	 * @param fieldOfView The field of view angle for what the perspective view can see.
 	 * @param aspectRatio The aspect ratio for what the perspective view can see.
 	 * @param nearValue The cutoff value for objects closer to the screen.
@@ -63,22 +311,68 @@ namespace PV
 	 */
 	void createPerspectiveMatrix(PV::Math::Matrix<float> &matrix, float fieldOfView, float aspectRatio, float nearValue, float farValue);
 
+	/**
+	 * Creates a lookAt matrix using from the desired position and rotation, and then stores it in an array of floats.
+	 * This is the same as rotating and then translating a matrix, without building either.
+	 * @param array The array to store the resulting lookAt matrix into.
+	 * @param position The position of the camera to use in the lookAt matrix.
+	 * @param rotation The rotation of the camera to use in the lookAt matrix.
+	 */
+	void createLookAtMatrix(float* array, Math::vec3 position, Math::vec3 rotation);
 	/**
 	 * Creates a lookAt matrix using from the desired position and rotation, and then stores it in the desired matrix.
-	 * @param matrix The matrix to store the resulting lookAt matrix into.
+	 * @param matrix The 4x4 matrix to store the resulting lookAt matrix into.
 	 * @param position The position of the camera to use in the lookAt matrix.
 	 * @param rotation The rotation of the camera to use in the lookAt matrix.
 	 */
 	void createLookAtMatrix(PV::Math::Matrix<float> &matrix, Math::vec3 position, Math::vec3 rotation);
 
+	/**
+	 * Creates a lookAt matrix at the specified eye position, looking at a specific target, and then stores it in an
+	 * array of floats.
+	 * @param array The array to store the resulting lookAt matrix into.
+	 * @param eye The position of the eye to use in the lookAt matrix.
+	 * @param target The target of where the camera is looking in the lookAt matrix.
+	 * @param up What direction up is relative to the camera.
+	 */
+	void createLookAtMatrix(float* array, Math::vec3 eye, Math::vec3 target, Math::vec3 up);
 	/**
 	* Creates a lookAt matrix at the specified eye position, looking at a specific target, and then stores it in the desired matrix.
-	* @param matrix The matrix to store the resulting lookAt matrix into.
+	* @param matrix The 4x4 matrix to store the resulting lookAt matrix into.
 	* @param eye The position of the eye to use in the lookAt matrix.
 	* @param target The target of where the camera is looking in the lookAt matrix.
 	* @param up What direction up is relative to the camera.
 	*/
 	void createLookAtMatrix(PV::Math::Matrix<float> &matrix, Math::vec3 eye, Math::vec3 target, Math::vec3 up);
+
+	/**
+	 * Creates every matrix an eye is rendered with in one pass, without allocating.  The eye's view is the head's view
+	 * moved by the eye's offset, and the view-projection is multiplied out knowing which elements of the projection
+	 * are zero.  Call it once for each eye with that eye's ovrEyeRenderDesc::ViewAdjust and Fov.
+	 * @param eye The matrices to fill in.
+	 * @param headView The head's 4x4 column major view matrix.
+	 * @param viewAdjust The translation from the head's view to the eye's view.
+	 * @param upTan The tangent of the angle to the top edge of the eye's view.
+	 * @param downTan The tangent of the angle to the bottom edge of the eye's view.
+	 * @param leftTan The tangent of the angle to the left edge of the eye's view.
+	 * @param rightTan The tangent of the angle to the right edge of the eye's view.
+	 * @param nearValue The cutoff value for objects closer to the screen.
+	 * @param farValue The cutoff value for objects further from the screen.
+	 */
+	void createEyeMatrices(EyeMatrices& eye, const float* headView, Math::vec3 viewAdjust, float upTan, float downTan, float leftTan, float rightTan, float nearValue, float farValue);
+	/**
+	 * Creates every matrix an eye is rendered with in one pass, the same as createEyeMatrices but with a reverse depth
+	 * perspective with no far plane, see createReverseDepthPerspectiveMatrix.
+	 * @param eye The matrices to fill in.
+	 * @param headView The head's 4x4 column major view matrix.
+	 * @param viewAdjust The translation from the head's view to the eye's view.
+	 * @param upTan The tangent of the angle to the top edge of the eye's view.
+	 * @param downTan The tangent of the angle to the bottom edge of the eye's view.
+	 * @param leftTan The tangent of the angle to the left edge of the eye's view.
+	 * @param rightTan The tangent of the angle to the right edge of the eye's view.
+	 * @param nearValue The cutoff value for objects closer to the screen.
+	 */
+	void createReverseDepthEyeMatrices(EyeMatrices& eye, const float* headView, Math::vec3 viewAdjust, float upTan, float downTan, float leftTan, float rightTan, float nearValue);
 };
 
 #endif
\ No newline at end of file
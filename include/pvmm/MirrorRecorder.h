@@ -0,0 +1,127 @@
+#ifndef _MIRROR_RECORDER_H_
+#define _MIRROR_RECORDER_H_
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace PV
+{
+	/**
+	 * The number of pixel buffers read back into in turn, so a frame is only mapped once the GPU has had a
+	 * couple of frames to finish copying it.
+	 */
+#define PV_RECORDER_READBACKS 3
+	/**
+	 * The number of frames that can wait to be written to the file before new frames are dropped.
+	 */
+#define PV_RECORDER_FRAMES 8
+
+	/**
+	 * Records the mirror window to a file on a background thread.  Frames are read back from the default
+	 * framebuffer into pixel buffers without waiting on the GPU, copied out a few frames later, and written
+	 * to the file by the recorder's own thread, so recording never blocks rendering on the disk.  If the disk
+	 * falls behind, frames are dropped rather than stalling the renderer.
+	 *
+	 * The file holds raw frames one after another, each width * height RGBA pixels from the bottom row up,
+	 * which an encoder such as ffmpeg can read as raw video (-f rawvideo -pix_fmt rgba -vf vflip).
+	 */
+	class MirrorRecorder
+	{
+	public:
+		/**
+		 * Creates a recorder which is not recording.
+		 */
+		MirrorRecorder();
+		/**
+		 * Starts recording to a file.  Must be called on the thread that owns the OpenGL context.
+		 * @param fileName The name of the file to record to.
+		 * @param width The width of the frames to record.
+		 * @param height The height of the frames to record.
+		 * @return Returns true if recording started, false otherwise.
+		 */
+		bool Start(const char* fileName, int width, int height);
+		/**
+		 * Captures the bottom left of the default framebuffer's back buffer.  Call it after drawing the mirror
+		 * and before swapping buffers, on the thread that owns the OpenGL context.
+		 */
+		void Capture();
+		/**
+		 * Stops recording, waiting for the queued frames to be written.  Must be called on the thread that owns
+		 * the OpenGL context.
+		 */
+		void Stop();
+		/**
+		 * Checks whether the recorder is recording.
+		 * @return Returns true if recording, false otherwise.
+		 */
+		const bool IsRecording() const;
+		/**
+		 * Gets the number of frames written to the file.
+		 * @return The number of frames written.
+		 */
+		const unsigned int GetFramesWritten() const;
+		/**
+		 * Gets the number of frames dropped because the writer thread fell behind.
+		 * @return The number of frames dropped.
+		 */
+		const unsigned int GetFramesDropped() const;
+		/**
+		 * Stops recording if it is still going.
+		 */
+		~MirrorRecorder();
+	protected:
+		/**
+		 * The body of the writer thread.
+		 */
+		void run();
+
+		/**
+		 * The file being recorded to.
+		 */
+		FILE* file;
+		/**
+		 * The width of the recorded frames.
+		 */
+		int width;
+		/**
+		 * The height of the recorded frames.
+		 */
+		int height;
+		/**
+		 * The pixel buffers frames are read back into.
+		 */
+		unsigned int readbacks[PV_RECORDER_READBACKS];
+		/**
+		 * The number of read backs started since recording started.
+		 */
+		unsigned int readbacksIssued;
+		/**
+		 * The frames waiting to be written, used as a ring.
+		 */
+		std::vector<unsigned char> frames[PV_RECORDER_FRAMES];
+		/**
+		 * The number of frames handed to the writer thread.  Only written by the rendering thread.
+		 */
+		std::atomic<unsigned int> framesQueued;
+		/**
+		 * The number of frames the writer thread has written.  Only written by the writer thread.
+		 */
+		std::atomic<unsigned int> framesWritten;
+		/**
+		 * The number of frames dropped because the ring was full.  Only written by the thread calling Capture.
+		 */
+		std::atomic<unsigned int> framesDropped;
+		/**
+		 * The thread writing frames to the file.
+		 */
+		std::thread thread;
+		/**
+		 * A boolean telling the writer thread to keep going.
+		 */
+		std::atomic<bool> recording;
+	};
+};
+
+#endif
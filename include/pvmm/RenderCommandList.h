@@ -0,0 +1,234 @@
+#ifndef _RENDER_COMMAND_LIST_H_
+#define _RENDER_COMMAND_LIST_H_
+
+#include <vector>
+
+namespace PV
+{
+	/**
+	 * The number of bits of a sort key used for each part of it, from the most significant bits down.
+	 */
+#define PV_SORT_PASS_BITS 4
+#define PV_SORT_PROGRAM_BITS 12
+#define PV_SORT_TEXTURE_BITS 16
+#define PV_SORT_VERTEX_ARRAY_BITS 12
+#define PV_SORT_DEPTH_BITS 20
+
+	/**
+	 * A single recorded draw call.  Everything needed to submit the draw is stored by value, so a
+	 * command stays valid no matter what the thread that recorded it does afterwards.
+	 */
+	struct DrawCommand
+	{
+		/**
+		 * The shader program to draw with.
+		 */
+		unsigned int program;
+		/**
+		 * The location of the model-view-projection matrix uniform in the program.
+		 */
+		int mvpLocation;
+		/**
+		 * The vertex array object holding the geometry to draw.
+		 */
+		unsigned int vertexArray;
+		/**
+		 * The texture to bind to the first texture unit, or 0 for none.
+		 */
+		unsigned int texture;
+		/**
+		 * The type of primitive to draw (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
+		 */
+		unsigned int primitive;
+		/**
+		 * The first vertex to draw.
+		 */
+		unsigned int first;
+		/**
+		 * The number of vertices to draw.
+		 */
+		unsigned int count;
+		/**
+		 * The key this command is ordered by when the list is sorted.
+		 */
+		unsigned long long sortKey;
+		/**
+		 * The model matrix of the object being drawn.
+		 */
+		float modelMatrix[16];
+	};
+
+	/**
+	 * Counters of the work done while executing a command list.
+	 */
+	struct RenderStats
+	{
+		/**
+		 * The number of draw calls submitted.
+		 */
+		unsigned int draws;
+		/**
+		 * The number of times a different program was bound.
+		 */
+		unsigned int programChanges;
+		/**
+		 * The number of times a different texture was bound.
+		 */
+		unsigned int textureChanges;
+		/**
+		 * The number of times a different vertex array was bound.
+		 */
+		unsigned int vertexArrayChanges;
+	};
+
+	/**
+	 * Packs the state of a draw call into a key, so that sorting by the key groups draws by pass, then by
+	 * program, then by texture, then by vertex array, and finally front to back.  Names which do not fit
+	 * in their part of the key only make the grouping less tight, the real state is still compared when
+	 * the commands are executed.
+	 * @param pass The pass the draw belongs to, lower passes are drawn first.
+	 * @param program The shader program to draw with.
+	 * @param texture The texture to draw with.
+	 * @param vertexArray The vertex array object to draw.
+	 * @param depth The distance to the object from 0 (nearest) to 1 (furthest).
+	 * @return The sort key for the draw call.
+	 */
+	unsigned long long createSortKey(unsigned int pass, unsigned int program, unsigned int texture, unsigned int vertexArray, float depth);
+
+	/**
+	 * A list of draw commands making up a single frame.  The list is filled in by the simulation and then
+	 * handed off to be executed, possibly on another thread which owns the OpenGL context.  Clearing the
+	 * list keeps its memory, so recording a frame does not allocate once the list has grown large enough.
+	 */
+	class RenderCommandList
+	{
+	public:
+		/**
+		 * Creates an empty command list with an identity view matrix.
+		 */
+		RenderCommandList();
+		/**
+		 * Removes all of the commands from the list and resets the view matrix.
+		 */
+		void Clear();
+		/**
+		 * Sets the camera's view matrix for this frame.
+		 * @param matrix The 16 floats of the view matrix, column major.
+		 */
+		void SetViewMatrix(const float* matrix);
+		/**
+		 * Gets the camera's view matrix for this frame.
+		 * @return The 16 floats of the view matrix, column major.
+		 */
+		const float* ViewMatrix() const;
+		/**
+		 * Records a draw call.
+		 * @param program The shader program to draw with.
+		 * @param mvpLocation The location of the model-view-projection uniform in the program.
+		 * @param vertexArray The vertex array object to draw.
+		 * @param texture The texture to bind, or 0 for none.
+		 * @param primitive The type of primitive to draw.
+		 * @param first The first vertex to draw.
+		 * @param count The number of vertices to draw.
+		 * @param modelMatrix The 16 floats of the model matrix, column major.
+		 */
+		void Draw(unsigned int program, int mvpLocation, unsigned int vertexArray, unsigned int texture,
+			unsigned int primitive, unsigned int first, unsigned int count, const float* modelMatrix);
+		/**
+		 * Records a draw call in a specific pass and at a specific depth, which are used when sorting the list.
+		 * @param pass The pass the draw belongs to, lower passes are drawn first.
+		 * @param depth The distance to the object from 0 (nearest) to 1 (furthest).
+		 * @param program The shader program to draw with.
+		 * @param mvpLocation The location of the model-view-projection uniform in the program.
+		 * @param vertexArray The vertex array object to draw.
+		 * @param texture The texture to bind, or 0 for none.
+		 * @param primitive The type of primitive to draw.
+		 * @param first The first vertex to draw.
+		 * @param count The number of vertices to draw.
+		 * @param modelMatrix The 16 floats of the model matrix, column major.
+		 */
+		void Draw(unsigned int pass, float depth, unsigned int program, int mvpLocation, unsigned int vertexArray, unsigned int texture,
+			unsigned int primitive, unsigned int first, unsigned int count, const float* modelMatrix);
+		/**
+		 * Sorts the commands by their sort keys with a radix sort, so that executing them changes state as
+		 * little as possible.  Commands with equal keys keep the order they were recorded in.  This should be
+		 * called by the thread recording the frame, after the last command is recorded.
+		 */
+		void Sort();
+		/**
+		 * Checks whether the list has been sorted since the last command was recorded.
+		 * @return Returns true if the list will be executed in sorted order, false otherwise.
+		 */
+		const bool IsSorted() const;
+		/**
+		 * Gets the number of commands in the list.
+		 * @return The number of recorded commands.
+		 */
+		const unsigned int Size() const;
+		/**
+		 * Gets a recorded command.
+		 * @param index The index of the command to get.
+		 * @return The command at the specified index.
+		 */
+		const DrawCommand& operator[](const unsigned int index) const;
+		/**
+		 * Submits all of the commands to OpenGL, in sorted order if the list was sorted and in the order they were
+		 * recorded otherwise.  A program, texture or vertex array is only bound when it differs from the previous
+		 * command's.  Must be called on the thread that owns the OpenGL context.
+		 * @param projectionMatrix The 16 floats of the projection matrix to draw with, column major.
+		 * @param eyeMatrix An extra view matrix applied before the camera's, such as an eye's pose, or NULL.
+		 */
+		void Execute(const float* projectionMatrix, const float* eyeMatrix) const;
+		/**
+		 * Submits all of the commands to OpenGL, counting the state changes made while doing so.
+		 * @param projectionMatrix The 16 floats of the projection matrix to draw with, column major.
+		 * @param eyeMatrix An extra view matrix applied before the camera's, such as an eye's pose, or NULL.
+		 * @param stats The counters to add this execution's work to.
+		 */
+		void Execute(const float* projectionMatrix, const float* eyeMatrix, RenderStats* stats) const;
+	protected:
+		/**
+		 * A sort key along with the command it belongs to.
+		 */
+		struct SortEntry
+		{
+			unsigned long long key;
+			unsigned int index;
+		};
+
+		/**
+		 * The recorded draw commands.
+		 */
+		std::vector<DrawCommand> commands;
+		/**
+		 * The order to execute the commands in once the list has been sorted.
+		 */
+		std::vector<unsigned int> order;
+		/**
+		 * Scratch space used by the radix sort, kept between frames so sorting does not allocate.
+		 */
+		std::vector<SortEntry> sortEntries;
+		/**
+		 * The second half of the radix sort's scratch space.
+		 */
+		std::vector<SortEntry> sortScratch;
+		/**
+		 * A boolean indicating whether the commands are to be executed in sorted order.
+		 */
+		bool sorted;
+		/**
+		 * The camera's view matrix for this frame.
+		 */
+		float viewMatrix[16];
+	};
+
+	/**
+	 * Multiplies two 4x4 column major matrices together without allocating.
+	 * @param output The 16 floats to store the product in.  Must not be either of the inputs.
+	 * @param a The left hand side of the multiplication.
+	 * @param b The right hand side of the multiplication.
+	 */
+	void multiplyMatrices(float* output, const float* a, const float* b);
+};
+
+#endif
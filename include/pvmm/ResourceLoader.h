@@ -0,0 +1,143 @@
+#ifndef _RESOURCE_LOADER_H_
+#define _RESOURCE_LOADER_H_
+
+#include "pv/MinOpenGL.h"
+#include <atomic>
+#include <thread>
+
+namespace PV
+{
+	class Window;
+
+	/**
+	 * The number of uploads that can be queued on a resource loader before Queue refuses more.
+	 */
+#define PV_LOADER_UPLOADS 64
+
+	/**
+	 * The function a resource loader calls on its own thread to create and fill in textures and buffers, with the
+	 * window's loader context current.
+	 * @param userData The user data given when queueing the upload.
+	 */
+	typedef void uploadCallback(void* userData);
+	/**
+	 * The function a resource loader calls on the render thread once everything an upload did has finished on the
+	 * GPU.  The objects the upload filled in must be bound again before their new contents are guaranteed to show up
+	 * on the render thread, which drawing them does anyway.  Vertex array objects are not shared between contexts, so
+	 * this is where to create them.
+	 * @param userData The user data given when queueing the upload.
+	 */
+	typedef void uploadReadyCallback(void* userData);
+
+	/**
+	 * A thread which uploads textures and buffers through a window's loader context, see
+	 * Window::createLoaderGLContext, so loading models and textures never stalls the render thread.  Each upload is
+	 * followed by a fence, and is only handed to the render thread once the GPU has passed that fence.  Only one
+	 * thread may queue uploads and only one thread, the one rendering, may poll for finished ones.
+	 */
+	class ResourceLoader
+	{
+	public:
+		ResourceLoader();
+		/**
+		 * Starts uploading on a new thread.  The window's loader context must already exist and must not be current
+		 * on any other thread.
+		 * @param window The window whose loader context the thread uploads with.
+		 * @return Returns true if the thread was started, false if the window has no loader context.
+		 */
+		bool Start(Window* window);
+		/**
+		 * Queues an upload for the loader thread.
+		 * @param upload The function which does the upload on the loader thread.
+		 * @param ready The function called on the render thread once the upload has finished, or NULL for none.
+		 * @param userData Passed to both functions untouched.
+		 * @return Returns true if the upload was queued, false if PV_LOADER_UPLOADS uploads are already waiting.
+		 */
+		bool Queue(uploadCallback* upload, uploadReadyCallback* ready, void* userData);
+		/**
+		 * Hands finished uploads to the render thread, in the order they were queued, by calling their ready
+		 * functions.  This never waits on the GPU, so call it once per frame from the render thread.
+		 * @return The number of uploads handed over.
+		 */
+		unsigned int Poll();
+		/**
+		 * Stops the loader thread once it has finished the upload it is working on, and waits for it to finish.
+		 * Uploads it has not started stay queued for the next Start.
+		 */
+		void Stop();
+		/**
+		 * Checks whether the loader thread is running.
+		 * @return Returns true if the thread is running, false otherwise.
+		 */
+		const bool IsRunning() const;
+		/**
+		 * Gets the number of uploads queued that have not been handed to the render thread yet.
+		 * @return The number of pending uploads.
+		 */
+		const unsigned int GetPendingCount() const;
+		/**
+		 * Stops the loader thread if it is still running.
+		 */
+		~ResourceLoader();
+	protected:
+		/**
+		 * The body of the loader thread.
+		 */
+		void run();
+
+		/**
+		 * A queued upload.
+		 */
+		struct Upload
+		{
+			/**
+			 * The function which does the upload.
+			 */
+			uploadCallback* upload;
+			/**
+			 * The function called once the upload has finished.
+			 */
+			uploadReadyCallback* ready;
+			/**
+			 * The user data passed to both functions.
+			 */
+			void* userData;
+			/**
+			 * The fence placed after the upload, or NULL if the driver has no fences and the upload was finished with
+			 * glFinish instead.
+			 */
+			pv_GLsync fence;
+		};
+
+		/**
+		 * The uploads, used as a ring.  Each passes from the queueing thread to the loader thread to the render thread.
+		 */
+		Upload uploads[PV_LOADER_UPLOADS];
+		/**
+		 * The number of uploads queued.  Only written by the queueing thread.
+		 */
+		std::atomic<unsigned int> queued;
+		/**
+		 * The number of uploads the loader thread has done and fenced.  Only written by the loader thread.
+		 */
+		std::atomic<unsigned int> uploaded;
+		/**
+		 * The number of uploads handed to the render thread.  Only written by the render thread.
+		 */
+		std::atomic<unsigned int> handedOver;
+		/**
+		 * The thread doing the uploads.
+		 */
+		std::thread thread;
+		/**
+		 * A boolean telling the loader thread to keep going.
+		 */
+		std::atomic<bool> running;
+		/**
+		 * The window whose loader context is used for uploading.
+		 */
+		Window* window;
+	};
+};
+
+#endif
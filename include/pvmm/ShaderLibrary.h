@@ -0,0 +1,183 @@
+#ifndef _SHADER_LIBRARY_H_
+#define _SHADER_LIBRARY_H_
+
+#include "pvmm/MidOpenGL.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * The most features a shader library can have, one for each bit of a permutation key.
+ */
+#define PV_SHADER_MAX_FEATURES 64
+
+namespace PV
+{
+	/**
+	 * The shader stages a feature of a shader library can change.
+	 */
+	enum ShaderStage
+	{
+		/**
+		 * The vertex shader.
+		 */
+		ShaderStageVertex = 1,
+		/**
+		 * The fragment shader.
+		 */
+		ShaderStageFragment = 2,
+		/**
+		 * Both shaders.
+		 */
+		ShaderStageBoth = 3
+	};
+
+	/**
+	 * A pair of vertex and fragment shader templates and every variant of them, such as textured or untextured, with
+	 * or without normals.  Each feature is a preprocessor definition that is either set or not, and a variant is
+	 * picked by a 64 bit permutation key with one bit per feature.  Variants are compiled on demand, or ahead of time
+	 * with Request so the driver can compile them in the background.  A compiled stage is shared by every variant
+	 * whose features for that stage are the same, so variants that only differ in the fragment shader share one
+	 * vertex shader.  A library must only be used on the thread its context is current on.
+	 */
+	class ShaderLibrary
+	{
+	public:
+		ShaderLibrary();
+		/**
+		 * Sets the shader templates.  This must be done before any variant is compiled.
+		 * @param vertexSource The vertex shader template's source code as a null terminated string.
+		 * @param fragmentSource The fragment shader template's source code as a null terminated string.
+		 */
+		void SetSource(const char* vertexSource, const char* fragmentSource);
+		/**
+		 * Loads the shader templates from files.  This must be done before any variant is compiled.
+		 * @param vertexShader The filename of the vertex shader template.
+		 * @param fragmentShader The filename of the fragment shader template.
+		 * @return Returns true if both files were read, false otherwise.
+		 */
+		bool SetSourceFiles(const char* vertexShader, const char* fragmentShader);
+		/**
+		 * Adds a feature, which variants turn on with "#define name 1".  This must be done before any variant is
+		 * compiled.
+		 * @param name The name of the definition.
+		 * @param stages The ShaderStage bits of the stages that use the definition.
+		 * @return The feature's bit in permutation keys, or 0 if the library already has PV_SHADER_MAX_FEATURES.
+		 */
+		unsigned long long AddFeature(const char* name, unsigned int stages);
+		/**
+		 * Gets the bit of a feature in permutation keys.
+		 * @param name The name of the feature.
+		 * @return The feature's bit, or 0 if the library has no such feature.
+		 */
+		const unsigned long long GetFeature(const char* name) const;
+		/**
+		 * Starts compiling variants without waiting for them.  Poll collects them once the driver is done.
+		 * @param keys The permutation keys of the variants.
+		 * @param count The number of keys.
+		 */
+		void Request(const unsigned long long* keys, unsigned int count);
+		/**
+		 * Collects the requested variants that have finished compiling, without waiting for the rest.
+		 * @return The number of variants collected.
+		 */
+		unsigned int Poll();
+		/**
+		 * Gets the program of a variant with a single hash lookup, compiling it and waiting for it if it has not
+		 * been requested or is still compiling.
+		 * @param key The permutation key of the variant.
+		 * @return The program's handle ID, or 0 if the variant failed to compile.
+		 */
+		unsigned int GetProgram(unsigned long long key);
+		/**
+		 * Checks whether a variant is ready to use without waiting.
+		 * @param key The permutation key of the variant.
+		 * @return Returns true if the variant is compiled and linked, false otherwise.
+		 */
+		const bool IsReady(unsigned long long key) const;
+		/**
+		 * Gets the number of variants compiled or compiling.
+		 * @return The number of programs.
+		 */
+		const unsigned int GetProgramCount() const;
+		/**
+		 * Gets the number of shader stages compiled so far, which is less than twice the number of programs when
+		 * stages are shared.
+		 * @return The number of shaders.
+		 */
+		const unsigned int GetShaderCount() const;
+		/**
+		 * Deletes every variant and compiled stage.  The library's context must be current.
+		 */
+		void Clear();
+	protected:
+		/**
+		 * A variant of the shaders.
+		 */
+		struct Variant
+		{
+			/**
+			 * The variant's program.
+			 */
+			unsigned int program;
+			/**
+			 * The state of the program.
+			 */
+			ShaderProgramState state;
+		};
+
+		/**
+		 * Gets the compiled shader for a stage of a variant, starting to compile it if no variant has needed it yet.
+		 * @param stage ShaderStageVertex or ShaderStageFragment.
+		 * @param key The permutation key of the variant.
+		 * @return The shader's handle ID.
+		 */
+		unsigned int getShader(ShaderStage stage, unsigned long long key);
+		/**
+		 * Starts compiling and linking a variant if it has not been already.
+		 * @param key The permutation key of the variant.
+		 */
+		void submit(unsigned long long key);
+		/**
+		 * Checks a linked variant for errors.  This waits for the driver to finish it.
+		 * @param key The permutation key of the variant.
+		 * @param variant The variant.
+		 */
+		void finish(unsigned long long key, Variant& variant);
+
+		/**
+		 * The shader templates.
+		 */
+		std::string vertexSource, fragmentSource;
+		/**
+		 * The name of each feature, by bit.
+		 */
+		std::vector<std::string> features;
+		/**
+		 * The bits of the features that each stage uses.
+		 */
+		unsigned long long vertexMask, fragmentMask;
+		/**
+		 * The variants compiled or compiling, by permutation key.
+		 */
+		std::unordered_map<unsigned long long, Variant> variants;
+		/**
+		 * The compiled vertex and fragment shaders, by the bits of their stage's features.
+		 */
+		std::unordered_map<unsigned long long, unsigned int> vertexShaders, fragmentShaders;
+		/**
+		 * The permutation keys of the variants still compiling.
+		 */
+		std::vector<unsigned long long> pending;
+		/**
+		 * Whether the driver compiles in parallel, so finished variants can be found without waiting.
+		 */
+		bool parallel;
+		/**
+		 * Whether the driver has been checked for parallel compiling yet.
+		 */
+		bool parallelChecked;
+	};
+};
+
+#endif
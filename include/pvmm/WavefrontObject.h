@@ -3,7 +3,9 @@
 
 #include "tiny_obj_loader.h"
 #include "lodepng.h"
+#include "pvmm/ResourceLoader.h"
 
+#include <string>
 #include <vector>
 
 using namespace tinyobj;
@@ -12,8 +14,18 @@ class WavefrontObject
 {
 public:
 	WavefrontObject(const char* filename);
+	/**
+	 * Loads the object on a resource loader's thread instead of the calling one.  Draw does nothing until the
+	 * render thread's ResourceLoader::Poll has handed the object over.
+	 * @param filename The object file to load.
+	 * @param loader The loader to queue the upload on.
+	 */
+	WavefrontObject(const char* filename, PV::ResourceLoader* loader);
+	const bool IsLoaded() const;
 	void Draw();
 private:
+	std::string filename;
+	bool loaded;
 	unsigned int totalShapes;
 	std::vector<unsigned int> verticesHandles;
 	std::vector<unsigned int> uvHandles;
@@ -22,7 +34,10 @@ private:
 	std::vector<unsigned int> meshSizes;
 	std::vector<unsigned int> textures;
 
+	void load(const char* filename);
 	void loadTexture(tinyobj::shape_t* shape, int spot);
+	static void upload(void* object);
+	static void ready(void* object);
 };
 
 #endif
\ No newline at end of file
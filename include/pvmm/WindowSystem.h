@@ -1,12 +1,85 @@
 #ifdef _WIN32
 #include <Windows.h>
 #include "pv/types.h"
+#include "pvmm/FramePacer.h"
+#include "pvmm/InputSnapshot.h"
+#include "Kernel/OVR_Lockless.h"
 #elif __APPLE__
 #elif __linux__
+// Keep EGL from pulling in Xlib, whose macros (None, Bool, Status, ...) collide with names used elsewhere.
+#ifndef EGL_NO_X11
+#define EGL_NO_X11
+#endif
+#include <EGL/egl.h>
+#include <wchar.h>
+#include "pv/types.h"
+#include "pvmm/FramePacer.h"
+#include "pvmm/InputSnapshot.h"
+#include "Kernel/OVR_Lockless.h"
+// The X11 types the window uses, declared here so that Xlib is only included where the window is implemented.
+struct _XDisplay;
+union _XEvent;
 #endif
 
 namespace PV
 {
+	/**
+	 * The profiles an OpenGL context can be created with.
+	 */
+	enum ContextProfile
+	{
+		/**
+		 * Every function, including those deprecated since OpenGL 3.0.
+		 */
+		ProfileCompatibility = 0,
+		/**
+		 * Only the functions of the requested version that are not deprecated, so the driver can skip tracking the
+		 * legacy state.  This needs OpenGL 3.2 or newer.
+		 */
+		ProfileCore = 1
+	};
+
+	/**
+	 * The settings a window's OpenGL context is created with.  After the context is created, the window reports
+	 * what the driver actually gave, which may differ from what was asked for.
+	 */
+	struct ContextSettings
+	{
+		/**
+		 * The OpenGL version to ask for, or 0.0 for the newest the driver offers.
+		 */
+		int majorVersion, minorVersion;
+		/**
+		 * The profile to ask for.
+		 */
+		ContextProfile profile;
+		/**
+		 * Whether to create a debug context, whose driver messages are printed as they happen.
+		 */
+		bool debug;
+		/**
+		 * Whether to create a context that skips checking calls for errors (KHR_no_error).  Invalid calls are then
+		 * undefined behaviour, but every valid call costs the driver less.  This cannot be combined with debug.
+		 */
+		bool noError;
+		/**
+		 * The number of bits in the window's depth buffer, such as 24 or 32.
+		 */
+		int depthBits;
+		/**
+		 * The number of bits in the window's stencil buffer, such as 8 or 0.
+		 */
+		int stencilBits;
+	};
+
+	/**
+	 * Gets the settings windows create their contexts with unless told otherwise: the newest compatibility
+	 * context with a 24 bit depth and 8 bit stencil buffer, debug output in debug builds and no error checking
+	 * in release builds.
+	 * @return The default settings.
+	 */
+	ContextSettings GetDefaultContextSettings();
+
 #ifdef _WIN32
 	/**
 	 * The default bits per pixel to use for an OpenGL context.
@@ -25,8 +98,8 @@ namespace PV
 		Window();
 		/**
 		* Creates a window using the given information and then returns its status.
-		* The default window process simply handles the window closing as well as changing the viewport
-		* when the window size changes.
+		* The default window process simply handles the window closing.  Whatever the window process, resizes
+		* are recorded in the input snapshots, and losing the focus lets go of every key and button.
 		* @param title The title to be displayed in the window.
 		* @return On success, this method will return 1.
 		* On fail, it will return an error code.
@@ -90,16 +163,85 @@ namespace PV
 		 * Updates the window's buffer.
 		 */
 		void Update();
+		/**
+		 * Handles every event waiting for the window without blocking, then publishes an input snapshot of the
+		 * result.  Call this once per frame from the thread that created the window, so a burst of input is
+		 * handled all at once instead of one event per frame.
+		 */
+		void PumpEvents();
+		/**
+		 * Gets the newest input snapshot published by PumpEvents.  This never blocks and is safe to call from any
+		 * thread, such as a simulation thread.
+		 * @return The newest input snapshot.
+		 */
+		const InputSnapshot GetInput();
 		/**
 		 * Sets the window to use an OpenGL drawing context.
 		 * @return Returns an error if something goes wrong when setting the drawing state.
 		 */
 		int setWindowDrawingStateGL();
+		/**
+		 * Sets what kind of OpenGL context setWindowDrawingStateGL creates.
+		 * @param settings The settings to create the context with.
+		 */
+		void setContextSettings(const ContextSettings& settings);
+		/**
+		 * Gets the settings of the window's OpenGL context.  Once the context exists, these are what the driver
+		 * actually gave rather than what was asked for.
+		 * @return The context's settings.
+		 */
+		const ContextSettings GetContextSettings();
+		/**
+		 * Sets how many vertical blanks each swap waits for, on the window's current OpenGL context.
+		 * @param interval 1 to wait for every vertical blank, 0 to never wait, or -1 for adaptive vertical sync,
+		 * which waits unless the frame is already late and then swaps right away, tearing rather than stuttering.
+		 * Adaptive vertical sync falls back to 1 where the driver does not support it.
+		 * @return Returns true if the interval was set, false if the driver refused it.
+		 */
+		bool SetSwapInterval(int interval);
+		/**
+		 * Gets the swap interval last set on the window.
+		 * @return The swap interval.
+		 */
+		const int GetSwapInterval();
+		/**
+		 * Limits how many frames Update presents per second, so the window does not burn a CPU core drawing
+		 * frames that are never seen.
+		 * @param framesPerSecond The frame limit, or 0 for none.
+		 */
+		void SetFrameLimit(double framesPerSecond);
+		/**
+		 * Gets statistics on how evenly Update has been presenting frames.
+		 * @return The statistics over the most recent frames.
+		 */
+		const FrameStats GetFrameStats();
 		/**
 		 * Makes this window the current OpenGL context for rendering to.
 		 * @return Return OK if there is no error, otherwise return the error.
 		 */
 		int MakeCurrentGLContext();
+		/**
+		 * Releases this window's OpenGL context from the calling thread, so that it can be made current on another one.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int ReleaseGLContext();
+		/**
+		 * Creates a second OpenGL context sharing textures and buffers with the window's, for a loader thread to
+		 * upload resources with while the window's context keeps rendering.  Call this after
+		 * setWindowDrawingStateGL, from the thread the window's context is current on.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int createLoaderGLContext();
+		/**
+		 * Makes the window's loader context current on the calling thread.  It may only be current on one thread at a time.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int MakeCurrentLoaderGLContext();
+		/**
+		 * Releases the window's loader context from the calling thread.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int ReleaseLoaderGLContext();
 		/**
 		 * Gets the window's handle object if it exists.
 		 * @return Returns the window's handle if it exists.  Will return NULL otherwise.
@@ -164,7 +306,22 @@ namespace PV
 		 */
 		HWND windowHandle;
 
+		/**
+		 * The context a loader thread uploads resources with, sharing objects with the rendering context, or NULL.
+		 */
+		HGLRC loaderContext;
+
 	private:
+		/**
+		 * The hidden window giving the loader context a device context of its own.
+		 */
+		HWND loaderWindowHandle;
+
+		/**
+		 * The device context of the loader's hidden window.
+		 */
+		HDC loaderDeviceContext;
+
 		unsigned int width;
 		unsigned int height;
 		RECT windowRectangle;
@@ -189,6 +346,96 @@ namespace PV
 		 */
 		int bitsPerPixel;
 
+		/**
+		 * The settings of the window's OpenGL context.
+		 */
+		ContextSettings contextSettings;
+
+		/**
+		 * The window process messages are passed on to, once the window has noted what its snapshots need.
+		 */
+		windowProcessCallback* callback;
+
+		/**
+		 * The swap interval last set on the window.
+		 */
+		int swapInterval;
+
+		/**
+		 * wglSwapIntervalEXT, loaded once the window has a context, or NULL without WGL_EXT_swap_control.
+		 */
+		PROC swapIntervalFunction;
+
+		/**
+		 * wglGetSwapIntervalEXT, loaded alongside wglSwapIntervalEXT.
+		 */
+		PROC getSwapIntervalFunction;
+
+		/**
+		 * The frame limiter and statistics used by Update.
+		 */
+		FramePacer pacer;
+
+		/**
+		 * The input snapshot PumpEvents is filling in.
+		 */
+		InputSnapshot pendingInput;
+
+		/**
+		 * A boolean indicating whether the mouse position is known, so the first movement is not taken as a jump.
+		 */
+		bool mousePositionKnown;
+
+		/**
+		 * The newest input snapshot published.
+		 */
+		OVR::LocklessUpdater<InputSnapshot, InputSnapshot> input;
+
+		/**
+		 * Clears the input state and publishes an empty snapshot.
+		 */
+		void resetInput();
+		/**
+		 * Sets the window's swap interval on the current context again if it has changed, since a context presenting
+		 * to several windows would otherwise swap each of them with whichever interval was set last.
+		 */
+		void applySwapInterval();
+		/**
+		 * The window process of every window, which notes resizes and focus changes in the window's pending
+		 * snapshot and then passes each message on to the window's callback.
+		 * @param winHandle The window the message is for.
+		 * @param message The message.
+		 * @param windowParam The message's first parameter.
+		 * @param messageParam The message's second parameter.
+		 * @return The callback's result.
+		 */
+		static LRESULT CALLBACK windowProcess(HWND winHandle, UINT message, WPARAM windowParam, LPARAM messageParam);
+		/**
+		 * Notes a key going down or up in the pending snapshot.
+		 * @param key The key code.
+		 * @param down True if the key went down, false if it was released.
+		 */
+		void setKey(unsigned int key, bool down);
+		/**
+		 * Lets go of every key and mouse button in the pending snapshot, for when the window loses the focus and
+		 * would never see them released.
+		 */
+		void releaseInput();
+		/**
+		 * Notes the mouse moving in the pending snapshot.
+		 * @param x The new mouse position from the left of the window.
+		 * @param y The new mouse position from the top of the window.
+		 */
+		void moveMouse(int x, int y);
+		/**
+		 * Publishes the pending snapshot and starts the next one.
+		 */
+		void publishInput();
+		/**
+		 * Destroys the loader context, if there is one.
+		 */
+		void destroyLoaderGLContext();
+
 		/**
 		 * An instance of the window.
 		 */
@@ -220,5 +467,366 @@ namespace PV
 	};
 #elif __APPLE__
 #elif __linux__
+	/**
+	 * The default bits per pixel to use for an OpenGL context.
+	 */
+#define DEFAULT_BITS_PER_PIXEL 32
+
+	/**
+	 * A callback given every X11 event for a window, after the window has handled it itself.
+	 */
+	typedef void windowProcessCallback(_XEvent* event);
+
+	/**
+	 * A class for creating windows on Linux, using X11 for the window and EGL for its OpenGL context.  A window can
+	 * also be created headless, with no X11 display at all, in which case it renders to an offscreen pbuffer, or to
+	 * framebuffer objects only if the driver has no pbuffers.  Headless windows let render benchmarks run on a
+	 * server with only software OpenGL such as Mesa's llvmpipe.
+	 */
+	class Window
+	{
+	public:
+		Window();
+		/**
+		* Creates a window using the given information and then returns its status.
+		* @param title The title to be displayed in the window.
+		* @return On success, this method will return 1.
+		* On fail, it will return an error code.
+		*/
+		WINDOW_ERRORS create(const wchar_t* title);
+
+		/**
+		* Creates a window using the given information and then returns its status.
+		* @param title The title to be displayed in the window.
+		* @param callback The callback to give the window's events to.
+		* @return On success, this method will return 1.
+		* On fail, it will return an error code.
+		*/
+		WINDOW_ERRORS create(const wchar_t* title, windowProcessCallback callback);
+
+		/**
+		* Creates a window using the given information and then returns its status.
+		* @param title The title to be displayed in the window.
+		* @param fullscreen If true, the window will cover the whole screen.
+		* @param callback The callback to give the window's events to.
+		* @return On success, this method will return 1.
+		* On fail, it will return an error code.
+		*/
+		WINDOW_ERRORS create(const wchar_t* title, bool fullscreen, windowProcessCallback callback);
+
+		/**
+		* Creates a window using the given information and then returns its status.
+		* @param title The title to be displayed in the window.
+		* @param width An unsigned integer for the width of the window.
+		* @param height An unsigned integer for the height of the window.
+		* @param fullscreen If true, the window will cover the whole screen.
+		* @param callback The callback to give the window's events to.
+		* @return On success, this method will return 1.
+		* On fail, it will return an error code.
+		*/
+		WINDOW_ERRORS create(const wchar_t* title, unsigned int width, unsigned int height, bool fullscreen, windowProcessCallback callback);
+
+		/**
+		 * Creates a headless window, which needs no display server.  Its OpenGL context draws into an offscreen
+		 * surface of the given size.
+		 * @param width An unsigned integer for the width of the offscreen surface.
+		 * @param height An unsigned integer for the height of the offscreen surface.
+		 * @return On success, this method will return 1.
+		 * On fail, it will return an error code.
+		 */
+		WINDOW_ERRORS createHeadless(unsigned int width, unsigned int height);
+
+		/**
+		 * Sets the callback the window's events are given to.
+		 * @param callback The function to use, or NULL for none.
+		 */
+		void setWindowProcessCallback(windowProcessCallback callback);
+
+		/**
+		 * Sets whether a window is visible or not.
+		 * @param visible If true, the window will be shown, otherwise it will be hidden.
+		 * @return This will return 1 if it was previously visible and 0 if it was previously hidden.
+		 */
+		int setVisible(bool visible);
+		/**
+		 * Sets the window as the current focus.
+		 * @return This will return 1 if the window was brought to the foreground and 0 otherwise.
+		 */
+		int Focus();
+		/**
+		 * Updates the window's buffer.
+		 */
+		void Update();
+		/**
+		 * Handles every event waiting for the window without blocking, then publishes an input snapshot of the
+		 * result.  Call this once per frame from the thread that created the window, so a burst of input is
+		 * handled all at once instead of one event per frame.
+		 */
+		void PumpEvents();
+		/**
+		 * Gets the newest input snapshot published by PumpEvents.  This never blocks and is safe to call from any
+		 * thread, such as a simulation thread.
+		 * @return The newest input snapshot.
+		 */
+		const InputSnapshot GetInput();
+		/**
+		 * Sets the window to use an OpenGL drawing context, and makes it current.
+		 * @return Returns an error if something goes wrong when setting the drawing state.
+		 */
+		int setWindowDrawingStateGL();
+		/**
+		 * Sets what kind of OpenGL context setWindowDrawingStateGL creates.
+		 * @param settings The settings to create the context with.
+		 */
+		void setContextSettings(const ContextSettings& settings);
+		/**
+		 * Gets the settings of the window's OpenGL context.  Once the context exists, these are what the driver
+		 * actually gave rather than what was asked for.
+		 * @return The context's settings.
+		 */
+		const ContextSettings GetContextSettings();
+		/**
+		 * Sets how many vertical blanks each swap waits for, on the window's current OpenGL context.
+		 * @param interval 1 to wait for every vertical blank, 0 to never wait, or -1 for adaptive vertical sync,
+		 * which waits unless the frame is already late and then swaps right away, tearing rather than stuttering.
+		 * Adaptive vertical sync falls back to 1 where the driver does not support it.
+		 * @return Returns true if the interval was set, false if the driver refused it.
+		 */
+		bool SetSwapInterval(int interval);
+		/**
+		 * Gets the swap interval last set on the window.
+		 * @return The swap interval.
+		 */
+		const int GetSwapInterval();
+		/**
+		 * Limits how many frames Update presents per second, so the window does not burn a CPU core drawing
+		 * frames that are never seen.
+		 * @param framesPerSecond The frame limit, or 0 for none.
+		 */
+		void SetFrameLimit(double framesPerSecond);
+		/**
+		 * Gets statistics on how evenly Update has been presenting frames.
+		 * @return The statistics over the most recent frames.
+		 */
+		const FrameStats GetFrameStats();
+		/**
+		 * Makes this window the current OpenGL context for rendering to.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int MakeCurrentGLContext();
+		/**
+		 * Releases this window's OpenGL context from the calling thread, so that it can be made current on another one.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int ReleaseGLContext();
+		/**
+		 * Creates a second OpenGL context sharing textures and buffers with the window's, for a loader thread to
+		 * upload resources with while the window's context keeps rendering.  Call this after
+		 * setWindowDrawingStateGL, from the thread the window's context is current on.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int createLoaderGLContext();
+		/**
+		 * Makes the window's loader context current on the calling thread.  It may only be current on one thread at a time.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int MakeCurrentLoaderGLContext();
+		/**
+		 * Releases the window's loader context from the calling thread.
+		 * @return Return OK if there is no error, otherwise return the error.
+		 */
+		int ReleaseLoaderGLContext();
+		/**
+		 * Gets whether the window is active or not.
+		 * @return Returns true until the user closes the window, false otherwise.
+		 */
+		const bool IsActive();
+		/**
+		 * Gets whether the window is headless or not.
+		 * @return Returns true if the window has no display and draws offscreen, false otherwise.
+		 */
+		const bool IsHeadless();
+		/**
+		 * Gets whether the window is fullscreen or not.
+		 * @return Returns true if the window is fullscreen, false otherwise.
+		 */
+		const bool IsFullscreen();
+		/**
+		 * Asks the window manager to make the window cover the whole screen, or to put it back.
+		 * @param fullscreen Set to true to make the window fullscreen, false otherwise.
+		 */
+		void SetFullscreen(bool fullscreen);
+		/**
+		 * Gets bits per pixel for the window.
+		 * @return Returns an integer indicating the bits per pixel for the window.
+		 */
+		const int BitsPerPixel();
+		/**
+		 * Gets the title of the window.
+		 * @return The title of the window as a wide character string.
+		 */
+		const wchar_t* Title();
+		/**
+		 * Destroys the window and closes its connection to the display.
+		 */
+		void destroy();
+		/**
+		 * Destroys the OpenGL context associated with this window.
+		 */
+		void destroyGLSystem();
+
+		/**
+		 * The EGL display the rendering context belongs to.
+		 */
+		EGLDisplay eglDisplay;
+
+		/**
+		 * The rendering context for where to draw stuff to.
+		 */
+		EGLContext renderingContext;
+
+		/**
+		 * The surface drawn to, either the window or an offscreen pbuffer.  This is EGL_NO_SURFACE for a headless
+		 * window whose driver only supports drawing into framebuffer objects.
+		 */
+		EGLSurface surface;
+
+		/**
+		 * The connection to the X11 display, or NULL for a headless window.
+		 */
+		_XDisplay* display;
+
+		/**
+		 * The X11 window ID, or 0 for a headless window.
+		 */
+		unsigned long windowHandle;
+
+		/**
+		 * The context a loader thread uploads resources with, sharing objects with the rendering context, or
+		 * EGL_NO_CONTEXT.
+		 */
+		EGLContext loaderContext;
+
+		/**
+		 * The 1x1 pbuffer the loader context is current with, or EGL_NO_SURFACE if the config has no pbuffers.
+		 */
+		EGLSurface loaderSurface;
+
+	private:
+		/**
+		 * The EGL config the window's surface and contexts were created with.
+		 */
+		EGLConfig config;
+
+		unsigned int width;
+		unsigned int height;
+
+		/**
+		 * A boolean variable indicating whether the window is active.
+		 */
+		bool active;
+
+		/**
+		 * A boolean variable indicating whether the window is fullscreen or not.
+		 */
+		bool isFullscreen;
+
+		/**
+		 * A boolean variable indicating whether the window is headless.
+		 */
+		bool headless;
+
+		/**
+		 * The bits per pixel for this window.
+		 */
+		int bitsPerPixel;
+
+		/**
+		 * The settings of the window's OpenGL context.
+		 */
+		ContextSettings contextSettings;
+
+		/**
+		 * The swap interval last set on the window.
+		 */
+		int swapInterval;
+
+		/**
+		 * The frame limiter and statistics used by Update.
+		 */
+		FramePacer pacer;
+
+		/**
+		 * The input snapshot PumpEvents is filling in.
+		 */
+		InputSnapshot pendingInput;
+
+		/**
+		 * A boolean indicating whether the mouse position is known, so the first movement is not taken as a jump.
+		 */
+		bool mousePositionKnown;
+
+		/**
+		 * The newest input snapshot published.
+		 */
+		OVR::LocklessUpdater<InputSnapshot, InputSnapshot> input;
+
+		/**
+		 * Clears the input state and publishes an empty snapshot.
+		 */
+		void resetInput();
+		/**
+		 * Notes a key going down or up in the pending snapshot.
+		 * @param key The key code.
+		 * @param down True if the key went down, false if it was released.
+		 */
+		void setKey(unsigned int key, bool down);
+		/**
+		 * Lets go of every key and mouse button in the pending snapshot, for when the window loses the focus and
+		 * would never see them released.
+		 */
+		void releaseInput();
+		/**
+		 * Notes the mouse moving in the pending snapshot.
+		 * @param x The new mouse position from the left of the window.
+		 * @param y The new mouse position from the top of the window.
+		 */
+		void moveMouse(int x, int y);
+		/**
+		 * Publishes the pending snapshot and starts the next one.
+		 */
+		void publishInput();
+		/**
+		 * Destroys the loader context, if there is one.
+		 */
+		void destroyLoaderGLContext();
+
+		/**
+		 * The window's title.
+		 */
+		const wchar_t* title;
+
+		/**
+		 * The callback the window's events are given to, or NULL.
+		 */
+		windowProcessCallback* callback;
+
+		/**
+		 * The atom the window manager sends in a client message when the user closes the window.
+		 */
+		unsigned long deleteMessage;
+
+		/**
+		 * Creates a window using the given information.  If an error occurs, it is returned.
+		 * @param title The title to be displayed in the window.
+		 * @param width An unsigned integer for the width of the window.
+		 * @param height An unsigned integer for the height of the window.
+		 * @param fullscreen If true, the window will cover the whole screen.
+		 * @param bitsPerPixel The bits per pixel to use for the window.
+		 * @return On success, this method will return 1.
+		 * On fail, it will return an error code.
+		 */
+		WINDOW_ERRORS create(const wchar_t* title, unsigned int width, unsigned int height, bool fullscreen, int bitsPerPixel);
+	};
 #endif
 };
\ No newline at end of file
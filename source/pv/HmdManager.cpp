@@ -0,0 +1,103 @@
+#include "pv/HmdManager.h"
+#include <stdio.h>
+
+namespace PV
+{
+	HmdManager::HmdManager()
+	{
+		InitRift();
+		this->nextHmd = 0;
+	}
+
+	HmdManager::~HmdManager()
+	{
+		// The first headset owns the shared objects, so it has to be the last one destroyed.
+		for (int i = (int)this->rifts.size() - 1; i >= 0; i -= 1)
+		{
+			wglMakeCurrent(this->deviceContexts[i], this->contexts[i]);
+			delete this->rifts[i];
+		}
+		wglMakeCurrent(NULL, NULL);
+		ShutdownRift();
+	}
+
+	const int HmdManager::DetectDevices() const
+	{
+		return ovrHmd_Detect();
+	}
+
+	OculusRift* HmdManager::Add(bool useDemoRift, HGLRC openGlContext, HWND window, HDC deviceContext)
+	{
+		if (!this->contexts.empty() && !wglShareLists(this->contexts[0], openGlContext))
+		{
+			printf("Error sharing OpenGL objects with the first headset's context!\n");
+			return NULL;
+		}
+		wglMakeCurrent(deviceContext, openGlContext);
+
+		OculusRift* rift = new OculusRift(this->nextHmd, useDemoRift, openGlContext, window, deviceContext);
+		if (!rift->isConnected())
+		{
+			delete rift;
+			return NULL;
+		}
+		if (!rift->isVirtuallyConnected())
+		{
+			this->nextHmd += 1;
+		}
+
+		this->rifts.push_back(rift);
+		this->contexts.push_back(openGlContext);
+		this->deviceContexts.push_back(deviceContext);
+		return rift;
+	}
+
+	const unsigned int HmdManager::Size() const
+	{
+		return (const unsigned int)this->rifts.size();
+	}
+
+	OculusRift* HmdManager::operator[](const unsigned int index) const
+	{
+		return this->rifts[index];
+	}
+
+	void HmdManager::Update()
+	{
+		for (unsigned int i = 0; i < this->rifts.size(); i += 1)
+		{
+			this->rifts[i]->Update();
+		}
+	}
+
+	void HmdManager::SetHiddenAreaMask(bool enabled)
+	{
+		for (unsigned int i = 0; i < this->rifts.size(); i += 1)
+		{
+			wglMakeCurrent(this->deviceContexts[i], this->contexts[i]);
+			if (i > 0)
+			{
+				this->rifts[i]->ShareResources(*this->rifts[0]);
+			}
+			this->rifts[i]->SetHiddenAreaMask(enabled);
+		}
+	}
+
+	const double HmdManager::GetAverageRenderTime(const unsigned int index) const
+	{
+		const OculusRift* rift = this->rifts[index];
+		unsigned int count = rift->GetFrameRecordCount();
+		if (count == 0)
+		{
+			return 0.0;
+		}
+
+		double total = 0.0;
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			const FrameRecord& record = rift->GetFrameRecord(i);
+			total += record.eyeRenderDuration[0] + record.eyeRenderDuration[1];
+		}
+		return total / count;
+	}
+};
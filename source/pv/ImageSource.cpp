@@ -0,0 +1,167 @@
+#include "pv/ImageSource.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define PV_POINT_CLOUD_SSE
+#include <emmintrin.h>
+#endif
+
+namespace PV
+{
+	ImagePool::ImagePool(ImageFormat format, unsigned int width, unsigned int height) : latest(NULL), dropped(0)
+	{
+		unsigned int bytesPerPixel = (format == ImageDepthPacked) ? 2 : 4;
+		unsigned int pitch = (width * bytesPerPixel + PV_IMAGE_ALIGNMENT - 1) / PV_IMAGE_ALIGNMENT * PV_IMAGE_ALIGNMENT;
+		size_t frameSize = (size_t)pitch * height;
+
+		// One allocation for every frame, padded so the first can start on an aligned address.
+		this->memory = (unsigned char*)malloc(frameSize * PV_IMAGE_POOL_SIZE + PV_IMAGE_ALIGNMENT);
+		unsigned char* aligned = (unsigned char*)(((size_t)this->memory + PV_IMAGE_ALIGNMENT - 1) & ~(size_t)(PV_IMAGE_ALIGNMENT - 1));
+		for (int i = 0; i < PV_IMAGE_POOL_SIZE; i += 1)
+		{
+			ImageFrame& frame = this->frames[i];
+			frame.pixels = (this->memory != NULL) ? aligned + frameSize * i : NULL;
+			frame.width = width;
+			frame.height = height;
+			frame.pitch = pitch;
+			frame.format = format;
+			frame.time = 0.0;
+			frame.frameIndex = 0;
+			frame.pool = this;
+			// A pool that could not be allocated never hands out any frames.
+			frame.references = (this->memory != NULL) ? 0 : 1;
+		}
+		this->published = 0;
+	}
+
+	ImageFrame* ImagePool::Acquire()
+	{
+		for (int i = 0; i < PV_IMAGE_POOL_SIZE; i += 1)
+		{
+			int free = 0;
+			if (this->frames[i].references.compare_exchange_strong(free, 1))
+			{
+				return &this->frames[i];
+			}
+		}
+		this->dropped += 1;
+		return NULL;
+	}
+
+	void ImagePool::Publish(ImageFrame* frame)
+	{
+		this->published += 1;
+		frame->frameIndex = this->published;
+		ImageFrame* previous = this->latest.exchange(frame);
+		if (previous != NULL)
+		{
+			this->Release(previous);
+		}
+	}
+
+	ImageFrame* ImagePool::AcquireLatest()
+	{
+		for (;;)
+		{
+			ImageFrame* frame = this->latest;
+			if (frame == NULL)
+			{
+				return NULL;
+			}
+
+			// Only take a reference if somebody still holds one, since a free frame may be refilled at any moment.
+			int references = frame->references;
+			if (references <= 0 || !frame->references.compare_exchange_weak(references, references + 1))
+			{
+				continue;
+			}
+			// The frame may have been freed and refilled between reading it and taking the reference, in which
+			// case it is only safe to keep if the producer has finished with it and published it again.
+			if (this->latest == frame)
+			{
+				return frame;
+			}
+			this->Release(frame);
+		}
+	}
+
+	void ImagePool::Release(ImageFrame* frame)
+	{
+		frame->references -= 1;
+	}
+
+	const unsigned int ImagePool::GetDroppedCount() const
+	{
+		return this->dropped;
+	}
+
+	ImagePool::~ImagePool()
+	{
+		free(this->memory);
+	}
+
+	void ReleaseImage(ImageFrame* frame)
+	{
+		if (frame != NULL)
+		{
+			frame->pool->Release(frame);
+		}
+	}
+
+	DepthCamera GetKinectDepthCamera(unsigned int width, unsigned int height)
+	{
+		// NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS, which is given for 320x240 images.
+		const float focalLength = 285.63f * width / 320.0f;
+		DepthCamera camera = { focalLength, focalLength, width * 0.5f, height * 0.5f };
+		return camera;
+	}
+
+	void DepthToPointCloud(const ImageFrame& depth, const DepthCamera& camera, float* x, float* y, float* z)
+	{
+		const float inverseFocalX = 1.0f / camera.focalX;
+		const float inverseFocalY = 1.0f / camera.focalY;
+		for (unsigned int row = 0; row < depth.height; row += 1)
+		{
+			const unsigned short* pixels = (const unsigned short*)(depth.pixels + (size_t)depth.pitch * row);
+			float* rowX = x + (size_t)depth.width * row;
+			float* rowY = y + (size_t)depth.width * row;
+			float* rowZ = z + (size_t)depth.width * row;
+			// Image rows go down while y goes up.
+			const float scaleY = (camera.centerY - row) * inverseFocalY;
+			unsigned int column = 0;
+#ifdef PV_POINT_CLOUD_SSE
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 millimeters = _mm_set1_ps(0.001f);
+			const __m128 rowScale = _mm_set1_ps(scaleY);
+			const __m128 inverseFocal = _mm_set1_ps(inverseFocalX);
+			const __m128 four = _mm_set1_ps(4.0f);
+			__m128 offset = _mm_sub_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(camera.centerX));
+			for (; column + 8 <= depth.width; column += 8)
+			{
+				// Rows are aligned, so eight depth pixels can be loaded at once, unpacked and widened to floats.
+				__m128i packed = _mm_srli_epi16(_mm_load_si128((const __m128i*)(pixels + column)), PV_DEPTH_SHIFT);
+				__m128 depthLow = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, zero)), millimeters);
+				__m128 depthHigh = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(packed, zero)), millimeters);
+
+				_mm_storeu_ps(rowX + column, _mm_mul_ps(_mm_mul_ps(offset, inverseFocal), depthLow));
+				_mm_storeu_ps(rowY + column, _mm_mul_ps(rowScale, depthLow));
+				_mm_storeu_ps(rowZ + column, depthLow);
+				offset = _mm_add_ps(offset, four);
+
+				_mm_storeu_ps(rowX + column + 4, _mm_mul_ps(_mm_mul_ps(offset, inverseFocal), depthHigh));
+				_mm_storeu_ps(rowY + column + 4, _mm_mul_ps(rowScale, depthHigh));
+				_mm_storeu_ps(rowZ + column + 4, depthHigh);
+				offset = _mm_add_ps(offset, four);
+			}
+#endif
+			for (; column < depth.width; column += 1)
+			{
+				float meters = (pixels[column] >> PV_DEPTH_SHIFT) * 0.001f;
+				rowX[column] = (column - camera.centerX) * inverseFocalX * meters;
+				rowY[column] = scaleY * meters;
+				rowZ[column] = meters;
+			}
+		}
+	}
+};
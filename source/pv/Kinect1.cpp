@@ -1,18 +1,33 @@
 #include "pv/Kinect1.h"
+#include <string.h>
+#include <chrono>
 
 namespace PV
 {
 #ifdef _WIN32
 #ifndef EXCLUDE_KINECT1
-	Kinect1::Kinect1()
+	Kinect1::Kinect1() : Kinect1(0)
 	{
-		this->status = NotDetected;
-		this->InitializeSensor(0);
 	}
 
-	Kinect1::Kinect1(int index)
+	Kinect1::Kinect1(int index) : depthImages(ImageDepthPacked, 640, 480), colorImages(ImageColorBGRA, 640, 480),
+		streaming(false), recorder(NULL), replay(NULL), filter(NULL)
 	{
+		this->sensor = NULL;
+		this->nextSkeletonEvent = NULL;
+		this->nextDepthEvent = NULL;
+		this->nextColorEvent = NULL;
+		this->depthStream = NULL;
+		this->colorStream = NULL;
 		this->status = NotDetected;
+
+		// Publish an empty set into both slots so reading before the first frame gives nobody tracked.
+		KinectSkeletons empty;
+		memset(&empty, 0, sizeof(empty));
+		empty.mainPerson = -1;
+		this->skeletons.SetState(empty);
+		this->skeletons.SetState(empty);
+
 		this->InitializeSensor(index);
 	}
 
@@ -28,9 +43,31 @@ namespace PV
 				if (NuiCreateSensorByIndex(index, &this->sensor) > -1)
 				{
 					this->nextSkeletonEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
-					this->sensor->NuiInitialize(NUI_INITIALIZE_FLAG_USES_DEPTH | NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_SKELETON);
+					this->nextDepthEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+					this->nextColorEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+					this->sensor->NuiInitialize(NUI_INITIALIZE_FLAG_USES_DEPTH_AND_PLAYER_INDEX | NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_SKELETON);
 					this->sensor->NuiSkeletonTrackingEnable(this->nextSkeletonEvent, 0);
+					// Two frames each, so the image thread can be copying one while the sensor fills the other.
+					if (FAILED(this->sensor->NuiImageStreamOpen(NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX, NUI_IMAGE_RESOLUTION_640x480, 0, 2, this->nextDepthEvent, &this->depthStream)))
+					{
+						this->depthStream = NULL;
+					}
+					if (FAILED(this->sensor->NuiImageStreamOpen(NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, this->nextColorEvent, &this->colorStream)))
+					{
+						this->colorStream = NULL;
+					}
 					status = this->status = Ready;
+
+					// Skeleton frames are waited on, smoothed and published on their own thread from here on.
+					if (!this->streaming)
+					{
+						this->streaming = true;
+						this->skeletonThread = std::thread(&Kinect1::runSkeletons, this);
+					}
+					if (this->depthStream != NULL || this->colorStream != NULL)
+					{
+						this->imageThread = std::thread(&Kinect1::runImages, this);
+					}
 				}
 				else if (this->sensor == NULL)
 				{
@@ -47,25 +84,337 @@ namespace PV
 		return this->status;
 	}
 	
-	const NUI_SKELETON_DATA Kinect1::getMainPerson()
+	const NUI_SKELETON_DATA Kinect1::getMainPerson() const
+	{
+		const KinectSkeletons latest = this->skeletons.GetState();
+		if (latest.mainPerson >= 0)
+		{
+			return latest.frame.SkeletonData[latest.mainPerson];
+		}
+
+		NUI_SKELETON_DATA nobody;
+		memset(&nobody, 0, sizeof(nobody));
+		nobody.eTrackingState = NUI_SKELETON_NOT_TRACKED;
+		return nobody;
+	}
+
+	const KinectSkeletons Kinect1::GetSkeletons() const
+	{
+		return this->skeletons.GetState();
+	}
+
+	const bool Kinect1::IsProducing() const
+	{
+		return this->streaming;
+	}
+
+	/**
+	 * Copies the skeletons of a Kinect frame into the platform independent layout.
+	 * @param latest The Kinect skeletons to copy.
+	 * @param frame The frame to copy them into.
+	 */
+	static void toSkeletonFrame(const KinectSkeletons& latest, SkeletonFrame& frame)
 	{
-		if (this->status == Ready)
+		for (int person = 0; person < PV_SKELETON_PEOPLE && person < NUI_SKELETON_COUNT; person += 1)
 		{
-			NUI_SKELETON_FRAME frame;
-			this->sensor->NuiSkeletonGetNextFrame(0, &frame);
+			const NUI_SKELETON_DATA& skeleton = latest.frame.SkeletonData[person];
+			frame.tracked[person] = skeleton.eTrackingState == NUI_SKELETON_TRACKED;
+			frame.center[person][0] = skeleton.Position.x;
+			frame.center[person][1] = skeleton.Position.y;
+			frame.center[person][2] = skeleton.Position.z;
+			for (int joint = 0; joint < PV_SKELETON_JOINTS; joint += 1)
+			{
+				frame.x[person][joint] = skeleton.SkeletonPositions[joint].x;
+				frame.y[person][joint] = skeleton.SkeletonPositions[joint].y;
+				frame.z[person][joint] = skeleton.SkeletonPositions[joint].z;
+				frame.jointStates[person][joint] = (unsigned char)skeleton.eSkeletonPositionTrackingState[joint];
+			}
+		}
+		frame.mainPerson = latest.mainPerson;
+		frame.time = latest.time;
+		frame.frameIndex = latest.frameIndex;
+	}
+
+	/**
+	 * Copies the joint positions of a frame in the platform independent layout back into a Kinect frame.
+	 * @param frame The frame to copy the positions from.
+	 * @param latest The Kinect skeletons to copy them into.
+	 */
+	static void fromSkeletonFrame(const SkeletonFrame& frame, KinectSkeletons& latest)
+	{
+		for (int person = 0; person < PV_SKELETON_PEOPLE && person < NUI_SKELETON_COUNT; person += 1)
+		{
+			if (!frame.tracked[person])
+			{
+				continue;
+			}
+			NUI_SKELETON_DATA& skeleton = latest.frame.SkeletonData[person];
+			for (int joint = 0; joint < PV_SKELETON_JOINTS; joint += 1)
+			{
+				skeleton.SkeletonPositions[joint].x = frame.x[person][joint];
+				skeleton.SkeletonPositions[joint].y = frame.y[person][joint];
+				skeleton.SkeletonPositions[joint].z = frame.z[person][joint];
+			}
+		}
+	}
+
+	void Kinect1::GetLatestFrame(SkeletonFrame& frame) const
+	{
+		toSkeletonFrame(this->skeletons.GetState(), frame);
+	}
+
+	void Kinect1::SetFilter(SkeletonFilter* filter)
+	{
+		this->filter = filter;
+	}
+
+	const bool Kinect1::IsProducingImages() const
+	{
+		return this->streaming && (this->depthStream != NULL || this->colorStream != NULL);
+	}
+
+	ImageFrame* Kinect1::AcquireLatestImage(ImageFormat format)
+	{
+		return (format == ImageDepthPacked) ? this->depthImages.AcquireLatest() : this->colorImages.AcquireLatest();
+	}
+
+	const unsigned int Kinect1::GetDroppedImageCount() const
+	{
+		return this->depthImages.GetDroppedCount() + this->colorImages.GetDroppedCount();
+	}
+
+	void Kinect1::SetRecorder(SensorRecorder* recorder)
+	{
+		this->recorder = recorder;
+	}
+
+	void Kinect1::SetReplay(SensorReplay* replay)
+	{
+		this->replay = replay;
+		if (replay != NULL && !this->streaming)
+		{
+			this->streaming = true;
+			this->skeletonThread = std::thread(&Kinect1::runSkeletons, this);
+		}
+	}
+
+	void Kinect1::runSkeletons()
+	{
+		const NUI_TRANSFORM_SMOOTH_PARAMETERS VerySmoothParams = { 0.7f, 0.3f, 1.0f, 1.0f, 1.0f };
+		KinectSkeletons latest;
+		latest.frameIndex = 0;
+		int replayedSkeleton = -1;
+		SkeletonFrame filtered;
+
+		while (this->streaming)
+		{
+			SensorReplay* replay = this->replay;
+			if (replay != NULL)
+			{
+				// Play back at the sensor's 30 frames per second.
+				std::this_thread::sleep_for(std::chrono::milliseconds(33));
+				int index = replay->FindSkeleton(replay->GetTime());
+				if (index < 0 || index == replayedSkeleton)
+				{
+					continue;
+				}
+				replayedSkeleton = index;
+
+				const CapturedSkeleton& captured = replay->GetSkeleton(index);
+				memset(&latest.frame, 0, sizeof(latest.frame));
+				if (captured.tracked)
+				{
+					NUI_SKELETON_DATA& skeleton = latest.frame.SkeletonData[0];
+					skeleton.eTrackingState = NUI_SKELETON_TRACKED;
+					for (int i = 0; i < PV_CAPTURE_JOINTS && i < NUI_SKELETON_POSITION_COUNT; i += 1)
+					{
+						skeleton.SkeletonPositions[i].x = captured.joints[i][0];
+						skeleton.SkeletonPositions[i].y = captured.joints[i][1];
+						skeleton.SkeletonPositions[i].z = captured.joints[i][2];
+						skeleton.SkeletonPositions[i].w = 1.0f;
+						skeleton.eSkeletonPositionTrackingState[i] = (NUI_SKELETON_POSITION_TRACKING_STATE)captured.jointStates[i];
+					}
+					skeleton.Position = skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HIP_CENTER];
+				}
+			}
+			else
+			{
+				// Wake up now and then even without a frame, so stopping never waits on the sensor.
+				if (this->nextSkeletonEvent == NULL)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+					continue;
+				}
+				if (WaitForSingleObject(this->nextSkeletonEvent, 100) != WAIT_OBJECT_0)
+				{
+					continue;
+				}
+				if (FAILED(this->sensor->NuiSkeletonGetNextFrame(0, &latest.frame)))
+				{
+					// The event is manual reset and stays signalled after a failed read, so reset it and wait for
+					// the next frame instead of retrying this one in a busy loop.
+					ResetEvent(this->nextSkeletonEvent);
+					continue;
+				}
+			}
 
-			const NUI_TRANSFORM_SMOOTH_PARAMETERS VerySmoothParams = { 0.7f, 0.3f, 1.0f, 1.0f, 1.0f };
-			this->sensor->NuiTransformSmooth(&frame, &VerySmoothParams);
+			latest.mainPerson = -1;
+			for (int i = 0; i < NUI_SKELETON_COUNT; i += 1)
+			{
+				if (latest.frame.SkeletonData[i].eTrackingState == NUI_SKELETON_TRACKED)
+				{
+					latest.mainPerson = i;
+					break;
+				}
+			}
+			latest.time = ovr_GetTimeInSeconds();
+
+			// Frames are recorded as the sensor gave them, before any smoothing, so a replay goes through the
+			// same smoothing or filter as a live frame instead of being smoothed twice.
+			SensorRecorder* recorder = this->recorder;
+			if (recorder != NULL)
+			{
+				CapturedSkeleton captured;
+				memset(&captured, 0, sizeof(captured));
+				captured.tracked = latest.mainPerson >= 0;
+				if (captured.tracked)
+				{
+					const NUI_SKELETON_DATA& skeleton = latest.frame.SkeletonData[latest.mainPerson];
+					for (int i = 0; i < PV_CAPTURE_JOINTS && i < NUI_SKELETON_POSITION_COUNT; i += 1)
+					{
+						captured.joints[i][0] = skeleton.SkeletonPositions[i].x;
+						captured.joints[i][1] = skeleton.SkeletonPositions[i].y;
+						captured.joints[i][2] = skeleton.SkeletonPositions[i].z;
+						captured.jointStates[i] = (unsigned char)skeleton.eSkeletonPositionTrackingState[i];
+					}
+				}
+				recorder->AddSkeleton(latest.time, captured);
+			}
 
-			for (int i = 0; i < NUI_SKELETON_COUNT; i++)
+			// Replays are filtered too, so different filters can be compared on the same recording.  Without a
+			// filter the sensor's own smoothing is used, which needs a sensor even when replaying.
+			SkeletonFilter* filter = this->filter;
+			if (filter != NULL)
+			{
+				toSkeletonFrame(latest, filtered);
+				filter->Apply(filtered);
+				fromSkeletonFrame(filtered, latest);
+			}
+			else if (this->sensor != NULL)
 			{
-				this->mainSkeleton = frame.SkeletonData[i];
+				this->sensor->NuiTransformSmooth(&latest.frame, &VerySmoothParams);
+			}
+			latest.frameIndex += 1;
+			this->skeletons.SetState(latest);
+		}
+	}
+
+	void Kinect1::readImage(HANDLE stream, HANDLE event, ImagePool& images)
+	{
+		NUI_IMAGE_FRAME image;
+		if (FAILED(this->sensor->NuiImageStreamGetNextFrame(stream, 0, &image)))
+		{
+			// Like the skeleton event, the stream's event stays signalled after a failed read.
+			ResetEvent(event);
+			return;
+		}
 
-				if (this->mainSkeleton.eTrackingState == NUI_SKELETON_TRACKING_STATE::NUI_SKELETON_TRACKED)
+		// The image is copied once, straight from the sensor's buffer into a pooled frame, and from then on
+		// readers share that frame instead of copying it again.
+		ImageFrame* frame = images.Acquire();
+		NUI_LOCKED_RECT locked;
+		if (frame != NULL && SUCCEEDED(image.pFrameTexture->LockRect(0, &locked, NULL, 0)))
+		{
+			unsigned int rowSize = frame->width * ((frame->format == ImageDepthPacked) ? 2 : 4);
+			if ((unsigned int)locked.Pitch == frame->pitch)
+			{
+				memcpy(frame->pixels, locked.pBits, (size_t)frame->pitch * frame->height);
+			}
+			else
+			{
+				for (unsigned int row = 0; row < frame->height; row += 1)
 				{
-					return this->mainSkeleton;
+					memcpy(frame->pixels + (size_t)frame->pitch * row, locked.pBits + (size_t)locked.Pitch * row, rowSize);
 				}
 			}
+			image.pFrameTexture->UnlockRect(0);
+			frame->time = ovr_GetTimeInSeconds();
+			images.Publish(frame);
+		}
+		else
+		{
+			ReleaseImage(frame);
+		}
+		this->sensor->NuiImageStreamReleaseFrame(stream, &image);
+	}
+
+	void Kinect1::runImages()
+	{
+		HANDLE events[2];
+		HANDLE streams[2];
+		ImagePool* pools[2];
+		DWORD count = 0;
+		if (this->depthStream != NULL)
+		{
+			events[count] = this->nextDepthEvent;
+			streams[count] = this->depthStream;
+			pools[count] = &this->depthImages;
+			count += 1;
+		}
+		if (this->colorStream != NULL)
+		{
+			events[count] = this->nextColorEvent;
+			streams[count] = this->colorStream;
+			pools[count] = &this->colorImages;
+			count += 1;
+		}
+
+		while (this->streaming)
+		{
+			// Wake up now and then even without an image, so stopping never waits on the sensor.
+			DWORD signalled = WaitForMultipleObjects(count, events, FALSE, 100);
+			if (signalled >= WAIT_OBJECT_0 + count)
+			{
+				continue;
+			}
+			// Both streams may be ready, so check each rather than only the one that woke the thread.
+			for (DWORD i = 0; i < count; i += 1)
+			{
+				if (WaitForSingleObject(events[i], 0) == WAIT_OBJECT_0)
+				{
+					this->readImage(streams[i], events[i], *pools[i]);
+				}
+			}
+		}
+	}
+
+	Kinect1::~Kinect1()
+	{
+		if (this->streaming)
+		{
+			this->streaming = false;
+			this->skeletonThread.join();
+		}
+		if (this->imageThread.joinable())
+		{
+			this->imageThread.join();
+		}
+		if (this->sensor != NULL)
+		{
+			this->sensor->NuiShutdown();
+			this->sensor->Release();
+		}
+		if (this->nextSkeletonEvent != NULL)
+		{
+			CloseHandle(this->nextSkeletonEvent);
+		}
+		if (this->nextDepthEvent != NULL)
+		{
+			CloseHandle(this->nextDepthEvent);
+		}
+		if (this->nextColorEvent != NULL)
+		{
+			CloseHandle(this->nextColorEvent);
 		}
 	}
 #endif
@@ -42,6 +42,37 @@ namespace PV
 	pv_glFramebufferRenderbufferFunction pv_glFramebufferRenderbuffer = NULL;
 	pv_glCheckFramebufferStatusFunction pv_glCheckFramebufferStatus = NULL;
 	pv_glGenerateMipmapFunction pv_glGenerateMipmap = NULL;
+	pv_glBufferSubDataFunction pv_glBufferSubData = NULL;
+	pv_glDeleteBuffersFunction pv_glDeleteBuffers = NULL;
+	pv_glBindBufferRangeFunction pv_glBindBufferRange = NULL;
+	pv_glGetUniformBlockIndexFunction pv_glGetUniformBlockIndex = NULL;
+	pv_glUniformBlockBindingFunction pv_glUniformBlockBinding = NULL;
+	pv_glBufferStorageFunction pv_glBufferStorage = NULL;
+	pv_glMapBufferRangeFunction pv_glMapBufferRange = NULL;
+	pv_glUnmapBufferFunction pv_glUnmapBuffer = NULL;
+	pv_glDeleteProgramFunction pv_glDeleteProgram = NULL;
+	pv_glDeleteVertexArraysFunction pv_glDeleteVertexArrays = NULL;
+	pv_glGenQueriesFunction pv_glGenQueries = NULL;
+	pv_glDeleteQueriesFunction pv_glDeleteQueries = NULL;
+	pv_glBeginQueryFunction pv_glBeginQuery = NULL;
+	pv_glEndQueryFunction pv_glEndQuery = NULL;
+	pv_glGetQueryObjectuivFunction pv_glGetQueryObjectuiv = NULL;
+	pv_glBlitFramebufferFunction pv_glBlitFramebuffer = NULL;
+	pv_glDeleteFramebuffersFunction pv_glDeleteFramebuffers = NULL;
+	pv_glDeleteRenderbuffersFunction pv_glDeleteRenderbuffers = NULL;
+	pv_glDebugMessageCallbackFunction pv_glDebugMessageCallback = NULL;
+	pv_glDebugMessageControlFunction pv_glDebugMessageControl = NULL;
+	pv_glGetFramebufferAttachmentParameterivFunction pv_glGetFramebufferAttachmentParameteriv = NULL;
+	pv_glFenceSyncFunction pv_glFenceSync = NULL;
+	pv_glClientWaitSyncFunction pv_glClientWaitSync = NULL;
+	pv_glDeleteSyncFunction pv_glDeleteSync = NULL;
+	pv_glDetachShaderFunction pv_glDetachShader = NULL;
+	pv_glGetProgramBinaryFunction pv_glGetProgramBinary = NULL;
+	pv_glProgramBinaryFunction pv_glProgramBinary = NULL;
+	pv_glProgramParameteriFunction pv_glProgramParameteri = NULL;
+	pv_glGetStringiFunction pv_glGetStringi = NULL;
+	pv_glMaxShaderCompilerThreadsKHRFunction pv_glMaxShaderCompilerThreadsKHR = NULL;
+	pv_glClipControlFunction pv_glClipControl = NULL;
 #include <stdio.h>
 	void initMinGL()
 	{
@@ -87,6 +118,37 @@ namespace PV
 		pv_glFramebufferRenderbuffer = (pv_glFramebufferRenderbufferFunction)glGetProcAddress("glFramebufferRenderbuffer");
 		pv_glCheckFramebufferStatus = (pv_glCheckFramebufferStatusFunction)glGetProcAddress("glCheckFramebufferStatus");
 		pv_glGenerateMipmap = (pv_glGenerateMipmapFunction)glGetProcAddress("glGenerateMipmap");
+		pv_glBufferSubData = (pv_glBufferSubDataFunction)glGetProcAddress("glBufferSubData");
+		pv_glDeleteBuffers = (pv_glDeleteBuffersFunction)glGetProcAddress("glDeleteBuffers");
+		pv_glBindBufferRange = (pv_glBindBufferRangeFunction)glGetProcAddress("glBindBufferRange");
+		pv_glGetUniformBlockIndex = (pv_glGetUniformBlockIndexFunction)glGetProcAddress("glGetUniformBlockIndex");
+		pv_glUniformBlockBinding = (pv_glUniformBlockBindingFunction)glGetProcAddress("glUniformBlockBinding");
+		pv_glBufferStorage = (pv_glBufferStorageFunction)glGetProcAddress("glBufferStorage");
+		pv_glMapBufferRange = (pv_glMapBufferRangeFunction)glGetProcAddress("glMapBufferRange");
+		pv_glUnmapBuffer = (pv_glUnmapBufferFunction)glGetProcAddress("glUnmapBuffer");
+		pv_glDeleteProgram = (pv_glDeleteProgramFunction)glGetProcAddress("glDeleteProgram");
+		pv_glDeleteVertexArrays = (pv_glDeleteVertexArraysFunction)glGetProcAddress("glDeleteVertexArrays");
+		pv_glGenQueries = (pv_glGenQueriesFunction)glGetProcAddress("glGenQueries");
+		pv_glDeleteQueries = (pv_glDeleteQueriesFunction)glGetProcAddress("glDeleteQueries");
+		pv_glBeginQuery = (pv_glBeginQueryFunction)glGetProcAddress("glBeginQuery");
+		pv_glEndQuery = (pv_glEndQueryFunction)glGetProcAddress("glEndQuery");
+		pv_glGetQueryObjectuiv = (pv_glGetQueryObjectuivFunction)glGetProcAddress("glGetQueryObjectuiv");
+		pv_glBlitFramebuffer = (pv_glBlitFramebufferFunction)glGetProcAddress("glBlitFramebuffer");
+		pv_glDeleteFramebuffers = (pv_glDeleteFramebuffersFunction)glGetProcAddress("glDeleteFramebuffers");
+		pv_glDeleteRenderbuffers = (pv_glDeleteRenderbuffersFunction)glGetProcAddress("glDeleteRenderbuffers");
+		pv_glDebugMessageCallback = (pv_glDebugMessageCallbackFunction)glGetProcAddress("glDebugMessageCallback");
+		pv_glDebugMessageControl = (pv_glDebugMessageControlFunction)glGetProcAddress("glDebugMessageControl");
+		pv_glGetFramebufferAttachmentParameteriv = (pv_glGetFramebufferAttachmentParameterivFunction)glGetProcAddress("glGetFramebufferAttachmentParameteriv");
+		pv_glFenceSync = (pv_glFenceSyncFunction)glGetProcAddress("glFenceSync");
+		pv_glClientWaitSync = (pv_glClientWaitSyncFunction)glGetProcAddress("glClientWaitSync");
+		pv_glDeleteSync = (pv_glDeleteSyncFunction)glGetProcAddress("glDeleteSync");
+		pv_glDetachShader = (pv_glDetachShaderFunction)glGetProcAddress("glDetachShader");
+		pv_glGetProgramBinary = (pv_glGetProgramBinaryFunction)glGetProcAddress("glGetProgramBinary");
+		pv_glProgramBinary = (pv_glProgramBinaryFunction)glGetProcAddress("glProgramBinary");
+		pv_glProgramParameteri = (pv_glProgramParameteriFunction)glGetProcAddress("glProgramParameteri");
+		pv_glGetStringi = (pv_glGetStringiFunction)glGetProcAddress("glGetStringi");
+		pv_glMaxShaderCompilerThreadsKHR = (pv_glMaxShaderCompilerThreadsKHRFunction)glGetProcAddress("glMaxShaderCompilerThreadsKHR");
+		pv_glClipControl = (pv_glClipControlFunction)glGetProcAddress("glClipControl");
 	}
 };
 
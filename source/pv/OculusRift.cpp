@@ -2,21 +2,136 @@
 #include "pv/MinOpenGL.h"
 #include "pv/FileIO.h"
 #include "Kernel/OVR_Math.h"
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
 
 namespace PV
 {
+	/**
+	 * Checks whether the current context supports glClipControl.  It is core in OpenGL 4.5 and otherwise needs
+	 * ARB_clip_control, since a driver may hand back the function without supporting it.
+	 * @return Returns true if glClipControl can be used, false otherwise.
+	 */
+	static bool hasClipControl()
+	{
+		if (pv_glClipControl == NULL || pv_glGetStringi == NULL)
+		{
+			return false;
+		}
+		int majorVersion = 0;
+		int minorVersion = 0;
+		glGetIntegerv(PV_GL_MAJOR_VERSION, &majorVersion);
+		glGetIntegerv(PV_GL_MINOR_VERSION, &minorVersion);
+		if (majorVersion > 4 || (majorVersion == 4 && minorVersion >= 5))
+		{
+			return true;
+		}
+		int count = 0;
+		glGetIntegerv(PV_GL_NUM_EXTENSIONS, &count);
+		for (int i = 0; i < count; i += 1)
+		{
+			const char* extension = (const char*)pv_glGetStringi(GL_EXTENSIONS, i);
+			if (extension != NULL && strcmp(extension, "GL_ARB_clip_control") == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Adds a region to the list of regions an eye is rendered in, unless it is empty.
+	 * @param regions The list of regions to add to.
+	 * @param count The number of regions in the list, which is increased if the region is added.
+	 * @param viewport The eye's viewport.
+	 * @param x The left edge of the region.
+	 * @param y The bottom edge of the region.
+	 * @param width The width of the region.
+	 * @param height The height of the region.
+	 * @param density The density to render the region at, where anything below 1 renders it to the reduced density texture.
+	 */
+	static void addEyeRegion(EyeRegion* regions, unsigned int &count, const ovrRecti &viewport, int x, int y, int width, int height, float density)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			return;
+		}
+
+		EyeRegion& region = regions[count];
+		region.x = x;
+		region.y = y;
+		region.width = width;
+		region.height = height;
+		region.reduced = density < 1.0f;
+
+		// Scaling both edges the same way keeps neighboring regions from overlapping in the reduced density texture.
+		region.reducedX = viewport.Pos.x + (int)((x - viewport.Pos.x) * density);
+		region.reducedY = viewport.Pos.y + (int)((y - viewport.Pos.y) * density);
+		region.reducedWidth = viewport.Pos.x + (int)((x + width - viewport.Pos.x) * density) - region.reducedX;
+		region.reducedHeight = viewport.Pos.y + (int)((y + height - viewport.Pos.y) * density) - region.reducedY;
+		if (region.reducedWidth < 1)
+		{
+			region.reducedWidth = 1;
+		}
+		if (region.reducedHeight < 1)
+		{
+			region.reducedHeight = 1;
+		}
+		count += 1;
+	}
+
+	/**
+	 * The number of InitRift calls not yet matched by a call to ShutdownRift.
+	 */
+	static int riftReferences = 0;
+	/**
+	 * Guards riftReferences, and keeps the SDK from being initialized on one thread while another shuts it down.
+	 */
+	static std::mutex riftReferencesMutex;
+
 	bool InitRift()
 	{
-		return ovr_Initialize();
+		std::lock_guard<std::mutex> lock(riftReferencesMutex);
+		if (riftReferences == 0 && !ovr_Initialize())
+		{
+			return false;
+		}
+		riftReferences += 1;
+		return true;
+	}
+	void ShutdownRift()
+	{
+		std::lock_guard<std::mutex> lock(riftReferencesMutex);
+		if (riftReferences > 0)
+		{
+			riftReferences -= 1;
+			if (riftReferences == 0)
+			{
+				ovr_Shutdown();
+			}
+		}
 	}
 	bool DetectDevice()
 	{
-		InitRift();
+		if (!InitRift())
+		{
+			return false;
+		}
 		bool active = false;
+		ShutdownRift();
 		return active;
 	}
-	OculusRift::OculusRift(bool useDemoRift, HGLRC openGlContext, HWND window, HDC deviceContext)
+	OculusRift::OculusRift(bool useDemoRift, HGLRC openGlContext, HWND window, HDC deviceContext) : OculusRift(0, useDemoRift, openGlContext, window, deviceContext)
+	{
+	}
+
+	OculusRift::OculusRift(unsigned int hmdIndex, bool useDemoRift, HGLRC openGlContext, HWND window, HDC deviceContext) : eyeViewMatrix(4, 4)
 	{
+		// Hold a reference to the SDK for as long as this Oculus Rift exists.
+		InitRift();
+
 		// Setup the initial values for all of the rotations.
 		this->Orientation.yaw = 0.0f;
 		this->Orientation.pitch = 0.0f;
@@ -29,15 +144,103 @@ namespace PV
 
 		this->virtuallyConnected = false;
 
+		// Nothing has been rendered yet, and late-latching is off until asked for.
+		this->frameIndex = 0;
+		this->lateLatching = false;
+		this->eyeViewBuffer = 0;
+		this->eyeViewBufferData = NULL;
+		this->eyeViewBufferStride = 0;
+
+		// No frames have been timed yet.
+		this->frameRecordsWritten = 0;
+		this->missedVsyncCount = 0;
+		memset(&this->currentFrame, 0, sizeof(this->currentFrame));
+		memset(&this->frameTiming, 0, sizeof(this->frameTiming));
+		this->eyeRenderStartTime[0] = 0.0;
+		this->eyeRenderStartTime[1] = 0.0;
+
+		// The hidden area is only masked when asked for, and nothing has been counted yet.
+		this->hiddenAreaMasking = false;
+		this->hiddenAreaProgram = 0;
+		this->hiddenAreaDepthLocation = -1;
+		this->ownsHiddenAreaProgram = false;
+		for (int i = 0; i < 2; i += 1)
+		{
+			this->hiddenAreaVertexArrays[i] = 0;
+			this->hiddenAreaBuffers[i] = 0;
+			this->hiddenAreaVertexCounts[i] = 0;
+			this->hiddenAreaFractions[i] = 0.0f;
+			this->shadedSamples[i] = 0;
+			for (int j = 0; j < PV_SAMPLE_QUERIES; j += 1)
+			{
+				this->sampleQueries[i][j] = 0;
+			}
+		}
+
+		// Each eye is rendered in one piece until multiple resolutions are asked for.
+		this->multiResolution = false;
+		this->centerSize = 1.0f;
+		this->peripheryDensity = 1.0f;
+		for (int i = 0; i < 2; i += 1)
+		{
+			this->eyeRegionCounts[i] = 0;
+			this->peripheryTextures[i] = 0;
+			this->peripheryFrameBuffers[i] = 0;
+			this->peripheryDepthBuffers[i] = 0;
+		}
+
+		// Depth uses the default range and test until reverse depth is asked for.
+		this->reverseDepth = false;
+		this->savedClipOrigin = PV_GL_LOWER_LEFT;
+		this->savedClipDepthMode = PV_GL_NEGATIVE_ONE_TO_ONE;
+		this->savedDepthFunction = GL_LESS;
+		this->savedClearDepth = 1.0f;
+
+		// Nothing is mirrored until asked for.
+		this->mirrorMode = MirrorNone;
+		this->mirrorCrop = 0.0f;
+		this->mirrorTime = 0.0;
+
+		// Nothing is being recorded until asked for.
+		this->virtualStartTime = 0.0;
+		this->recordingTrajectory = false;
+		this->recorder = NULL;
+		this->replay = NULL;
+
+		// Nothing is tracked in the background until asked for.  Publish an empty pose into both slots so
+		// reading before the first sample gives zeros rather than garbage.
+		TrackedPose emptyPose;
+		memset(&emptyPose, 0, sizeof(emptyPose));
+		emptyPose.pose.Orientation.w = 1.0f;
+		this->trackedPose.SetState(emptyPose);
+		this->trackedPose.SetState(emptyPose);
+		this->tracking = false;
+		this->trackingSamples = 0;
+		this->trackingRate = PV_TRACKING_RATE;
+		this->trackingStartTime = 0.0;
+
 		// Initialize the Oculus Rift.
-		this->Initialize();
+		this->Initialize(hmdIndex);
+
+		if (!this->connected && useDemoRift)
+		{
+			// If using a demo Oculus Rift, create a virtual DK1 from the SDK's debug HMD information.  Its
+			// poses come from the virtual trajectory, starting now.
+			this->HMD = ovrHmd_CreateDebug(ovrHmd_DK1);
+			if (this->HMD)
+			{
+				// Say that it is connected, but virtually.
+				this->connected = true;
+				this->virtuallyConnected = true;
+				this->virtualStartTime = ovr_GetTimeInSeconds();
+			}
+		}
 
 		if (this->connected)
 		{
 			// Get the list of enabled capabilities, then attach it to a window if the extend
-			// desktop capability is disabled.
-			int caps = ovrHmd_GetEnabledCaps(this->HMD);
-			if (!(ovrHmd_GetEnabledCaps(this->HMD) & ovrHmdCap_ExtendDesktop))
+			// desktop capability is disabled.  A virtual Rift has no display to attach.
+			if (!this->virtuallyConnected && !(ovrHmd_GetEnabledCaps(this->HMD) & ovrHmdCap_ExtendDesktop))
 			{
 				ovrHmd_AttachToWindow(this->HMD, window, nullptr, nullptr);
 			}
@@ -49,51 +252,18 @@ namespace PV
 		{
 			this->HMD = NULL;
 		}
-		/*
-		else if (useDemoRift)
-		{
-			// If using a demo Oculus Rift, setup the virtual data.
-
-			this->HMD.HResolution = 1280;
-			this->HMD.VResolution = 800;
-			this->HMD.HScreenSize = 0.149759993f;
-			this->HMD.VScreenSize = 0.0935999975f;
-			this->HMD.VScreenCenter = 0.0467999987f;
-			this->HMD.EyeToScreenDistance = 0.0410000011f;
-			this->HMD.LensSeparationDistance = 0.0635000020f;
-			this->HMD.InterpupillaryDistance = 0.0640000030f;
-			this->HMD.DistortionK[0] = 1.00000000f;
-			this->HMD.DistortionK[1] = 0.219999999f;
-			this->HMD.DistortionK[2] = 0.239999995f;
-			this->HMD.DistortionK[3] = 0.000000000f;
-			this->HMD.ChromaAbCorrection[0] = 0.995999992f;
-			this->HMD.ChromaAbCorrection[1] = -0.00400000019f;
-			this->HMD.ChromaAbCorrection[2] = 1.01400006f;
-			this->HMD.ChromaAbCorrection[3] = 0.000000000f;
-			this->HMD.DesktopX = 0;
-			this->HMD.DesktopY = 0;
-			this->viewport = OVR::Util::Render::Viewport(0, 0, this->HMD.HResolution, this->HMD.VResolution);
-
-			// Say that it is connected, but virtually.
-			this->connected = true;
-			this->virtuallyConnected = true;
-
-			// Setup the user's data for the Oculus Rift.
-			this->Setup(openGlContext, window, deviceContext);
-		}
-		*/
 	}
 
-	void OculusRift::Initialize()
+	void OculusRift::Initialize(unsigned int hmdIndex)
 	{
 		// Set the boolean indicating that there is an oculus rift to false.
 		this->connected = false;
 
-		// Get the number of rifts, and attach the HMD handle to the first instance of an Oculus Rift.
+		// Get the number of rifts, and attach the HMD handle to the requested instance of an Oculus Rift.
 		int rifts = ovrHmd_Detect();
-		if (rifts > 0)
+		if (rifts > (int)hmdIndex)
 		{
-			this->HMD = ovrHmd_Create(0);
+			this->HMD = ovrHmd_Create(hmdIndex);
 
 			// If the HMD was found, check that it is an Oculus Rift, then configure it's tracking and
 			// tell the class it's connected.
@@ -140,7 +310,9 @@ namespace PV
 		((ovrGLTexture&)this->eyeTextures[0]).OGL.TexId = this->leftEyeTexture;
 		((ovrGLTexture&)this->eyeTextures[1]).OGL.TexId = this->rightEyeTexture;
 		this->setupFrameBuffer();
+		this->setupSampleQueries();
 		this->SetRenderTextures(this->leftEyeTexture, this->rightEyeTexture);
+		this->updateEyeRegions();
 	}
 
 	void OculusRift::setupFrameBuffer()
@@ -170,7 +342,7 @@ namespace PV
 		pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, this->leftFrameBuffer);
 		pv_glGenRenderbuffers(1, &this->leftDepthBuffer);
 		pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, this->leftDepthBuffer);
-		pv_glRenderbufferStorage(PV_GL_RENDERBUFFER, GL_DEPTH_COMPONENT, this->renderSize.w, this->renderSize.h);
+		pv_glRenderbufferStorage(PV_GL_RENDERBUFFER, (this->reverseDepth) ? PV_GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT, this->renderSize.w, this->renderSize.h);
 		pv_glFramebufferRenderbuffer(PV_GL_FRAMEBUFFER, PV_GL_DEPTH_ATTACHMENT, PV_GL_RENDERBUFFER, this->leftDepthBuffer);
 		pv_glFramebufferTexture2D(PV_GL_FRAMEBUFFER, PV_GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->leftEyeTexture, 0);
 
@@ -179,7 +351,7 @@ namespace PV
 		pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, this->rightFrameBuffer);
 		pv_glGenRenderbuffers(1, &this->rightDepthBuffer);
 		pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, this->rightDepthBuffer);
-		pv_glRenderbufferStorage(PV_GL_RENDERBUFFER, GL_DEPTH_COMPONENT, this->renderSize.w, this->renderSize.h);
+		pv_glRenderbufferStorage(PV_GL_RENDERBUFFER, (this->reverseDepth) ? PV_GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT, this->renderSize.w, this->renderSize.h);
 		pv_glFramebufferRenderbuffer(PV_GL_FRAMEBUFFER, PV_GL_DEPTH_ATTACHMENT, PV_GL_RENDERBUFFER, this->rightDepthBuffer);
 		pv_glFramebufferTexture2D(PV_GL_FRAMEBUFFER, PV_GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->rightEyeTexture, 0);
 
@@ -187,6 +359,332 @@ namespace PV
 		pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, 0);
 	}
 
+	void OculusRift::setupPeripheryBuffers()
+	{
+		// The reduced density regions are scaled up with a single linear blit, so no mipmaps are needed.
+		for (int eye = 0; eye < 2; eye += 1)
+		{
+			glGenTextures(1, &this->peripheryTextures[eye]);
+			glBindTexture(GL_TEXTURE_2D, this->peripheryTextures[eye]);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, PV_GL_CLAMP_TO_EDGE);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, PV_GL_CLAMP_TO_EDGE);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->renderSize.w, this->renderSize.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+			pv_glGenFramebuffers(1, &this->peripheryFrameBuffers[eye]);
+			pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, this->peripheryFrameBuffers[eye]);
+			pv_glGenRenderbuffers(1, &this->peripheryDepthBuffers[eye]);
+			pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, this->peripheryDepthBuffers[eye]);
+			pv_glRenderbufferStorage(PV_GL_RENDERBUFFER, (this->reverseDepth) ? PV_GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT, this->renderSize.w, this->renderSize.h);
+			pv_glFramebufferRenderbuffer(PV_GL_FRAMEBUFFER, PV_GL_DEPTH_ATTACHMENT, PV_GL_RENDERBUFFER, this->peripheryDepthBuffers[eye]);
+			pv_glFramebufferTexture2D(PV_GL_FRAMEBUFFER, PV_GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->peripheryTextures[eye], 0);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
+		pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, 0);
+	}
+
+	void OculusRift::updateEyeRegions()
+	{
+		for (int eye = 0; eye < 2; eye += 1)
+		{
+			ovrRecti viewport = this->eyeTextures[eye].OGL.Header.RenderViewport;
+			EyeRegion* regions = this->eyeRegions[eye];
+			unsigned int& count = this->eyeRegionCounts[eye];
+			count = 0;
+
+			if (!this->multiResolution)
+			{
+				addEyeRegion(regions, count, viewport, viewport.Pos.x, viewport.Pos.y, viewport.Size.w, viewport.Size.h, 1.0f);
+				continue;
+			}
+
+			// Center the full density region on the lens's center, which is where the tangent angles are zero,
+			// and keep it inside the viewport.
+			ovrFovPort fov = this->eyes[eye].Fov;
+			float lensX = (fov.LeftTan - fov.RightTan) / (fov.LeftTan + fov.RightTan);
+			float lensY = -(fov.UpTan - fov.DownTan) / (fov.UpTan + fov.DownTan);
+			int centerWidth = (int)(viewport.Size.w * this->centerSize);
+			int centerHeight = (int)(viewport.Size.h * this->centerSize);
+			int centerX = viewport.Pos.x + (int)((lensX + 1.0f) * 0.5f * viewport.Size.w) - centerWidth / 2;
+			int centerY = viewport.Pos.y + (int)((lensY + 1.0f) * 0.5f * viewport.Size.h) - centerHeight / 2;
+			centerX = OVR::Alg::Max(viewport.Pos.x, OVR::Alg::Min(centerX, viewport.Pos.x + viewport.Size.w - centerWidth));
+			centerY = OVR::Alg::Max(viewport.Pos.y, OVR::Alg::Min(centerY, viewport.Pos.y + viewport.Size.h - centerHeight));
+
+			// The center, then full width bands below and above it, then the bands to its left and right.
+			int centerRight = centerX + centerWidth;
+			int centerTop = centerY + centerHeight;
+			int viewportRight = viewport.Pos.x + viewport.Size.w;
+			int viewportTop = viewport.Pos.y + viewport.Size.h;
+			addEyeRegion(regions, count, viewport, centerX, centerY, centerWidth, centerHeight, 1.0f);
+			addEyeRegion(regions, count, viewport, viewport.Pos.x, viewport.Pos.y, viewport.Size.w, centerY - viewport.Pos.y, this->peripheryDensity);
+			addEyeRegion(regions, count, viewport, viewport.Pos.x, centerTop, viewport.Size.w, viewportTop - centerTop, this->peripheryDensity);
+			addEyeRegion(regions, count, viewport, viewport.Pos.x, centerY, centerX - viewport.Pos.x, centerHeight, this->peripheryDensity);
+			addEyeRegion(regions, count, viewport, centerRight, centerY, viewportRight - centerRight, centerHeight, this->peripheryDensity);
+		}
+	}
+
+	void OculusRift::setupSampleQueries()
+	{
+		if (pv_glGenQueries != NULL)
+		{
+			pv_glGenQueries(PV_SAMPLE_QUERIES, this->sampleQueries[ovrEye_Left]);
+			pv_glGenQueries(PV_SAMPLE_QUERIES, this->sampleQueries[ovrEye_Right]);
+		}
+	}
+
+	void OculusRift::setupHiddenArea()
+	{
+		// The mask only writes depth, so the shaders just place the vertices on the near plane, which is at a depth
+		// of -1 normally and 1 with reverse depth.
+		const char* vertexSource =
+			"#version 150\n"
+			"in vec2 position;\n"
+			"uniform float nearDepth;\n"
+			"void main()\n"
+			"{\n"
+			"	gl_Position = vec4(position, nearDepth, 1.0);\n"
+			"}\n";
+		const char* fragmentSource =
+			"#version 150\n"
+			"out vec4 color;\n"
+			"void main()\n"
+			"{\n"
+			"	color = vec4(0.0);\n"
+			"}\n";
+
+		// A program shared by another Oculus Rift is reused, only the meshes depend on this headset's lenses.
+		if (this->hiddenAreaProgram == 0)
+		{
+			unsigned int vertex = pv_glCreateShader(PV_GL_VERTEX_SHADER);
+			unsigned int fragment = pv_glCreateShader(PV_GL_FRAGMENT_SHADER);
+			pv_glShaderSource(vertex, 1, &vertexSource, NULL);
+			pv_glShaderSource(fragment, 1, &fragmentSource, NULL);
+			pv_glCompileShader(vertex);
+			pv_glCompileShader(fragment);
+
+			this->hiddenAreaProgram = pv_glCreateProgram();
+			pv_glAttachShader(this->hiddenAreaProgram, vertex);
+			pv_glAttachShader(this->hiddenAreaProgram, fragment);
+			pv_glBindAttribLocation(this->hiddenAreaProgram, 0, "position");
+			pv_glLinkProgram(this->hiddenAreaProgram);
+			pv_glDeleteShader(vertex);
+			pv_glDeleteShader(fragment);
+
+			int linked = GL_FALSE;
+			pv_glGetProgramiv(this->hiddenAreaProgram, PV_GL_LINK_STATUS, &linked);
+			if (linked == GL_FALSE)
+			{
+				printf("Error creating the hidden area mask shader!\n");
+				pv_glDeleteProgram(this->hiddenAreaProgram);
+				this->hiddenAreaProgram = 0;
+				return;
+			}
+			this->ownsHiddenAreaProgram = true;
+		}
+		this->hiddenAreaDepthLocation = pv_glGetUniformLocation(this->hiddenAreaProgram, "nearDepth");
+
+		std::vector<float> vertices;
+		for (int eye = 0; eye < 2; eye += 1)
+		{
+			this->buildHiddenAreaMesh((ovrEyeType)eye, vertices);
+			this->hiddenAreaVertexCounts[eye] = (unsigned int)vertices.size() / 2;
+
+			pv_glGenVertexArrays(1, &this->hiddenAreaVertexArrays[eye]);
+			pv_glBindVertexArray(this->hiddenAreaVertexArrays[eye]);
+			pv_glGenBuffers(1, &this->hiddenAreaBuffers[eye]);
+			pv_glBindBuffer(PV_GL_ARRAY_BUFFER, this->hiddenAreaBuffers[eye]);
+			if (!vertices.empty())
+			{
+				pv_glBufferData(PV_GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], PV_GL_STATIC_DRAW);
+			}
+			pv_glEnableVertexAttribArray(0);
+			pv_glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+		}
+		pv_glBindVertexArray(0);
+		pv_glBindBuffer(PV_GL_ARRAY_BUFFER, 0);
+	}
+
+	void OculusRift::buildHiddenAreaMesh(ovrEyeType eye, std::vector<float> &vertices)
+	{
+		vertices.clear();
+		this->hiddenAreaFractions[eye] = 0.0f;
+
+		ovrDistortionMesh mesh;
+		ovrFovPort fov = this->eyes[eye].Fov;
+		if (!ovrHmd_CreateDistortionMesh(this->HMD, eye, fov, ovrDistortionCap_Chromatic | ovrDistortionCap_TimeWarp | ovrDistortionCap_Vignette, &mesh))
+		{
+			printf("Error creating the Oculus Rift distortion mesh!\n");
+			return;
+		}
+
+		// The distortion mesh is a square grid laid over the eye texture, with every vertex holding where in the
+		// texture it samples from.  Vertices beyond the edge of the screen are pulled in to sample from the edge,
+		// so the samples of the outer ring of vertices outline the part of the texture that is ever seen.
+		int gridSize = (int)(sqrt((float)mesh.VertexCount) + 0.5f) - 1;
+		if (gridSize < 1 || (unsigned int)((gridSize + 1) * (gridSize + 1)) != mesh.VertexCount)
+		{
+			ovrHmd_DestroyDistortionMesh(&mesh);
+			return;
+		}
+
+		// Going from tangent angles to the viewport's normalized device coordinates, the same way the SDK does,
+		// with y flipped as OpenGL's textures are upside down compared to the SDK's.
+		float scaleX = 2.0f / (fov.LeftTan + fov.RightTan);
+		float offsetX = (fov.LeftTan - fov.RightTan) * scaleX * 0.5f;
+		float scaleY = 2.0f / (fov.UpTan + fov.DownTan);
+		float offsetY = (fov.UpTan - fov.DownTan) * scaleY * 0.5f;
+
+		// Walk around the outer ring of the grid, bottom, right, top, then left.
+		std::vector<OVR::Vector2f> edge;
+		for (int i = 0; i < gridSize * 4; i += 1)
+		{
+			int side = i / gridSize;
+			int step = i % gridSize;
+			int x = (side == 0) ? step : (side == 1) ? gridSize : (side == 2) ? gridSize - step : 0;
+			int y = (side == 0) ? 0 : (side == 1) ? step : (side == 2) ? gridSize : gridSize - step;
+			const ovrDistortionVertex& vertex = mesh.pVertexData[x + y * (gridSize + 1)];
+
+			// Chromatic aberration makes each color sample from a slightly different spot, so keep whichever
+			// reaches out the furthest.
+			const ovrVector2f samples[3] = { vertex.TanEyeAnglesR, vertex.TanEyeAnglesG, vertex.TanEyeAnglesB };
+			OVR::Vector2f furthest(0.0f, 0.0f);
+			float furthestExtent = -1.0f;
+			for (int j = 0; j < 3; j += 1)
+			{
+				OVR::Vector2f point(samples[j].x * scaleX + offsetX, -(samples[j].y * scaleY + offsetY));
+				float extent = OVR::Alg::Max(fabsf(point.x), fabsf(point.y));
+				if (extent > furthestExtent)
+				{
+					furthest = point;
+					furthestExtent = extent;
+				}
+			}
+
+			// Push the outline out a little, since the straight edges between vertices cut slightly inside
+			// the curved edge of what is seen.
+			edge.push_back(furthest * 1.02f);
+		}
+		ovrHmd_DestroyDistortionMesh(&mesh);
+
+		// Fill the space between the outline and the edge of the viewport with a strip of triangles, pushing
+		// each outline point straight out from the center to the viewport's edge.
+		unsigned int count = (unsigned int)edge.size();
+		std::vector<OVR::Vector2f> border(count);
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			float extent = OVR::Alg::Max(fabsf(edge[i].x), fabsf(edge[i].y));
+			border[i] = (extent > 0.0f) ? edge[i] / extent : OVR::Vector2f(1.0f, 0.0f);
+			if (extent >= 1.0f)
+			{
+				// The whole way out to here is seen, so there is nothing to mask.
+				edge[i] = border[i];
+			}
+		}
+
+		float area = 0.0f;
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			unsigned int next = (i + 1) % count;
+			OVR::Vector2f triangles[9];
+			int corners = 6;
+			triangles[0] = edge[i];
+			triangles[1] = border[i];
+			triangles[2] = border[next];
+			triangles[3] = edge[i];
+			triangles[4] = border[next];
+			triangles[5] = edge[next];
+
+			// When the two border points land on different sides of the viewport, the corner between them
+			// has to be filled in as well.
+			bool onSideX = fabsf(border[i].x) >= fabsf(border[i].y);
+			bool nextOnSideX = fabsf(border[next].x) >= fabsf(border[next].y);
+			if (onSideX != nextOnSideX)
+			{
+				triangles[6] = border[i];
+				triangles[7] = OVR::Vector2f((border[i].x + border[next].x >= 0.0f) ? 1.0f : -1.0f,
+					(border[i].y + border[next].y >= 0.0f) ? 1.0f : -1.0f);
+				triangles[8] = border[next];
+				corners = 9;
+			}
+
+			for (int j = 0; j < corners; j += 3)
+			{
+				OVR::Vector2f a = triangles[j + 1] - triangles[j];
+				OVR::Vector2f b = triangles[j + 2] - triangles[j];
+				area += fabsf(a.x * b.y - a.y * b.x) * 0.5f;
+				for (int k = 0; k < 3; k += 1)
+				{
+					vertices.push_back(triangles[j + k].x);
+					vertices.push_back(triangles[j + k].y);
+				}
+			}
+		}
+
+		// The viewport is 2 by 2 in normalized device coordinates.
+		this->hiddenAreaFractions[eye] = area / 4.0f;
+	}
+
+	void OculusRift::drawHiddenArea(ovrEyeType eye)
+	{
+		glClear(GL_DEPTH_BUFFER_BIT);
+		if (this->hiddenAreaVertexCounts[eye] == 0)
+		{
+			return;
+		}
+
+		// Only depth is written, and the mask is flat so it must not be culled.
+		GLboolean culling = glIsEnabled(GL_CULL_FACE);
+		glDisable(GL_CULL_FACE);
+		glEnable(GL_DEPTH_TEST);
+		glDepthMask(GL_TRUE);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+		pv_glUseProgram(this->hiddenAreaProgram);
+		pv_glUniform1f(this->hiddenAreaDepthLocation, (this->reverseDepth) ? 1.0f : -1.0f);
+		pv_glBindVertexArray(this->hiddenAreaVertexArrays[eye]);
+		glDrawArrays(GL_TRIANGLES, 0, this->hiddenAreaVertexCounts[eye]);
+		pv_glBindVertexArray(0);
+		pv_glUseProgram(0);
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		if (culling)
+		{
+			glEnable(GL_CULL_FACE);
+		}
+	}
+
+	void OculusRift::setupEyeViewBuffer()
+	{
+		// Each eye's matrix has to start on a uniform buffer offset boundary so it can be bound on its own.
+		int alignment = 0;
+		glGetIntegerv(PV_GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		this->eyeViewBufferStride = 16 * sizeof(float);
+		if (alignment > 0)
+		{
+			this->eyeViewBufferStride = ((this->eyeViewBufferStride + alignment - 1) / alignment) * alignment;
+		}
+		unsigned int size = this->eyeViewBufferStride * 2 * PV_EYE_VIEW_FRAMES;
+
+		pv_glGenBuffers(1, &this->eyeViewBuffer);
+		pv_glBindBuffer(PV_GL_UNIFORM_BUFFER, this->eyeViewBuffer);
+		if (pv_glBufferStorage != NULL && pv_glMapBufferRange != NULL)
+		{
+			// Map the buffer once and keep it mapped, so poses written at the last moment are seen by
+			// draw calls which were issued before them but have not been executed by the GPU yet.
+			unsigned int flags = PV_GL_MAP_WRITE_BIT | PV_GL_MAP_PERSISTENT_BIT | PV_GL_MAP_COHERENT_BIT;
+			pv_glBufferStorage(PV_GL_UNIFORM_BUFFER, size, NULL, flags | PV_GL_DYNAMIC_STORAGE_BIT);
+			this->eyeViewBufferData = (unsigned char*)pv_glMapBufferRange(PV_GL_UNIFORM_BUFFER, 0, size, flags);
+		}
+		else
+		{
+			pv_glBufferData(PV_GL_UNIFORM_BUFFER, size, NULL, PV_GL_DYNAMIC_DRAW);
+		}
+		pv_glBindBuffer(PV_GL_UNIFORM_BUFFER, 0);
+	}
+
 	void OculusRift::SetRenderTextures(unsigned int leftEyeTexture, unsigned int rightEyeTexture)
 	{
 		this->eyeTextures[0].Texture.Header.TextureSize.w = this->renderSize.w;
@@ -230,6 +728,40 @@ namespace PV
 		return (const bool)this->connected;
 	}
 
+	const bool OculusRift::isVirtuallyConnected() const
+	{
+		return (const bool)this->virtuallyConnected;
+	}
+
+	PoseTrajectory& OculusRift::GetVirtualTrajectory()
+	{
+		return this->virtualTrajectory;
+	}
+
+	void OculusRift::SetRecordingTrajectory(bool recording)
+	{
+		if (recording && !this->recordingTrajectory)
+		{
+			this->recordedTrajectory.Clear();
+		}
+		this->recordingTrajectory = recording;
+	}
+
+	const PoseTrajectory& OculusRift::GetRecordedTrajectory() const
+	{
+		return this->recordedTrajectory;
+	}
+
+	void OculusRift::SetRecorder(SensorRecorder* recorder)
+	{
+		this->recorder = recorder;
+	}
+
+	void OculusRift::SetReplay(SensorReplay* replay)
+	{
+		this->replay = replay;
+	}
+
 	/**
 	 * Updates the data from the Oculus Rift headset.
 	 *
@@ -238,7 +770,15 @@ namespace PV
 	 */
 	void OculusRift::Update()
 	{
-		if (this->connected && !this->virtuallyConnected)
+		if (this->tracking)
+		{
+			// The tracking thread already has a fresher pose than polling here would get.
+			TrackedPose latest = this->trackedPose.GetState();
+			this->sensorState.HeadPose.ThePose = latest.pose;
+			this->sensorState.HeadPose.TimeInSeconds = latest.time;
+			this->sensorState.StatusFlags = latest.statusFlags;
+		}
+		else if (this->connected && !this->virtuallyConnected)
 		{
 			this->sensorState = ovrHmd_GetTrackingState(this->HMD, 0.0);
 			if (this->sensorState.StatusFlags & (ovrStatus_OrientationTracked))
@@ -248,6 +788,119 @@ namespace PV
 				//this->Rotation.z = this->Orientation.roll * 180.0f / 3.14159265358979323846f;
 			}
 		}
+		else if (this->virtuallyConnected)
+		{
+			// A virtual Rift is always tracked, at wherever the trajectory is right now.
+			this->sensorState.HeadPose.ThePose = this->getVirtualPose(ovr_GetTimeInSeconds());
+			this->sensorState.StatusFlags = ovrStatus_OrientationTracked | ovrStatus_PositionTracked;
+		}
+
+		// The tracking thread records its own samples.
+		SensorRecorder* recorder = this->recorder;
+		if (recorder != NULL && this->connected && !this->tracking)
+		{
+			recorder->AddPose(ovr_GetTimeInSeconds(), this->sensorState.HeadPose.ThePose);
+		}
+	}
+
+	void OculusRift::StartTracking(unsigned int rate)
+	{
+		if (this->tracking || !this->connected)
+		{
+			return;
+		}
+		this->trackingRate = (rate > 0) ? rate : PV_TRACKING_RATE;
+		this->trackingSamples = 0;
+		this->trackingStartTime = ovr_GetTimeInSeconds();
+		this->tracking = true;
+		this->trackingThread = std::thread(&OculusRift::runTracking, this);
+	}
+
+	void OculusRift::StopTracking()
+	{
+		if (!this->tracking)
+		{
+			return;
+		}
+		this->tracking = false;
+		this->trackingThread.join();
+	}
+
+	const bool OculusRift::IsTracking() const
+	{
+		return this->tracking;
+	}
+
+	const TrackedPose OculusRift::GetTrackedPose() const
+	{
+		return this->trackedPose.GetState();
+	}
+
+	const unsigned int OculusRift::GetTrackingSampleCount() const
+	{
+		return this->trackingSamples;
+	}
+
+	const double OculusRift::GetTrackingRate() const
+	{
+		double elapsed = ovr_GetTimeInSeconds() - this->trackingStartTime;
+		return (this->trackingStartTime > 0.0 && elapsed > 0.0) ? this->trackingSamples / elapsed : 0.0;
+	}
+
+	void OculusRift::runTracking()
+	{
+		double interval = 1.0 / this->trackingRate;
+		double nextSample = ovr_GetTimeInSeconds();
+		unsigned int sampleIndex = 0;
+		TrackedPose sample;
+		while (this->tracking)
+		{
+			double now = ovr_GetTimeInSeconds();
+			if (this->virtuallyConnected)
+			{
+				sample.pose = this->getVirtualPose(now);
+				sample.statusFlags = ovrStatus_OrientationTracked | ovrStatus_PositionTracked;
+			}
+			else
+			{
+				ovrTrackingState state = ovrHmd_GetTrackingState(this->HMD, now);
+				sample.pose = state.HeadPose.ThePose;
+				sample.statusFlags = state.StatusFlags;
+			}
+			OVR::Quatf orientation = sample.pose.Orientation;
+			orientation.GetEulerAngles<OVR::Axis_Y, OVR::Axis_X, OVR::Axis_Z>(&sample.rotation.yaw, &sample.rotation.pitch, &sample.rotation.roll);
+			sample.time = now;
+			sampleIndex += 1;
+			sample.sampleIndex = sampleIndex;
+			this->trackedPose.SetState(sample);
+			this->trackingSamples = sampleIndex;
+
+			SensorRecorder* recorder = this->recorder;
+			if (recorder != NULL)
+			{
+				recorder->AddPose(now, sample.pose);
+			}
+
+			// Sleeping is only accurate to around a millisecond, so sleep until close to the next sample and then
+			// yield the rest of the way.  If the thread fell a whole sample behind, start counting from now rather
+			// than sampling back to back to catch up.
+			nextSample += interval;
+			while (this->tracking && (now = ovr_GetTimeInSeconds()) < nextSample)
+			{
+				if (nextSample - now > 0.002)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			if (now - nextSample > interval)
+			{
+				nextSample = now;
+			}
+		}
 	}
 
 	void OculusRift::DismissWarningScreen()
@@ -264,43 +917,150 @@ namespace PV
 	{
 		if (this->isConnected())
 		{
-			static int frameIndex = 0;
-			ovrHmd_BeginFrame(this->HMD, frameIndex);
-			frameIndex++;
+			double beginTime = ovr_GetTimeInSeconds();
+			this->frameTiming = ovrHmd_BeginFrame(this->HMD, this->frameIndex);
+
+			memset(&this->currentFrame, 0, sizeof(this->currentFrame));
+			this->currentFrame.frameIndex = this->frameIndex;
+			this->currentFrame.beginTime = beginTime;
+			this->currentFrame.predictedDisplayTime = this->frameTiming.ScanoutMidpointSeconds;
 			return true;
 		}
 		return false;
 	}
 
+	ovrPosef OculusRift::getEyePose(ovrEyeType eye)
+	{
+		if (this->virtuallyConnected)
+		{
+			// Predict for the same point in time the sensors would, the moment the eye is scanned out.
+			ovrFrameTiming timing = ovrHmd_GetFrameTiming(this->HMD, this->frameIndex);
+			return this->getVirtualPose(timing.EyeScanoutSeconds[eye]);
+		}
+		return ovrHmd_GetEyePose(this->HMD, eye);
+	}
+
+	ovrPosef OculusRift::getVirtualPose(double time) const
+	{
+		SensorReplay* replay = this->replay;
+		if (replay != NULL)
+		{
+			int index = replay->FindPose(replay->GetTimeAt(time));
+			if (index >= 0)
+			{
+				return replay->GetPose(index).pose;
+			}
+		}
+		return this->virtualTrajectory.Sample(time - this->virtualStartTime);
+	}
+
+	void OculusRift::getEyeViewMatrix(ovrEyeType eye, Math::Matrix<float> &viewMatrix)
+	{
+		OVR::Quat<float> getters = this->eyePoses[eye].Orientation;
+		getters.GetEulerAngles<OVR::Axis_Y, OVR::Axis_X, OVR::Axis_Z>(&this->Orientation.yaw, &this->Orientation.pitch, &this->Orientation.roll);
+
+		viewMatrix.SetIdentity();
+		viewMatrix.Rotate(this->Orientation.pitch, this->Orientation.yaw, this->Orientation.roll);
+		viewMatrix.Translate(this->eyePoses[eye].Position.x,
+			this->eyePoses[eye].Position.y,
+			this->eyePoses[eye].Position.z);
+	}
+
+	void OculusRift::writeEyeView(ovrEyeType eye)
+	{
+		unsigned int offset = ((this->frameIndex % PV_EYE_VIEW_FRAMES) * 2 + eye) * this->eyeViewBufferStride;
+		this->getEyeViewMatrix(eye, this->eyeViewMatrix);
+		if (this->eyeViewBufferData != NULL)
+		{
+			memcpy(this->eyeViewBufferData + offset, this->eyeViewMatrix.getArray(), 16 * sizeof(float));
+		}
+		else
+		{
+			pv_glBindBuffer(PV_GL_UNIFORM_BUFFER, this->eyeViewBuffer);
+			pv_glBufferSubData(PV_GL_UNIFORM_BUFFER, offset, 16 * sizeof(float), this->eyeViewMatrix.getArray());
+			pv_glBindBuffer(PV_GL_UNIFORM_BUFFER, 0);
+		}
+	}
+
 	void OculusRift::StartEyeRender(RiftEye eye, Math::Matrix<float> &viewMatrix)
 	{
 		if (this->isConnected())
 		{
-			this->eyePoses[this->HMD->EyeRenderOrder[eye]] = 
-				ovrHmd_GetEyePose(this->HMD, this->HMD->EyeRenderOrder[eye]);
+			ovrEyeType renderEye = this->HMD->EyeRenderOrder[eye];
+			this->eyeRenderStartTime[renderEye] = ovr_GetTimeInSeconds();
+			if (this->reverseDepth)
+			{
+				glGetIntegerv(PV_GL_CLIP_ORIGIN, &this->savedClipOrigin);
+				glGetIntegerv(PV_GL_CLIP_DEPTH_MODE, &this->savedClipDepthMode);
+				glGetIntegerv(GL_DEPTH_FUNC, &this->savedDepthFunction);
+				glGetFloatv(GL_DEPTH_CLEAR_VALUE, &this->savedClearDepth);
+				// Set before anything clears the depth buffer, since clearing to 0 is what makes it start out at
+				// the far end.
+				pv_glClipControl(PV_GL_LOWER_LEFT, PV_GL_ZERO_TO_ONE);
+				glDepthFunc(GL_GREATER);
+				glClearDepth(0.0);
+			}
+			this->eyePoses[renderEye] = this->getEyePose(renderEye);
 
-			OVR::Quat<float> getters = this->eyePoses[this->HMD->EyeRenderOrder[eye]].Orientation;
-			getters.GetEulerAngles<OVR::Axis_Y, OVR::Axis_X, OVR::Axis_Z>(&this->Orientation.yaw, &this->Orientation.pitch, &this->Orientation.roll);
-			
-			viewMatrix.SetIdentity();
-			viewMatrix.Rotate(this->Orientation.pitch, this->Orientation.yaw, this->Orientation.roll);
-			viewMatrix.Translate(this->eyePoses[this->HMD->EyeRenderOrder[eye]].Position.x,
-				this->eyePoses[this->HMD->EyeRenderOrder[eye]].Position.y,
-				this->eyePoses[this->HMD->EyeRenderOrder[eye]].Position.z);
+			if (this->lateLatching)
+			{
+				// The shaders get the eye's view from the buffer, so only the range for this eye is bound.  The
+				// pose written now is only a fallback, it gets replaced in EndRender when the buffer is mapped.
+				this->writeEyeView(renderEye);
+				pv_glBindBufferRange(PV_GL_UNIFORM_BUFFER, PV_EYE_VIEW_BINDING, this->eyeViewBuffer,
+					((this->frameIndex % PV_EYE_VIEW_FRAMES) * 2 + renderEye) * this->eyeViewBufferStride, 16 * sizeof(float));
+				viewMatrix.SetIdentity();
+			}
+			else
+			{
+				this->getEyeViewMatrix(renderEye, viewMatrix);
+			}
 
-			switch (this->HMD->EyeRenderOrder[eye])
+			// Render to the part of the texture the SDK distorts from.
+			ovrRecti viewport = this->eyeTextures[renderEye].OGL.Header.RenderViewport;
+			if (this->multiResolution && this->hiddenAreaMasking)
+			{
+				// The reduced density regions have a depth buffer of their own which needs masking too, at the
+				// same reduced density.
+				pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, this->peripheryFrameBuffers[renderEye]);
+				glViewport(viewport.Pos.x, viewport.Pos.y, (int)(viewport.Size.w * this->peripheryDensity), (int)(viewport.Size.h * this->peripheryDensity));
+				this->drawHiddenArea(renderEye);
+			}
+
+			glViewport(viewport.Pos.x, viewport.Pos.y, viewport.Size.w, viewport.Size.h);
+			switch (renderEye)
 			{
 			case ovrEye_Left:
-				glViewport(0, 0, 640, 800);
 				pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, this->leftFrameBuffer);
 				pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, this->leftDepthBuffer);
 				break;
 			case ovrEye_Right:
-				glViewport(640, 0, 640, 800);
 				pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, this->rightFrameBuffer);
 				pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, this->rightDepthBuffer);
 				break;
 			}
+
+			if (this->hiddenAreaMasking)
+			{
+				this->drawHiddenArea(renderEye);
+			}
+
+			// Count the samples shaded for this eye.  The query being reused was issued a few frames ago, so its
+			// result is normally ready and picking it up does not wait on the GPU.
+			if (this->sampleQueries[renderEye][0] != 0)
+			{
+				unsigned int query = this->sampleQueries[renderEye][this->frameIndex % PV_SAMPLE_QUERIES];
+				if (this->frameIndex >= PV_SAMPLE_QUERIES)
+				{
+					unsigned int available = 0;
+					pv_glGetQueryObjectuiv(query, PV_GL_QUERY_RESULT_AVAILABLE, &available);
+					if (available)
+					{
+						pv_glGetQueryObjectuiv(query, PV_GL_QUERY_RESULT, &this->shadedSamples[renderEye]);
+					}
+				}
+				pv_glBeginQuery(PV_GL_SAMPLES_PASSED, query);
+			}
 		}
 	}
 
@@ -308,10 +1068,33 @@ namespace PV
 	{
 		if (this->isConnected())
 		{
-			glViewport(0, 0, 1280, 800);
+			ovrEyeType renderEye = this->HMD->EyeRenderOrder[eye];
+			if (this->sampleQueries[renderEye][0] != 0)
+			{
+				pv_glEndQuery(PV_GL_SAMPLES_PASSED);
+			}
+
+			if (this->multiResolution)
+			{
+				// Scale the reduced density regions up into their place in the eye's texture.
+				glDisable(GL_SCISSOR_TEST);
+				pv_glBindFramebuffer(PV_GL_READ_FRAMEBUFFER, this->peripheryFrameBuffers[renderEye]);
+				pv_glBindFramebuffer(PV_GL_DRAW_FRAMEBUFFER, (renderEye == ovrEye_Left) ? this->leftFrameBuffer : this->rightFrameBuffer);
+				for (unsigned int i = 0; i < this->eyeRegionCounts[renderEye]; i += 1)
+				{
+					const EyeRegion& region = this->eyeRegions[renderEye][i];
+					if (region.reduced)
+					{
+						pv_glBlitFramebuffer(region.reducedX, region.reducedY, region.reducedX + region.reducedWidth, region.reducedY + region.reducedHeight,
+							region.x, region.y, region.x + region.width, region.y + region.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+					}
+				}
+			}
+
+			glViewport(0, 0, this->renderSize.w, this->renderSize.h);
 			pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
 			pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, 0);
-			switch (this->HMD->EyeRenderOrder[eye])
+			switch (renderEye)
 			{
 			case ovrEye_Left:
 				glBindTexture(GL_TEXTURE_2D, this->leftEyeTexture);
@@ -324,6 +1107,14 @@ namespace PV
 				glBindTexture(GL_TEXTURE_2D, 0);
 				break;
 			}
+			if (this->reverseDepth)
+			{
+				// The distortion rendering and anything drawn to the window afterwards expect what was set before.
+				pv_glClipControl(this->savedClipOrigin, this->savedClipDepthMode);
+				glDepthFunc(this->savedDepthFunction);
+				glClearDepth(this->savedClearDepth);
+			}
+			this->currentFrame.eyeRenderDuration[renderEye] = ovr_GetTimeInSeconds() - this->eyeRenderStartTime[renderEye];
 		}
 	}
 
@@ -331,14 +1122,424 @@ namespace PV
 	{
 		if (this->isConnected())
 		{
+			if (this->lateLatching && this->eyeViewBufferData != NULL)
+			{
+				// Sample the poses predicted for scan-out right before submitting, and give timewarp the
+				// exact same poses the eye views were built from.
+				for (int i = 0; i < 2; i += 1)
+				{
+					ovrEyeType renderEye = this->HMD->EyeRenderOrder[i];
+					this->eyePoses[renderEye] = this->getEyePose(renderEye);
+					this->writeEyeView(renderEye);
+				}
+			}
+
+			if (this->recordingTrajectory)
+			{
+				// The eye poses are the head pose as of 0.4, so either one is the head pose for this frame.
+				ovrFrameTiming timing = ovrHmd_GetFrameTiming(this->HMD, this->frameIndex);
+				this->recordedTrajectory.AddPose(timing.ScanoutMidpointSeconds, this->eyePoses[ovrEye_Left]);
+			}
+
+			// The SDK waits for the timewarp point before distorting, so whatever time is left until then is waited out.
+			this->currentFrame.submitTime = ovr_GetTimeInSeconds();
+			this->currentFrame.timewarpWait = this->frameTiming.TimewarpPointSeconds - this->currentFrame.submitTime;
+			if (this->currentFrame.timewarpWait < 0.0)
+			{
+				this->currentFrame.timewarpWait = 0.0;
+			}
+
 			ovrTexture textures[2] = { this->eyeTextures[0].Texture, this->eyeTextures[1].Texture };
 			ovrHmd_EndFrame(this->HMD, this->eyePoses, textures);
+			this->currentFrame.endTime = ovr_GetTimeInSeconds();
+			this->recordFrame();
+			this->frameIndex++;
+		}
+	}
+
+	void OculusRift::recordFrame()
+	{
+		// A frame which finished more than one and a half intervals after the one before it, so at least half an
+		// interval late, went past a vsync.
+		if (this->frameRecordsWritten > 0)
+		{
+			const FrameRecord& previous = this->frameRecords[(this->frameRecordsWritten - 1) % PV_FRAME_RECORDS];
+			double interval = this->frameTiming.NextFrameSeconds - this->frameTiming.ThisFrameSeconds;
+			if (interval > 0.0 && this->currentFrame.endTime - previous.endTime > interval * 1.5)
+			{
+				this->currentFrame.missedVsync = true;
+				this->missedVsyncCount += 1;
+			}
+		}
+
+		this->currentFrame.shadedSamples[ovrEye_Left] = this->shadedSamples[ovrEye_Left];
+		this->currentFrame.shadedSamples[ovrEye_Right] = this->shadedSamples[ovrEye_Right];
+		this->frameRecords[this->frameRecordsWritten % PV_FRAME_RECORDS] = this->currentFrame;
+		this->frameRecordsWritten += 1;
+	}
+
+	const unsigned int OculusRift::GetFrameRecordCount() const
+	{
+		return (this->frameRecordsWritten < PV_FRAME_RECORDS) ? this->frameRecordsWritten : PV_FRAME_RECORDS;
+	}
+
+	const FrameRecord& OculusRift::GetFrameRecord(unsigned int index) const
+	{
+		unsigned int oldest = this->frameRecordsWritten - this->GetFrameRecordCount();
+		return this->frameRecords[(oldest + index) % PV_FRAME_RECORDS];
+	}
+
+	const unsigned int OculusRift::GetMissedVsyncCount() const
+	{
+		return this->missedVsyncCount;
+	}
+
+	bool OculusRift::SaveFrameRecordsCSV(const char* fileName) const
+	{
+		FILE* file = fopen(fileName, "w");
+		if (file == NULL)
+		{
+			printf("Error opening frame record file %s!\n", fileName);
+			return false;
+		}
+
+		unsigned int count = this->GetFrameRecordCount();
+		double start = (count > 0) ? this->GetFrameRecord(0).beginTime : 0.0;
+		fprintf(file, "frame,begin,submit,end,predicted_display,left_eye,right_eye,timewarp_wait,left_samples,right_samples,missed_vsync\n");
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			const FrameRecord& record = this->GetFrameRecord(i);
+			fprintf(file, "%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%u,%u,%d\n", record.frameIndex,
+				(record.beginTime - start) * 1000.0,
+				(record.submitTime - start) * 1000.0,
+				(record.endTime - start) * 1000.0,
+				(record.predictedDisplayTime - start) * 1000.0,
+				record.eyeRenderDuration[ovrEye_Left] * 1000.0,
+				record.eyeRenderDuration[ovrEye_Right] * 1000.0,
+				record.timewarpWait * 1000.0,
+				record.shadedSamples[ovrEye_Left],
+				record.shadedSamples[ovrEye_Right],
+				record.missedVsync ? 1 : 0);
+		}
+		fclose(file);
+		return true;
+	}
+
+	bool OculusRift::SaveFrameRecordsJSON(const char* fileName) const
+	{
+		FILE* file = fopen(fileName, "w");
+		if (file == NULL)
+		{
+			printf("Error opening frame record file %s!\n", fileName);
+			return false;
+		}
+
+		unsigned int count = this->GetFrameRecordCount();
+		double start = (count > 0) ? this->GetFrameRecord(0).beginTime : 0.0;
+		fprintf(file, "[\n");
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			const FrameRecord& record = this->GetFrameRecord(i);
+			fprintf(file, "\t{ \"frame\": %u, \"begin\": %.3f, \"submit\": %.3f, \"end\": %.3f, \"predicted_display\": %.3f, "
+				"\"left_eye\": %.3f, \"right_eye\": %.3f, \"timewarp_wait\": %.3f, \"left_samples\": %u, \"right_samples\": %u, "
+				"\"missed_vsync\": %s }%s\n", record.frameIndex,
+				(record.beginTime - start) * 1000.0,
+				(record.submitTime - start) * 1000.0,
+				(record.endTime - start) * 1000.0,
+				(record.predictedDisplayTime - start) * 1000.0,
+				record.eyeRenderDuration[ovrEye_Left] * 1000.0,
+				record.eyeRenderDuration[ovrEye_Right] * 1000.0,
+				record.timewarpWait * 1000.0,
+				record.shadedSamples[ovrEye_Left],
+				record.shadedSamples[ovrEye_Right],
+				record.missedVsync ? "true" : "false",
+				(i + 1 < count) ? "," : "");
+		}
+		fprintf(file, "]\n");
+		fclose(file);
+		return true;
+	}
+
+	void OculusRift::StartEyeRegion(RiftEye eye, unsigned int region, Math::Matrix<float> &perspectiveMatrix)
+	{
+		if (!this->isConnected())
+		{
+			return;
+		}
+
+		ovrEyeType renderEye = this->HMD->EyeRenderOrder[eye];
+		this->getPerspectiveMatrix(eye, perspectiveMatrix);
+		if (region >= this->eyeRegionCounts[renderEye])
+		{
+			return;
+		}
+
+		const EyeRegion& eyeRegion = this->eyeRegions[renderEye][region];
+		if (eyeRegion.reduced)
+		{
+			pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, this->peripheryFrameBuffers[renderEye]);
+			glViewport(eyeRegion.reducedX, eyeRegion.reducedY, eyeRegion.reducedWidth, eyeRegion.reducedHeight);
+			glScissor(eyeRegion.reducedX, eyeRegion.reducedY, eyeRegion.reducedWidth, eyeRegion.reducedHeight);
+		}
+		else
+		{
+			pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, (renderEye == ovrEye_Left) ? this->leftFrameBuffer : this->rightFrameBuffer);
+			glViewport(eyeRegion.x, eyeRegion.y, eyeRegion.width, eyeRegion.height);
+			glScissor(eyeRegion.x, eyeRegion.y, eyeRegion.width, eyeRegion.height);
+		}
+		if (this->multiResolution)
+		{
+			glEnable(GL_SCISSOR_TEST);
+		}
+
+		// Crop the perspective to the region, by stretching the region's part of the normalized device
+		// coordinates out to fill all of them.
+		ovrRecti viewport = this->eyeTextures[renderEye].OGL.Header.RenderViewport;
+		float left = (float)(eyeRegion.x - viewport.Pos.x) / viewport.Size.w * 2.0f - 1.0f;
+		float right = (float)(eyeRegion.x + eyeRegion.width - viewport.Pos.x) / viewport.Size.w * 2.0f - 1.0f;
+		float bottom = (float)(eyeRegion.y - viewport.Pos.y) / viewport.Size.h * 2.0f - 1.0f;
+		float top = (float)(eyeRegion.y + eyeRegion.height - viewport.Pos.y) / viewport.Size.h * 2.0f - 1.0f;
+		float scaleX = 2.0f / (right - left);
+		float offsetX = -(right + left) / (right - left);
+		float scaleY = 2.0f / (top - bottom);
+		float offsetY = -(top + bottom) / (top - bottom);
+		for (int column = 0; column < 4; column += 1)
+		{
+			float w = perspectiveMatrix[3 + column * 4];
+			perspectiveMatrix[0 + column * 4] = perspectiveMatrix[0 + column * 4] * scaleX + w * offsetX;
+			perspectiveMatrix[1 + column * 4] = perspectiveMatrix[1 + column * 4] * scaleY + w * offsetY;
+		}
+	}
+
+	void OculusRift::SetReverseDepth(bool enabled)
+	{
+		enabled = enabled && hasClipControl();
+		if (enabled != this->reverseDepth)
+		{
+			this->reverseDepth = enabled;
+			if (this->isConnected())
+			{
+				this->allocateDepthBuffers();
+			}
+		}
+	}
+
+	const bool OculusRift::IsReverseDepth() const
+	{
+		return this->reverseDepth;
+	}
+
+	void OculusRift::allocateDepthBuffers()
+	{
+		// Reallocating the storage keeps the depth buffers attached to their frame buffers.
+		unsigned int format = (this->reverseDepth) ? PV_GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT;
+		unsigned int depthBuffers[4] = { this->leftDepthBuffer, this->rightDepthBuffer, this->peripheryDepthBuffers[0], this->peripheryDepthBuffers[1] };
+		for (int i = 0; i < 4; i += 1)
+		{
+			if (depthBuffers[i] != 0)
+			{
+				pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, depthBuffers[i]);
+				pv_glRenderbufferStorage(PV_GL_RENDERBUFFER, format, this->renderSize.w, this->renderSize.h);
+			}
+		}
+		pv_glBindRenderbuffer(PV_GL_RENDERBUFFER, 0);
+	}
+
+	void OculusRift::SetMultiResolution(float centerSize, float peripheryDensity)
+	{
+		this->centerSize = OVR::Alg::Max(0.0f, OVR::Alg::Min(centerSize, 1.0f));
+		this->peripheryDensity = OVR::Alg::Max(0.01f, OVR::Alg::Min(peripheryDensity, 1.0f));
+
+		bool enabled = this->centerSize < 1.0f && this->peripheryDensity < 1.0f;
+		if (enabled && this->isConnected() && this->peripheryFrameBuffers[0] == 0)
+		{
+			this->setupPeripheryBuffers();
+		}
+		this->multiResolution = enabled && this->peripheryFrameBuffers[0] != 0;
+		if (this->isConnected())
+		{
+			this->updateEyeRegions();
+		}
+	}
+
+	const bool OculusRift::IsMultiResolution() const
+	{
+		return this->multiResolution;
+	}
+
+	const unsigned int OculusRift::GetEyeRegionCount(RiftEye eye) const
+	{
+		if (!this->isConnected())
+		{
+			return 0;
+		}
+		return this->eyeRegionCounts[this->HMD->EyeRenderOrder[eye]];
+	}
+
+	const float OculusRift::GetRenderedPixelRatio(RiftEye eye) const
+	{
+		if (!this->isConnected())
+		{
+			return 1.0f;
+		}
+
+		ovrEyeType renderEye = this->HMD->EyeRenderOrder[eye];
+		ovrRecti viewport = this->eyeTextures[renderEye].OGL.Header.RenderViewport;
+		float rendered = 0.0f;
+		for (unsigned int i = 0; i < this->eyeRegionCounts[renderEye]; i += 1)
+		{
+			const EyeRegion& region = this->eyeRegions[renderEye][i];
+			rendered += (region.reduced) ? (float)(region.reducedWidth * region.reducedHeight) : (float)(region.width * region.height);
+		}
+		return rendered / (float)(viewport.Size.w * viewport.Size.h);
+	}
+
+	void OculusRift::SetMirror(MirrorMode mode, float crop)
+	{
+		this->mirrorMode = mode;
+		this->mirrorCrop = (crop < 0.0f) ? 0.0f : ((crop > 0.45f) ? 0.45f : crop);
+	}
+
+	const MirrorMode OculusRift::GetMirrorMode() const
+	{
+		return this->mirrorMode;
+	}
+
+	void OculusRift::Mirror(int width, int height)
+	{
+		if (!this->isConnected() || this->mirrorMode == MirrorNone || width <= 0 || height <= 0)
+		{
+			return;
+		}
+		double start = ovr_GetTimeInSeconds();
+
+		// Work out the part of each eye to show, and how large both of them are side by side.
+		int eyeCount = (this->mirrorMode == MirrorBothEyes) ? 2 : 1;
+		int firstEye = (this->mirrorMode == MirrorRightEye) ? ovrEye_Right : ovrEye_Left;
+		ovrRecti sources[2];
+		int totalWidth = 0;
+		int totalHeight = 0;
+		for (int i = 0; i < eyeCount; i += 1)
+		{
+			ovrRecti viewport = this->eyeTextures[firstEye + i].OGL.Header.RenderViewport;
+			int cropX = (int)(viewport.Size.w * this->mirrorCrop);
+			int cropY = (int)(viewport.Size.h * this->mirrorCrop);
+			sources[i].Pos.x = viewport.Pos.x + cropX;
+			sources[i].Pos.y = viewport.Pos.y + cropY;
+			sources[i].Size.w = viewport.Size.w - cropX * 2;
+			sources[i].Size.h = viewport.Size.h - cropY * 2;
+			totalWidth += sources[i].Size.w;
+			totalHeight = (sources[i].Size.h > totalHeight) ? sources[i].Size.h : totalHeight;
+		}
+
+		// Scale to fit the window without stretching, and center it.
+		float scale = (float)width / totalWidth;
+		if ((float)height / totalHeight < scale)
+		{
+			scale = (float)height / totalHeight;
+		}
+		int x = (width - (int)(totalWidth * scale)) / 2;
+		int y = (height - (int)(totalHeight * scale)) / 2;
+
+		// Blits are clipped by the scissor, which the eye regions may have left on.
+		glDisable(GL_SCISSOR_TEST);
+		pv_glBindFramebuffer(PV_GL_DRAW_FRAMEBUFFER, 0);
+		glViewport(0, 0, width, height);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		for (int i = 0; i < eyeCount; i += 1)
+		{
+			unsigned int frameBuffer = (firstEye + i == ovrEye_Left) ? this->leftFrameBuffer : this->rightFrameBuffer;
+			int destinationWidth = (int)(sources[i].Size.w * scale);
+			pv_glBindFramebuffer(PV_GL_READ_FRAMEBUFFER, frameBuffer);
+			pv_glBlitFramebuffer(sources[i].Pos.x, sources[i].Pos.y, sources[i].Pos.x + sources[i].Size.w, sources[i].Pos.y + sources[i].Size.h,
+				x, y, x + destinationWidth, y + (int)(sources[i].Size.h * scale), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+			x += destinationWidth;
+		}
+		pv_glBindFramebuffer(PV_GL_FRAMEBUFFER, 0);
+
+		this->mirrorTime = ovr_GetTimeInSeconds() - start;
+	}
+
+	const double OculusRift::GetMirrorTime() const
+	{
+		return this->mirrorTime;
+	}
+
+	void OculusRift::SetHiddenAreaMask(bool enabled)
+	{
+		if (enabled && this->isConnected() && this->hiddenAreaVertexArrays[0] == 0)
+		{
+			this->setupHiddenArea();
+		}
+		this->hiddenAreaMasking = enabled && this->hiddenAreaProgram != 0;
+	}
+
+	const bool OculusRift::IsHiddenAreaMasking() const
+	{
+		return this->hiddenAreaMasking;
+	}
+
+	void OculusRift::ShareResources(const OculusRift& owner)
+	{
+		if (this->hiddenAreaProgram == 0 && owner.hiddenAreaProgram != 0)
+		{
+			this->hiddenAreaProgram = owner.hiddenAreaProgram;
+			this->ownsHiddenAreaProgram = false;
+		}
+	}
+
+	const float OculusRift::GetHiddenAreaFraction(RiftEye eye) const
+	{
+		if (!this->isConnected())
+		{
+			return 0.0f;
+		}
+		return this->hiddenAreaFractions[this->HMD->EyeRenderOrder[eye]];
+	}
+
+	const unsigned int OculusRift::GetShadedSamples(RiftEye eye) const
+	{
+		if (!this->isConnected())
+		{
+			return 0;
+		}
+		return this->shadedSamples[this->HMD->EyeRenderOrder[eye]];
+	}
+
+	void OculusRift::SetLateLatching(bool enabled)
+	{
+		if (enabled && this->isConnected() && this->eyeViewBuffer == 0)
+		{
+			this->setupEyeViewBuffer();
+		}
+		this->lateLatching = enabled && this->eyeViewBuffer != 0;
+	}
+
+	const bool OculusRift::IsLateLatching() const
+	{
+		return this->lateLatching;
+	}
+
+	void OculusRift::BindEyeViewBlock(unsigned int program)
+	{
+		unsigned int blockIndex = pv_glGetUniformBlockIndex(program, "PVEyeView");
+		if (blockIndex != 0xFFFFFFFF)
+		{
+			pv_glUniformBlockBinding(program, blockIndex, PV_EYE_VIEW_BINDING);
 		}
 	}
 
 	void OculusRift::getPerspectiveMatrix(RiftEye eye, Math::Matrix<float> &perspectiveMatrix)
 	{
-		ovrMatrix4f proj = ovrMatrix4f_Projection(this->eyes[this->HMD->EyeRenderOrder[eye]].Fov, 0.01f, 10000.0f, true);
+		ovrMatrix4f proj = ovrMatrix4f_Projection(this->eyes[this->HMD->EyeRenderOrder[eye]].Fov, PV_RIFT_NEAR_PLANE, PV_RIFT_FAR_PLANE, true);
+		if (this->reverseDepth)
+		{
+			// With the far plane at infinity the depth is just the near plane's distance over the fragment's, which
+			// is 1 at the near plane and falls towards 0 with distance.
+			proj.M[2][2] = 0.0f;
+			proj.M[2][3] = PV_RIFT_NEAR_PLANE;
+		}
 		for (int y = 0; y < 4; y += 1)
 		{
 			for (int x = 0; x < 4; x += 1)
@@ -355,6 +1556,10 @@ namespace PV
 	*/
 	const orientation_t OculusRift::GetRotation() const
 	{
+		if (this->tracking)
+		{
+			return this->trackedPose.GetState().rotation;
+		}
 		return this->Orientation;
 	}
 
@@ -371,10 +1576,47 @@ namespace PV
 	 */
 	OculusRift::~OculusRift()
 	{
+		this->StopTracking();
+
+		for (int i = 0; i < 2; i += 1)
+		{
+			if (this->hiddenAreaVertexArrays[i] != 0)
+			{
+				pv_glDeleteVertexArrays(1, &this->hiddenAreaVertexArrays[i]);
+				pv_glDeleteBuffers(1, &this->hiddenAreaBuffers[i]);
+			}
+			if (this->sampleQueries[i][0] != 0)
+			{
+				pv_glDeleteQueries(PV_SAMPLE_QUERIES, this->sampleQueries[i]);
+			}
+		}
+		if (this->hiddenAreaProgram != 0 && this->ownsHiddenAreaProgram)
+		{
+			pv_glDeleteProgram(this->hiddenAreaProgram);
+		}
+		for (int i = 0; i < 2; i += 1)
+		{
+			if (this->peripheryFrameBuffers[i] != 0)
+			{
+				pv_glDeleteFramebuffers(1, &this->peripheryFrameBuffers[i]);
+				pv_glDeleteRenderbuffers(1, &this->peripheryDepthBuffers[i]);
+				glDeleteTextures(1, &this->peripheryTextures[i]);
+			}
+		}
+		if (this->eyeViewBuffer != 0)
+		{
+			if (this->eyeViewBufferData != NULL)
+			{
+				pv_glBindBuffer(PV_GL_UNIFORM_BUFFER, this->eyeViewBuffer);
+				pv_glUnmapBuffer(PV_GL_UNIFORM_BUFFER);
+				pv_glBindBuffer(PV_GL_UNIFORM_BUFFER, 0);
+			}
+			pv_glDeleteBuffers(1, &this->eyeViewBuffer);
+		}
 		if (this->HMD != NULL)
 		{
 			ovrHmd_Destroy(this->HMD);
 		}
-		ovr_Shutdown();
+		ShutdownRift();
 	}
 };
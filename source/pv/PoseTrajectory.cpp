@@ -0,0 +1,151 @@
+#include "pv/PoseTrajectory.h"
+#include <stdio.h>
+#include <math.h>
+
+namespace PV
+{
+	PoseTrajectory::PoseTrajectory()
+	{
+		// Look about 30 degrees to each side and 10 degrees up and down, every 4 seconds.
+		this->SetScripted(0.52f, 0.17f, 4.0f);
+	}
+
+	void PoseTrajectory::SetScripted(float yawAmplitude, float pitchAmplitude, float period)
+	{
+		this->Clear();
+		this->yawAmplitude = yawAmplitude;
+		this->pitchAmplitude = pitchAmplitude;
+		this->period = (period > 0.0f) ? period : 1.0f;
+	}
+
+	void PoseTrajectory::AddPose(double time, const ovrPosef& pose)
+	{
+		this->times.push_back(time);
+		this->poses.push_back(pose);
+	}
+
+	void PoseTrajectory::Clear()
+	{
+		this->times.clear();
+		this->poses.clear();
+	}
+
+	bool PoseTrajectory::Load(const char* fileName)
+	{
+		FILE* file = fopen(fileName, "r");
+		if (file == NULL)
+		{
+			printf("Error opening trajectory file %s!\n", fileName);
+			return false;
+		}
+
+		this->Clear();
+		double time;
+		ovrPosef pose;
+		while (fscanf(file, "%lf %f %f %f %f %f %f %f", &time,
+			&pose.Orientation.x, &pose.Orientation.y, &pose.Orientation.z, &pose.Orientation.w,
+			&pose.Position.x, &pose.Position.y, &pose.Position.z) == 8)
+		{
+			this->AddPose(time, pose);
+		}
+		fclose(file);
+
+		return !this->IsScripted();
+	}
+
+	bool PoseTrajectory::Save(const char* fileName) const
+	{
+		FILE* file = fopen(fileName, "w");
+		if (file == NULL)
+		{
+			printf("Error opening trajectory file %s!\n", fileName);
+			return false;
+		}
+
+		for (unsigned int i = 0; i < this->poses.size(); i += 1)
+		{
+			const ovrPosef& pose = this->poses[i];
+			fprintf(file, "%f %f %f %f %f %f %f %f\n", this->times[i],
+				pose.Orientation.x, pose.Orientation.y, pose.Orientation.z, pose.Orientation.w,
+				pose.Position.x, pose.Position.y, pose.Position.z);
+		}
+		fclose(file);
+		return true;
+	}
+
+	const bool PoseTrajectory::IsScripted() const
+	{
+		return this->poses.empty();
+	}
+
+	const unsigned int PoseTrajectory::Size() const
+	{
+		return (const unsigned int)this->poses.size();
+	}
+
+	ovrPosef PoseTrajectory::Sample(double time) const
+	{
+		if (this->IsScripted())
+		{
+			// Sweep the yaw back and forth while nodding at twice the rate, so both axes are always moving.
+			double phase = 2.0 * 3.14159265358979323846 * time / this->period;
+			float yaw = this->yawAmplitude * (float)sin(phase);
+			float pitch = this->pitchAmplitude * (float)sin(phase * 2.0);
+
+			OVR::Quatf orientation = OVR::Quatf(OVR::Vector3f(0.0f, 1.0f, 0.0f), yaw) * OVR::Quatf(OVR::Vector3f(1.0f, 0.0f, 0.0f), pitch);
+			ovrPosef pose;
+			pose.Orientation = orientation;
+			pose.Position.x = 0.0f;
+			pose.Position.y = 0.0f;
+			pose.Position.z = 0.0f;
+			return pose;
+		}
+
+		// Loop the recording, measuring time from the first recorded pose.
+		unsigned int count = (unsigned int)this->poses.size();
+		double start = this->times[0];
+		double duration = this->times[count - 1] - start;
+		if (count == 1 || duration <= 0.0)
+		{
+			return this->poses[0];
+		}
+		time = fmod(time, duration);
+		if (time < 0.0)
+		{
+			time += duration;
+		}
+		time += start;
+
+		// Find the first recorded pose after the time, then blend it with the one before.
+		unsigned int low = 0;
+		unsigned int high = count - 1;
+		while (high - low > 1)
+		{
+			unsigned int middle = (low + high) / 2;
+			if (this->times[middle] <= time)
+			{
+				low = middle;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		double span = this->times[high] - this->times[low];
+		float blend = (span > 0.0) ? (float)((time - this->times[low]) / span) : 0.0f;
+
+		OVR::Quatf from = this->poses[low].Orientation;
+		OVR::Quatf to = this->poses[high].Orientation;
+		if (from.Dot(to) < 0.0f)
+		{
+			to = to * -1.0f;
+		}
+		OVR::Vector3f fromPosition = this->poses[low].Position;
+		OVR::Vector3f toPosition = this->poses[high].Position;
+
+		ovrPosef pose;
+		pose.Orientation = (from * (1.0f - blend) + to * blend).Normalized();
+		pose.Position = fromPosition.Lerp(toPosition, blend);
+		return pose;
+	}
+};
@@ -0,0 +1,476 @@
+#include "pv/SensorCapture.h"
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+namespace PV
+{
+	/**
+	 * The number of quantized values in a captured pose: the quaternion, then the position.
+	 */
+#define PV_CAPTURE_POSE_VALUES 7
+	/**
+	 * The number of quantized values in a captured skeleton's joints.
+	 */
+#define PV_CAPTURE_JOINT_VALUES (PV_CAPTURE_JOINTS * 3)
+
+	/**
+	 * Appends a signed integer to a buffer as a zigzag encoded variable length integer, so that small values of
+	 * either sign take a single byte.
+	 * @param buffer The buffer to append to.
+	 * @param value The value to append.
+	 */
+	static void writeVarint(std::vector<unsigned char> &buffer, long long value)
+	{
+		unsigned long long zigzag = ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+		while (zigzag >= 0x80)
+		{
+			buffer.push_back((unsigned char)(zigzag | 0x80));
+			zigzag >>= 7;
+		}
+		buffer.push_back((unsigned char)zigzag);
+	}
+
+	/**
+	 * Reads a zigzag encoded variable length integer written by writeVarint.
+	 * @param data The data to read from.
+	 * @param size The size of the data.
+	 * @param offset The offset to read at, which is moved past the integer.
+	 * @param value The value read.
+	 * @return Returns true if a whole integer was read, false if the data ran out.
+	 */
+	static bool readVarint(const unsigned char* data, unsigned int size, unsigned int &offset, long long &value)
+	{
+		unsigned long long zigzag = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (offset >= size)
+			{
+				return false;
+			}
+			unsigned char byte = data[offset];
+			offset += 1;
+			zigzag |= (unsigned long long)(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+			{
+				value = (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Quantizes the values of a pose, a quaternion in 1/32767ths and a position in tenths of a millimeter.
+	 * @param pose The pose to quantize.
+	 * @param values The 7 quantized values.
+	 */
+	static void quantizePose(const ovrPosef &pose, long long* values)
+	{
+		values[0] = (long long)floor(pose.Orientation.x * 32767.0f + 0.5f);
+		values[1] = (long long)floor(pose.Orientation.y * 32767.0f + 0.5f);
+		values[2] = (long long)floor(pose.Orientation.z * 32767.0f + 0.5f);
+		values[3] = (long long)floor(pose.Orientation.w * 32767.0f + 0.5f);
+		values[4] = (long long)floor(pose.Position.x * 10000.0f + 0.5f);
+		values[5] = (long long)floor(pose.Position.y * 10000.0f + 0.5f);
+		values[6] = (long long)floor(pose.Position.z * 10000.0f + 0.5f);
+	}
+
+	SensorRecorder::SensorRecorder() : skeletonsQueued(0), posesQueued(0), skeletonsWritten(0), posesWritten(0),
+		samplesDropped(0), bytesWritten(0), recording(false)
+	{
+		this->file = NULL;
+		this->startTime = 0.0;
+	}
+
+	bool SensorRecorder::Start(const char* fileName)
+	{
+		if (this->recording)
+		{
+			return false;
+		}
+
+		this->file = fopen(fileName, "wb");
+		if (this->file == NULL)
+		{
+			printf("Error opening sensor capture file %s!\n", fileName);
+			return false;
+		}
+
+		const unsigned char header[8] = { 'P', 'V', 'S', 'C', PV_CAPTURE_VERSION & 0xFF, 0, 0, 0 };
+		fwrite(header, 1, sizeof(header), this->file);
+
+		this->startTime = ovr_GetTimeInSeconds();
+		this->skeletonsQueued = 0;
+		this->posesQueued = 0;
+		this->skeletonsWritten = 0;
+		this->posesWritten = 0;
+		this->samplesDropped = 0;
+		this->bytesWritten = sizeof(header);
+		this->recording = true;
+		this->thread = std::thread(&SensorRecorder::run, this);
+		return true;
+	}
+
+	void SensorRecorder::Stop()
+	{
+		if (!this->recording)
+		{
+			return;
+		}
+
+		this->recording = false;
+		this->thread.join();
+		fclose(this->file);
+		this->file = NULL;
+	}
+
+	const bool SensorRecorder::IsRecording() const
+	{
+		return this->recording;
+	}
+
+	void SensorRecorder::AddSkeleton(double time, const CapturedSkeleton& skeleton)
+	{
+		if (!this->recording)
+		{
+			return;
+		}
+
+		unsigned int queued = this->skeletonsQueued.load(std::memory_order_relaxed);
+		if (queued - this->skeletonsWritten.load(std::memory_order_acquire) >= PV_CAPTURE_QUEUE)
+		{
+			this->samplesDropped += 1;
+			return;
+		}
+		CapturedSkeleton& slot = this->skeletonQueue[queued % PV_CAPTURE_QUEUE];
+		slot = skeleton;
+		slot.time = time - this->startTime;
+		this->skeletonsQueued.store(queued + 1, std::memory_order_release);
+	}
+
+	void SensorRecorder::AddPose(double time, const ovrPosef& pose)
+	{
+		if (!this->recording)
+		{
+			return;
+		}
+
+		unsigned int queued = this->posesQueued.load(std::memory_order_relaxed);
+		if (queued - this->posesWritten.load(std::memory_order_acquire) >= PV_CAPTURE_QUEUE)
+		{
+			this->samplesDropped += 1;
+			return;
+		}
+		CapturedPose& slot = this->poseQueue[queued % PV_CAPTURE_QUEUE];
+		slot.time = time - this->startTime;
+		slot.pose = pose;
+		this->posesQueued.store(queued + 1, std::memory_order_release);
+	}
+
+	const unsigned int SensorRecorder::GetBytesWritten() const
+	{
+		return this->bytesWritten;
+	}
+
+	const unsigned int SensorRecorder::GetSamplesDropped() const
+	{
+		return this->samplesDropped;
+	}
+
+	void SensorRecorder::run()
+	{
+		// Every value is stored as the difference from the previous record of the same type, starting from 0.
+		long long previousPoseTime = 0;
+		long long previousSkeletonTime = 0;
+		long long previousPose[PV_CAPTURE_POSE_VALUES];
+		long long previousJoints[PV_CAPTURE_JOINT_VALUES];
+		memset(previousPose, 0, sizeof(previousPose));
+		memset(previousJoints, 0, sizeof(previousJoints));
+
+		std::vector<unsigned char> buffer;
+		unsigned int skeletonsWritten = 0;
+		unsigned int posesWritten = 0;
+		bool done = false;
+		while (!done)
+		{
+			// Check for stopping before draining, so whatever was queued before stopping is still written.
+			done = !this->recording;
+			unsigned int skeletonsQueued = this->skeletonsQueued.load(std::memory_order_acquire);
+			unsigned int posesQueued = this->posesQueued.load(std::memory_order_acquire);
+			if (skeletonsWritten == skeletonsQueued && posesWritten == posesQueued)
+			{
+				if (!done)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				continue;
+			}
+
+			buffer.clear();
+			while (posesWritten != posesQueued)
+			{
+				const CapturedPose& pose = this->poseQueue[posesWritten % PV_CAPTURE_QUEUE];
+				long long time = (long long)floor(pose.time * 1000000.0 + 0.5);
+				long long values[PV_CAPTURE_POSE_VALUES];
+				quantizePose(pose.pose, values);
+
+				buffer.push_back('H');
+				writeVarint(buffer, time - previousPoseTime);
+				for (int i = 0; i < PV_CAPTURE_POSE_VALUES; i += 1)
+				{
+					writeVarint(buffer, values[i] - previousPose[i]);
+					previousPose[i] = values[i];
+				}
+				previousPoseTime = time;
+				posesWritten += 1;
+				this->posesWritten.store(posesWritten, std::memory_order_release);
+			}
+			while (skeletonsWritten != skeletonsQueued)
+			{
+				const CapturedSkeleton& skeleton = this->skeletonQueue[skeletonsWritten % PV_CAPTURE_QUEUE];
+				long long time = (long long)floor(skeleton.time * 1000000.0 + 0.5);
+
+				buffer.push_back('K');
+				writeVarint(buffer, time - previousSkeletonTime);
+				buffer.push_back(skeleton.tracked ? 1 : 0);
+				if (skeleton.tracked)
+				{
+					long long states = 0;
+					for (int i = 0; i < PV_CAPTURE_JOINTS; i += 1)
+					{
+						states |= (long long)(skeleton.jointStates[i] & 3) << (i * 2);
+					}
+					writeVarint(buffer, states);
+					for (int i = 0; i < PV_CAPTURE_JOINT_VALUES; i += 1)
+					{
+						long long value = (long long)floor(skeleton.joints[i / 3][i % 3] * 10000.0f + 0.5f);
+						writeVarint(buffer, value - previousJoints[i]);
+						previousJoints[i] = value;
+					}
+				}
+				previousSkeletonTime = time;
+				skeletonsWritten += 1;
+				this->skeletonsWritten.store(skeletonsWritten, std::memory_order_release);
+			}
+
+			fwrite(&buffer[0], 1, buffer.size(), this->file);
+			this->bytesWritten += (unsigned int)buffer.size();
+		}
+	}
+
+	SensorRecorder::~SensorRecorder()
+	{
+		this->Stop();
+	}
+
+	SensorReplay::SensorReplay()
+	{
+		this->startTime = 0.0;
+		this->startPlaybackTime = 0.0;
+		this->speed = 0.0;
+	}
+
+	bool SensorReplay::Load(const char* fileName)
+	{
+		FILE* file = fopen(fileName, "rb");
+		if (file == NULL)
+		{
+			printf("Error opening sensor capture file %s!\n", fileName);
+			return false;
+		}
+		std::vector<unsigned char> data;
+		unsigned char chunk[4096];
+		size_t read;
+		while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		{
+			data.insert(data.end(), chunk, chunk + read);
+		}
+		fclose(file);
+
+		this->skeletons.clear();
+		this->poses.clear();
+		unsigned int size = (unsigned int)data.size();
+		if (size < 8 || memcmp(&data[0], "PVSC", 4) != 0 || data[4] != PV_CAPTURE_VERSION)
+		{
+			printf("%s is not a sensor capture this version can read!\n", fileName);
+			return false;
+		}
+
+		long long poseTime = 0;
+		long long skeletonTime = 0;
+		long long pose[PV_CAPTURE_POSE_VALUES];
+		long long joints[PV_CAPTURE_JOINT_VALUES];
+		memset(pose, 0, sizeof(pose));
+		memset(joints, 0, sizeof(joints));
+
+		unsigned int offset = 8;
+		bool valid = true;
+		while (valid && offset < size)
+		{
+			unsigned char type = data[offset];
+			offset += 1;
+			long long delta = 0;
+			if (type == 'H')
+			{
+				valid = readVarint(&data[0], size, offset, delta);
+				poseTime += delta;
+				for (int i = 0; valid && i < PV_CAPTURE_POSE_VALUES; i += 1)
+				{
+					valid = readVarint(&data[0], size, offset, delta);
+					pose[i] += delta;
+				}
+				if (valid)
+				{
+					CapturedPose captured;
+					captured.time = poseTime / 1000000.0;
+					captured.pose.Orientation.x = pose[0] / 32767.0f;
+					captured.pose.Orientation.y = pose[1] / 32767.0f;
+					captured.pose.Orientation.z = pose[2] / 32767.0f;
+					captured.pose.Orientation.w = pose[3] / 32767.0f;
+					captured.pose.Position.x = pose[4] / 10000.0f;
+					captured.pose.Position.y = pose[5] / 10000.0f;
+					captured.pose.Position.z = pose[6] / 10000.0f;
+					this->poses.push_back(captured);
+				}
+			}
+			else if (type == 'K')
+			{
+				CapturedSkeleton captured;
+				memset(&captured, 0, sizeof(captured));
+				valid = readVarint(&data[0], size, offset, delta) && offset < size;
+				skeletonTime += delta;
+				captured.time = skeletonTime / 1000000.0;
+				captured.tracked = valid && data[offset] != 0;
+				offset += 1;
+				if (valid && captured.tracked)
+				{
+					long long states = 0;
+					valid = readVarint(&data[0], size, offset, states);
+					for (int i = 0; i < PV_CAPTURE_JOINTS; i += 1)
+					{
+						captured.jointStates[i] = (unsigned char)((states >> (i * 2)) & 3);
+					}
+					for (int i = 0; valid && i < PV_CAPTURE_JOINT_VALUES; i += 1)
+					{
+						valid = readVarint(&data[0], size, offset, delta);
+						joints[i] += delta;
+						captured.joints[i / 3][i % 3] = joints[i] / 10000.0f;
+					}
+				}
+				if (valid)
+				{
+					this->skeletons.push_back(captured);
+				}
+			}
+			else
+			{
+				valid = false;
+			}
+		}
+		if (!valid)
+		{
+			// A recording cut short still plays back up to where it was cut.
+			printf("Sensor capture %s ends with a partial record, ignoring it.\n", fileName);
+		}
+
+		this->SetTime(0.0);
+		return true;
+	}
+
+	void SensorReplay::Start(double speed)
+	{
+		this->startTime = ovr_GetTimeInSeconds();
+		this->startPlaybackTime = 0.0;
+		this->speed = (speed > 0.0) ? speed : 1.0;
+	}
+
+	void SensorReplay::SetTime(double time)
+	{
+		this->startPlaybackTime = time;
+		this->speed = 0.0;
+	}
+
+	const double SensorReplay::GetTimeAt(double clockTime) const
+	{
+		return this->startPlaybackTime + (clockTime - this->startTime) * this->speed;
+	}
+
+	const double SensorReplay::GetTime() const
+	{
+		return (this->speed > 0.0) ? this->GetTimeAt(ovr_GetTimeInSeconds()) : this->startPlaybackTime;
+	}
+
+	const double SensorReplay::GetDuration() const
+	{
+		double duration = 0.0;
+		if (!this->skeletons.empty())
+		{
+			duration = this->skeletons.back().time;
+		}
+		if (!this->poses.empty() && this->poses.back().time > duration)
+		{
+			duration = this->poses.back().time;
+		}
+		return duration;
+	}
+
+	const int SensorReplay::FindSkeleton(double time) const
+	{
+		// Find the first skeleton after the time, the one before it is the newest at the time.
+		unsigned int low = 0;
+		unsigned int high = (unsigned int)this->skeletons.size();
+		while (low < high)
+		{
+			unsigned int middle = (low + high) / 2;
+			if (this->skeletons[middle].time <= time)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return (int)low - 1;
+	}
+
+	const int SensorReplay::FindPose(double time) const
+	{
+		unsigned int low = 0;
+		unsigned int high = (unsigned int)this->poses.size();
+		while (low < high)
+		{
+			unsigned int middle = (low + high) / 2;
+			if (this->poses[middle].time <= time)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return (int)low - 1;
+	}
+
+	const CapturedSkeleton& SensorReplay::GetSkeleton(unsigned int index) const
+	{
+		return this->skeletons[index];
+	}
+
+	const CapturedPose& SensorReplay::GetPose(unsigned int index) const
+	{
+		return this->poses[index];
+	}
+
+	const unsigned int SensorReplay::SkeletonCount() const
+	{
+		return (const unsigned int)this->skeletons.size();
+	}
+
+	const unsigned int SensorReplay::PoseCount() const
+	{
+		return (const unsigned int)this->poses.size();
+	}
+};
@@ -0,0 +1,202 @@
+#include "pv/SkeletonFilter.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define PV_SKELETON_FILTER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace PV
+{
+	SkeletonFilter::SkeletonFilter()
+	{
+		// The Kinect's very smooth parameters, with the same meaning as NUI_TRANSFORM_SMOOTH_PARAMETERS.
+		this->SetHoltParameters(-1, 0.7f, 0.3f, 1.0f);
+		// A still joint is cut off at 1 hertz, and the cutoff rises quickly enough that a hand moving at walking
+		// pace lags by under 2 centimeters.
+		this->SetOneEuroParameters(-1, 1.0f, 20.0f, 1.0f);
+		this->SetType(FilterHolt);
+	}
+
+	void SkeletonFilter::SetType(SkeletonFilterType type)
+	{
+		this->type = type;
+		this->Reset();
+	}
+
+	const SkeletonFilterType SkeletonFilter::GetType() const
+	{
+		return this->type;
+	}
+
+	void SkeletonFilter::SetHoltParameters(int joint, float smoothing, float correction, float prediction)
+	{
+		int first = (joint < 0) ? 0 : joint;
+		int last = (joint < 0) ? PV_SKELETON_JOINTS : joint + 1;
+		for (int i = first; i < last && i < PV_SKELETON_JOINTS; i += 1)
+		{
+			this->holtAlpha[i] = 1.0f - smoothing;
+			this->holtGamma[i] = correction;
+			this->holtPrediction[i] = prediction;
+		}
+	}
+
+	void SkeletonFilter::SetOneEuroParameters(int joint, float minimumCutoff, float speedCoefficient, float derivativeCutoff)
+	{
+		int first = (joint < 0) ? 0 : joint;
+		int last = (joint < 0) ? PV_SKELETON_JOINTS : joint + 1;
+		for (int i = first; i < last && i < PV_SKELETON_JOINTS; i += 1)
+		{
+			this->minimumCutoff[i] = minimumCutoff;
+			this->speedCoefficient[i] = speedCoefficient;
+			this->derivativeCutoff[i] = derivativeCutoff;
+		}
+	}
+
+	void SkeletonFilter::Reset()
+	{
+		for (int i = 0; i < PV_SKELETON_PEOPLE; i += 1)
+		{
+			this->initialized[i] = false;
+		}
+		this->previousTime = 0.0;
+	}
+
+	void SkeletonFilter::Apply(SkeletonFrame& frame)
+	{
+		if (this->type == FilterNone)
+		{
+			return;
+		}
+
+		// Sources which do not time their frames are assumed to run at the Kinect's 30 frames per second.
+		float elapsed = (this->previousTime > 0.0 && frame.time > this->previousTime) ? (float)(frame.time - this->previousTime) : (1.0f / 30.0f);
+		this->previousTime = frame.time;
+
+		for (int person = 0; person < PV_SKELETON_PEOPLE; person += 1)
+		{
+			if (!frame.tracked[person])
+			{
+				this->initialized[person] = false;
+				continue;
+			}
+
+			float* positions[3] = { frame.x[person], frame.y[person], frame.z[person] };
+			if (!this->initialized[person])
+			{
+				// Start from wherever the person is, standing still.
+				for (int axis = 0; axis < 3; axis += 1)
+				{
+					memcpy(this->position[axis][person], positions[axis], sizeof(float) * PV_SKELETON_JOINTS);
+					memcpy(this->previous[axis][person], positions[axis], sizeof(float) * PV_SKELETON_JOINTS);
+					memset(this->trend[axis][person], 0, sizeof(float) * PV_SKELETON_JOINTS);
+				}
+				this->initialized[person] = true;
+				continue;
+			}
+
+			if (this->type == FilterHolt)
+			{
+				this->applyHolt(person, positions);
+			}
+			else
+			{
+				this->applyOneEuro(person, positions, elapsed);
+			}
+		}
+	}
+
+	void SkeletonFilter::applyHolt(int person, float** positions)
+	{
+		for (int axis = 0; axis < 3; axis += 1)
+		{
+			float* input = positions[axis];
+			float* level = this->position[axis][person];
+			float* trend = this->trend[axis][person];
+			int joint = 0;
+#ifdef PV_SKELETON_FILTER_SSE
+			const __m128 one = _mm_set1_ps(1.0f);
+			for (; joint + 4 <= PV_SKELETON_JOINTS; joint += 4)
+			{
+				__m128 x = _mm_loadu_ps(input + joint);
+				__m128 l = _mm_loadu_ps(level + joint);
+				__m128 t = _mm_loadu_ps(trend + joint);
+				__m128 alpha = _mm_loadu_ps(this->holtAlpha + joint);
+				__m128 gamma = _mm_loadu_ps(this->holtGamma + joint);
+				__m128 prediction = _mm_loadu_ps(this->holtPrediction + joint);
+
+				__m128 newLevel = _mm_add_ps(_mm_mul_ps(alpha, x), _mm_mul_ps(_mm_sub_ps(one, alpha), _mm_add_ps(l, t)));
+				__m128 newTrend = _mm_add_ps(_mm_mul_ps(gamma, _mm_sub_ps(newLevel, l)), _mm_mul_ps(_mm_sub_ps(one, gamma), t));
+				_mm_storeu_ps(level + joint, newLevel);
+				_mm_storeu_ps(trend + joint, newTrend);
+				_mm_storeu_ps(input + joint, _mm_add_ps(newLevel, _mm_mul_ps(prediction, newTrend)));
+			}
+#endif
+			for (; joint < PV_SKELETON_JOINTS; joint += 1)
+			{
+				float alpha = this->holtAlpha[joint];
+				float gamma = this->holtGamma[joint];
+				float newLevel = alpha * input[joint] + (1.0f - alpha) * (level[joint] + trend[joint]);
+				float newTrend = gamma * (newLevel - level[joint]) + (1.0f - gamma) * trend[joint];
+				level[joint] = newLevel;
+				trend[joint] = newTrend;
+				input[joint] = newLevel + this->holtPrediction[joint] * newTrend;
+			}
+		}
+	}
+
+	void SkeletonFilter::applyOneEuro(int person, float** positions, float elapsed)
+	{
+		// A low pass filter with a cutoff frequency f blends in r / (r + 1) of each new value, where r = 2 pi f dt.
+		const float rate = 2.0f * 3.14159265f * elapsed;
+		for (int axis = 0; axis < 3; axis += 1)
+		{
+			float* input = positions[axis];
+			float* filtered = this->position[axis][person];
+			float* speed = this->trend[axis][person];
+			float* previous = this->previous[axis][person];
+			int joint = 0;
+#ifdef PV_SKELETON_FILTER_SSE
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 r = _mm_set1_ps(rate);
+			const __m128 inverseElapsed = _mm_set1_ps(1.0f / elapsed);
+			const __m128 sign = _mm_set1_ps(-0.0f);
+			for (; joint + 4 <= PV_SKELETON_JOINTS; joint += 4)
+			{
+				__m128 x = _mm_loadu_ps(input + joint);
+
+				// Smooth the speed, then use it to pick how much to smooth the position.
+				__m128 derivativeRate = _mm_mul_ps(r, _mm_loadu_ps(this->derivativeCutoff + joint));
+				__m128 derivativeAlpha = _mm_div_ps(derivativeRate, _mm_add_ps(derivativeRate, one));
+				__m128 rawSpeed = _mm_mul_ps(_mm_sub_ps(x, _mm_loadu_ps(previous + joint)), inverseElapsed);
+				__m128 s = _mm_loadu_ps(speed + joint);
+				s = _mm_add_ps(s, _mm_mul_ps(derivativeAlpha, _mm_sub_ps(rawSpeed, s)));
+
+				__m128 cutoff = _mm_add_ps(_mm_loadu_ps(this->minimumCutoff + joint), _mm_mul_ps(_mm_loadu_ps(this->speedCoefficient + joint), _mm_andnot_ps(sign, s)));
+				__m128 cutoffRate = _mm_mul_ps(r, cutoff);
+				__m128 alpha = _mm_div_ps(cutoffRate, _mm_add_ps(cutoffRate, one));
+				__m128 f = _mm_loadu_ps(filtered + joint);
+				f = _mm_add_ps(f, _mm_mul_ps(alpha, _mm_sub_ps(x, f)));
+
+				_mm_storeu_ps(speed + joint, s);
+				_mm_storeu_ps(filtered + joint, f);
+				_mm_storeu_ps(previous + joint, x);
+				_mm_storeu_ps(input + joint, f);
+			}
+#endif
+			for (; joint < PV_SKELETON_JOINTS; joint += 1)
+			{
+				float x = input[joint];
+				float derivativeRate = rate * this->derivativeCutoff[joint];
+				float rawSpeed = (x - previous[joint]) / elapsed;
+				speed[joint] += derivativeRate / (derivativeRate + 1.0f) * (rawSpeed - speed[joint]);
+
+				float cutoffRate = rate * (this->minimumCutoff[joint] + this->speedCoefficient[joint] * fabsf(speed[joint]));
+				filtered[joint] += cutoffRate / (cutoffRate + 1.0f) * (x - filtered[joint]);
+				previous[joint] = x;
+				input[joint] = filtered[joint];
+			}
+		}
+	}
+};
@@ -0,0 +1,148 @@
+#include "pv/SyntheticImages.h"
+#include "OVR_CAPI.h"
+#include <math.h>
+#include <chrono>
+
+namespace PV
+{
+	SyntheticImages::SyntheticImages(unsigned int width, unsigned int height, unsigned int rate)
+		: depthImages(ImageDepthPacked, width, height), colorImages(ImageColorBGRA, width, height), producing(false), framesProduced(0)
+	{
+		this->rate = (rate == 0) ? 30 : ((rate > 1000) ? 1000 : rate);
+		this->startTime = 0.0;
+	}
+
+	void SyntheticImages::Start()
+	{
+		if (!this->producing)
+		{
+			this->framesProduced = 0;
+			this->startTime = ovr_GetTimeInSeconds();
+			this->producing = true;
+			this->thread = std::thread(&SyntheticImages::run, this);
+		}
+	}
+
+	void SyntheticImages::Stop()
+	{
+		this->producing = false;
+		if (this->thread.joinable())
+		{
+			this->thread.join();
+		}
+	}
+
+	const bool SyntheticImages::IsProducingImages() const
+	{
+		return this->producing;
+	}
+
+	ImageFrame* SyntheticImages::AcquireLatestImage(ImageFormat format)
+	{
+		return (format == ImageDepthPacked) ? this->depthImages.AcquireLatest() : this->colorImages.AcquireLatest();
+	}
+
+	const double SyntheticImages::GetRate() const
+	{
+		double elapsed = ovr_GetTimeInSeconds() - this->startTime;
+		return (this->startTime > 0.0 && elapsed > 0.0) ? this->framesProduced / elapsed : 0.0;
+	}
+
+	const unsigned int SyntheticImages::GetDroppedCount() const
+	{
+		return this->depthImages.GetDroppedCount() + this->colorImages.GetDroppedCount();
+	}
+
+	void SyntheticImages::generate(ImageFrame& depth, ImageFrame& color, double time) const
+	{
+		// A ball 0.25 meters across swinging side to side 2 meters from the camera, in front of a wall at 3 meters.
+		const DepthCamera camera = GetKinectDepthCamera(depth.width, depth.height);
+		const float ballX = 0.6f * sinf((float)(time * 2.0 * 3.14159265358979323846 * 0.5));
+		const float ballZ = 2.0f;
+		const float radius = 0.25f;
+		const float centerColumn = camera.centerX + ballX * camera.focalX / ballZ;
+		const float centerRow = camera.centerY;
+		const float pixelRadius = radius * camera.focalX / ballZ;
+
+		for (unsigned int row = 0; row < depth.height; row += 1)
+		{
+			unsigned short* depthRow = (unsigned short*)(depth.pixels + (size_t)depth.pitch * row);
+			unsigned char* colorRow = color.pixels + (size_t)color.pitch * row;
+			float dy = (row - centerRow) / pixelRadius;
+			for (unsigned int column = 0; column < depth.width; column += 1)
+			{
+				float dx = (column - centerColumn) / pixelRadius;
+				float inside = 1.0f - dx * dx - dy * dy;
+				unsigned char* pixel = colorRow + column * 4;
+				if (inside > 0.0f)
+				{
+					float facing = sqrtf(inside);
+					unsigned short millimeters = (unsigned short)((ballZ - radius * facing) * 1000.0f);
+					depthRow[column] = (unsigned short)((millimeters << PV_DEPTH_SHIFT) | 1);
+					pixel[0] = 40;
+					pixel[1] = 40;
+					pixel[2] = (unsigned char)(80 + 175 * facing);
+				}
+				else
+				{
+					depthRow[column] = (unsigned short)(3000 << PV_DEPTH_SHIFT);
+					unsigned char shade = (((row / 32) + (column / 32)) & 1) ? 160 : 200;
+					pixel[0] = shade;
+					pixel[1] = shade;
+					pixel[2] = shade;
+				}
+				pixel[3] = 255;
+			}
+		}
+	}
+
+	void SyntheticImages::run()
+	{
+		double interval = 1.0 / this->rate;
+		double nextFrame = ovr_GetTimeInSeconds();
+		unsigned int frameIndex = 0;
+		while (this->producing)
+		{
+			double now = ovr_GetTimeInSeconds();
+			ImageFrame* depth = this->depthImages.Acquire();
+			ImageFrame* color = this->colorImages.Acquire();
+			if (depth != NULL && color != NULL)
+			{
+				this->generate(*depth, *color, now - this->startTime);
+				depth->time = color->time = now;
+				this->depthImages.Publish(depth);
+				this->colorImages.Publish(color);
+				frameIndex += 1;
+				this->framesProduced = frameIndex;
+			}
+			else
+			{
+				ReleaseImage(depth);
+				ReleaseImage(color);
+			}
+
+			// Same pacing as the Oculus Rift's tracking thread: sleep most of the way, then yield the rest.
+			nextFrame += interval;
+			while (this->producing && (now = ovr_GetTimeInSeconds()) < nextFrame)
+			{
+				if (nextFrame - now > 0.002)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			if (now - nextFrame > interval)
+			{
+				nextFrame = now;
+			}
+		}
+	}
+
+	SyntheticImages::~SyntheticImages()
+	{
+		this->Stop();
+	}
+};
@@ -0,0 +1,173 @@
+#include "pv/SyntheticSkeletons.h"
+#include "OVR_CAPI.h"
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+namespace PV
+{
+	/**
+	 * A person standing still with their arms at their sides, relative to the hip center, in meters.
+	 */
+	static const float restPose[PV_SKELETON_JOINTS][3] = {
+		{ 0.0f, 0.0f, 0.0f },		// Hip center
+		{ 0.0f, 0.08f, 0.01f },		// Spine
+		{ 0.0f, 0.48f, 0.0f },		// Shoulder center
+		{ 0.0f, 0.65f, 0.0f },		// Head
+		{ -0.18f, 0.42f, 0.0f },	// Shoulder left
+		{ -0.22f, 0.15f, 0.0f },	// Elbow left
+		{ -0.24f, -0.08f, 0.0f },	// Wrist left
+		{ -0.25f, -0.16f, 0.0f },	// Hand left
+		{ 0.18f, 0.42f, 0.0f },		// Shoulder right
+		{ 0.22f, 0.15f, 0.0f },		// Elbow right
+		{ 0.24f, -0.08f, 0.0f },	// Wrist right
+		{ 0.25f, -0.16f, 0.0f },	// Hand right
+		{ -0.08f, -0.06f, 0.0f },	// Hip left
+		{ -0.09f, -0.48f, 0.02f },	// Knee left
+		{ -0.09f, -0.88f, 0.0f },	// Ankle left
+		{ -0.09f, -0.93f, -0.08f },	// Foot left
+		{ 0.08f, -0.06f, 0.0f },	// Hip right
+		{ 0.09f, -0.48f, 0.02f },	// Knee right
+		{ 0.09f, -0.88f, 0.0f },	// Ankle right
+		{ 0.09f, -0.93f, -0.08f }	// Foot right
+	};
+
+	/**
+	 * How much each joint swings forward and back while walking, in meters, with the sign giving which side
+	 * of the stride it is on.
+	 */
+	static const float swing[PV_SKELETON_JOINTS] = {
+		0.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.08f, 0.16f, 0.18f,
+		0.0f, -0.08f, -0.16f, -0.18f,
+		0.0f, -0.12f, -0.2f, -0.22f,
+		0.0f, 0.12f, 0.2f, 0.22f
+	};
+
+	SyntheticSkeletons::SyntheticSkeletons(unsigned int people, unsigned int rate) : producing(false), framesProduced(0)
+	{
+		this->people = (people > PV_SKELETON_PEOPLE) ? PV_SKELETON_PEOPLE : people;
+		this->rate = (rate == 0) ? 30 : ((rate > 1000) ? 1000 : rate);
+		this->startTime = 0.0;
+
+		// Publish an empty frame into both slots so reading before the first frame gives nobody tracked.
+		SkeletonFrame empty;
+		memset(&empty, 0, sizeof(empty));
+		empty.mainPerson = -1;
+		this->latestFrame.SetState(empty);
+		this->latestFrame.SetState(empty);
+	}
+
+	void SyntheticSkeletons::Start()
+	{
+		if (!this->producing)
+		{
+			this->framesProduced = 0;
+			this->startTime = ovr_GetTimeInSeconds();
+			this->producing = true;
+			this->thread = std::thread(&SyntheticSkeletons::run, this);
+		}
+	}
+
+	void SyntheticSkeletons::Stop()
+	{
+		this->producing = false;
+		if (this->thread.joinable())
+		{
+			this->thread.join();
+		}
+	}
+
+	const bool SyntheticSkeletons::IsProducing() const
+	{
+		return this->producing;
+	}
+
+	void SyntheticSkeletons::GetLatestFrame(SkeletonFrame& frame) const
+	{
+		frame = this->latestFrame.GetState();
+	}
+
+	const double SyntheticSkeletons::GetRate() const
+	{
+		double elapsed = ovr_GetTimeInSeconds() - this->startTime;
+		return (this->startTime > 0.0 && elapsed > 0.0) ? this->framesProduced / elapsed : 0.0;
+	}
+
+	void SyntheticSkeletons::generate(SkeletonFrame& frame, double time) const
+	{
+		for (unsigned int person = 0; person < PV_SKELETON_PEOPLE; person += 1)
+		{
+			frame.tracked[person] = person < this->people;
+			if (!frame.tracked[person])
+			{
+				continue;
+			}
+
+			// Stand everybody in a row 2.5 meters from the sensor, each walking at a slightly different pace.
+			float phase = (float)(time * (1.6 + person * 0.15) * 2.0 * 3.14159265358979323846);
+			float stride = sinf(phase);
+			float bob = 0.02f * cosf(phase * 2.0f);
+			float hipX = ((float)person - (this->people - 1) * 0.5f) * 0.8f;
+			float hipY = 0.9f + bob;
+			float hipZ = 2.5f + 0.05f * sinf(phase * 0.5f);
+			frame.center[person][0] = hipX;
+			frame.center[person][1] = hipY;
+			frame.center[person][2] = hipZ;
+
+			float* x = frame.x[person];
+			float* y = frame.y[person];
+			float* z = frame.z[person];
+			for (int joint = 0; joint < PV_SKELETON_JOINTS; joint += 1)
+			{
+				x[joint] = hipX + restPose[joint][0];
+				y[joint] = hipY + restPose[joint][1];
+				z[joint] = hipZ + restPose[joint][2] + swing[joint] * stride;
+				frame.jointStates[person][joint] = 2;
+			}
+		}
+		frame.mainPerson = (this->people > 0) ? 0 : -1;
+	}
+
+	void SyntheticSkeletons::run()
+	{
+		double interval = 1.0 / this->rate;
+		double nextFrame = ovr_GetTimeInSeconds();
+		SkeletonFrame frame;
+		memset(&frame, 0, sizeof(frame));
+		unsigned int frameIndex = 0;
+		while (this->producing)
+		{
+			double now = ovr_GetTimeInSeconds();
+			this->generate(frame, now - this->startTime);
+			frame.time = now;
+			frameIndex += 1;
+			frame.frameIndex = frameIndex;
+			this->latestFrame.SetState(frame);
+			this->framesProduced = frameIndex;
+
+			// Same pacing as the Oculus Rift's tracking thread: sleep most of the way, then yield the rest.
+			nextFrame += interval;
+			while (this->producing && (now = ovr_GetTimeInSeconds()) < nextFrame)
+			{
+				if (nextFrame - now > 0.002)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			if (now - nextFrame > interval)
+			{
+				nextFrame = now;
+			}
+		}
+	}
+
+	SyntheticSkeletons::~SyntheticSkeletons()
+	{
+		this->Stop();
+	}
+};
@@ -0,0 +1,157 @@
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmsystem.h>
+#endif
+#include "pvmm/FramePacer.h"
+#include "OVR_CAPI.h"
+#include <math.h>
+#include <chrono>
+#include <thread>
+
+namespace PV
+{
+	FramePacer::FramePacer()
+	{
+		this->interval = 0.0;
+		this->nextFrame = 0.0;
+		this->swapStart = 0.0;
+		this->limiterTime = 0.0;
+		this->raisedTimerResolution = false;
+		this->ResetStats();
+	}
+
+	void FramePacer::SetFrameLimit(double framesPerSecond)
+	{
+		this->interval = (framesPerSecond > 0.0) ? 1.0 / framesPerSecond : 0.0;
+		this->nextFrame = 0.0;
+#ifdef _WIN32
+		// Windows sleeps in steps of 15.6 milliseconds unless asked for 1, which would make the limiter mostly spin.
+		if (this->interval > 0.0 && !this->raisedTimerResolution)
+		{
+			this->raisedTimerResolution = timeBeginPeriod(1) == TIMERR_NOERROR;
+		}
+		else if (this->interval == 0.0 && this->raisedTimerResolution)
+		{
+			timeEndPeriod(1);
+			this->raisedTimerResolution = false;
+		}
+#endif
+	}
+
+	const double FramePacer::GetFrameLimit() const
+	{
+		return (this->interval > 0.0) ? 1.0 / this->interval : 0.0;
+	}
+
+	void FramePacer::BeginSwap()
+	{
+		double now = ovr_GetTimeInSeconds();
+		double start = now;
+		if (this->interval > 0.0)
+		{
+			if (this->nextFrame == 0.0)
+			{
+				this->nextFrame = now;
+			}
+			// Same pacing as the Oculus Rift's tracking thread: sleep most of the way, then yield the rest.
+			while (now < this->nextFrame)
+			{
+				if (this->nextFrame - now > 0.002)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+				now = ovr_GetTimeInSeconds();
+			}
+			this->nextFrame += this->interval;
+			// A frame that ran long starts a new schedule rather than letting the following frames rush to catch up.
+			// Once the next frame is already due it would not wait at all, so that is the point to start over.
+			if (now > this->nextFrame)
+			{
+				this->nextFrame = now + this->interval;
+			}
+		}
+		this->limiterTime = now - start;
+		this->swapStart = now;
+	}
+
+	void FramePacer::EndSwap()
+	{
+		double now = ovr_GetTimeInSeconds();
+		if (this->lastSwap > 0.0)
+		{
+			this->intervals[this->next] = now - this->lastSwap;
+			this->swapTimes[this->next] = now - this->swapStart;
+			this->limiterTimes[this->next] = this->limiterTime;
+			this->next = (this->next + 1) % PV_FRAME_HISTORY;
+			if (this->count < PV_FRAME_HISTORY)
+			{
+				this->count += 1;
+			}
+		}
+		this->lastSwap = now;
+	}
+
+	const FrameStats FramePacer::GetStats() const
+	{
+		FrameStats stats;
+		stats.frames = this->count;
+		stats.averageInterval = 0.0;
+		stats.minimumInterval = 0.0;
+		stats.maximumInterval = 0.0;
+		stats.jitter = 0.0;
+		stats.hitches = 0;
+		stats.averageSwapTime = 0.0;
+		stats.averageLimiterTime = 0.0;
+		if (this->count == 0)
+		{
+			return stats;
+		}
+
+		stats.minimumInterval = this->intervals[0];
+		for (unsigned int i = 0; i < this->count; i += 1)
+		{
+			stats.averageInterval += this->intervals[i];
+			stats.averageSwapTime += this->swapTimes[i];
+			stats.averageLimiterTime += this->limiterTimes[i];
+			stats.minimumInterval = (this->intervals[i] < stats.minimumInterval) ? this->intervals[i] : stats.minimumInterval;
+			stats.maximumInterval = (this->intervals[i] > stats.maximumInterval) ? this->intervals[i] : stats.maximumInterval;
+		}
+		stats.averageInterval /= this->count;
+		stats.averageSwapTime /= this->count;
+		stats.averageLimiterTime /= this->count;
+
+		double variance = 0.0;
+		for (unsigned int i = 0; i < this->count; i += 1)
+		{
+			double difference = this->intervals[i] - stats.averageInterval;
+			variance += difference * difference;
+			if (this->intervals[i] > stats.averageInterval * 1.5)
+			{
+				stats.hitches += 1;
+			}
+		}
+		stats.jitter = sqrt(variance / this->count);
+		return stats;
+	}
+
+	void FramePacer::ResetStats()
+	{
+		this->count = 0;
+		this->next = 0;
+		this->lastSwap = 0.0;
+	}
+
+	FramePacer::~FramePacer()
+	{
+#ifdef _WIN32
+		if (this->raisedTimerResolution)
+		{
+			timeEndPeriod(1);
+		}
+#endif
+	}
+};
@@ -0,0 +1,141 @@
+#include "pvmm/FramePipeline.h"
+#include "pvmm/WindowSystem.h"
+
+namespace PV
+{
+	FramePipeline::FramePipeline(unsigned int maxFramesAhead) : shared(1), published(0), acquired(0)
+	{
+		// Each side starts out owning one of the command lists, and the third is the shared one.
+		this->recordIndex = 0;
+		this->renderIndex = 2;
+		this->rendering = false;
+		this->maxFramesAhead = maxFramesAhead;
+		for (int i = 0; i < PV_PIPELINE_FRAMES; i += 1)
+		{
+			this->sequence[i] = 0;
+		}
+	}
+
+	RenderCommandList* FramePipeline::BeginFrame()
+	{
+		// Hold the simulation back while the renderer is too far behind, this is what ties the simulation
+		// to the renderer's vsync-paced rate instead of recording frames that will only be dropped.
+		// Sleeping rather than spinning leaves the core free for the renderer and the sensor threads.
+		if (this->maxFramesAhead > 0)
+		{
+			std::unique_lock<std::mutex> lock(this->acquiredMutex);
+			while (this->published.load(std::memory_order_acquire) - this->acquired.load(std::memory_order_acquire) >= this->maxFramesAhead)
+			{
+				this->acquiredCondition.wait(lock);
+			}
+		}
+
+		this->frames[this->recordIndex].Clear();
+		return &this->frames[this->recordIndex];
+	}
+
+	void FramePipeline::Publish()
+	{
+		unsigned int frameNumber = this->published.load(std::memory_order_relaxed) + 1;
+		this->sequence[this->recordIndex] = frameNumber;
+
+		// Swap the finished frame with the shared one.  Whatever was shared before is either a frame the
+		// renderer is done with or one it never picked up, and either way it is free to record into.
+		unsigned int previous = this->shared.exchange(this->recordIndex | PV_PIPELINE_NEW_FRAME, std::memory_order_acq_rel);
+		this->recordIndex = previous & ~PV_PIPELINE_NEW_FRAME;
+		this->published.store(frameNumber, std::memory_order_release);
+	}
+
+	const RenderCommandList* FramePipeline::Acquire()
+	{
+		// Only the simulation ever sets the new frame bit, so once it is seen it stays set until this swap.
+		if (this->shared.load(std::memory_order_acquire) & PV_PIPELINE_NEW_FRAME)
+		{
+			unsigned int previous = this->shared.exchange(this->renderIndex, std::memory_order_acq_rel);
+			this->renderIndex = previous & ~PV_PIPELINE_NEW_FRAME;
+			this->rendering = true;
+			{
+				// Stored under the lock, so a simulation about to wait cannot miss the wake up.
+				std::lock_guard<std::mutex> lock(this->acquiredMutex);
+				this->acquired.store(this->sequence[this->renderIndex], std::memory_order_release);
+			}
+			this->acquiredCondition.notify_one();
+		}
+		return (this->rendering) ? &this->frames[this->renderIndex] : NULL;
+	}
+
+	const bool FramePipeline::HasNewFrame() const
+	{
+		return (this->shared.load(std::memory_order_acquire) & PV_PIPELINE_NEW_FRAME) != 0;
+	}
+
+	const unsigned int FramePipeline::FramesPublished() const
+	{
+		return this->published.load(std::memory_order_acquire);
+	}
+
+	const unsigned int FramePipeline::FramesAcquired() const
+	{
+		return this->acquired.load(std::memory_order_acquire);
+	}
+
+	RenderThread::RenderThread() : running(false)
+	{
+		this->window = NULL;
+		this->pipeline = NULL;
+		this->callback = NULL;
+		this->userData = NULL;
+	}
+
+	void RenderThread::Start(Window* window, FramePipeline* pipeline, renderFrameCallback* callback, void* userData)
+	{
+		if (!this->running)
+		{
+			this->window = window;
+			this->pipeline = pipeline;
+			this->callback = callback;
+			this->userData = userData;
+			this->running = true;
+			this->thread = std::thread(&RenderThread::run, this);
+		}
+	}
+
+	void RenderThread::Stop()
+	{
+		this->running = false;
+		if (this->thread.joinable())
+		{
+			this->thread.join();
+		}
+	}
+
+	const bool RenderThread::IsRunning() const
+	{
+		return this->running;
+	}
+
+	void RenderThread::run()
+	{
+		// The OpenGL context belongs to this thread for as long as it runs.
+		this->window->MakeCurrentGLContext();
+
+		while (this->running)
+		{
+			const RenderCommandList* frame = this->pipeline->Acquire();
+			if (frame == NULL)
+			{
+				// Nothing has been published yet.
+				std::this_thread::yield();
+				continue;
+			}
+			this->callback(frame, this->userData);
+		}
+
+		this->window->ReleaseGLContext();
+	}
+
+	RenderThread::~RenderThread()
+	{
+		this->Stop();
+	}
+};
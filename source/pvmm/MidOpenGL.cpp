@@ -3,6 +3,10 @@
 #endif
 #include "pvmm/MidOpenGL.h"
 #include "pv/FileIO.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
 
 namespace PV
 {
@@ -52,141 +56,691 @@ namespace PV
 		}
 	}
 
+	/**
+	 * The directory linked programs are cached in, or empty if they are not cached.
+	 */
+	static std::string shaderCacheDirectory = ".";
+
+	/**
+	 * The start of every cached program file, to recognize them and tell their layout apart from future ones.
+	 */
+#define PV_PROGRAM_CACHE_MAGIC 0x31425650
+
+	/**
+	 * The header written in front of a cached program binary.
+	 */
+	struct ProgramCacheHeader
+	{
+		/**
+		 * PV_PROGRAM_CACHE_MAGIC.
+		 */
+		unsigned int magic;
+		/**
+		 * The driver's format of the binary.
+		 */
+		unsigned int format;
+		/**
+		 * The hash the file is named after, to catch files that were renamed or cut short.
+		 */
+		unsigned long long key;
+		/**
+		 * The size of the binary in bytes.
+		 */
+		unsigned int length;
+	};
+
+	/**
+	 * Adds a string to a 64 bit FNV-1a hash, along with its terminator so that moving text between strings
+	 * changes the hash.
+	 * @param hash The hash so far.
+	 * @param text The string to add, or NULL for an empty one.
+	 * @return The new hash.
+	 */
+	static unsigned long long hashString(unsigned long long hash, const char* text)
+	{
+		if (text != NULL)
+		{
+			for (; *text != '\0'; text += 1)
+			{
+				hash = (hash ^ (unsigned char)*text) * 1099511628211ULL;
+			}
+		}
+		return hash * 1099511628211ULL;
+	}
+
+	/**
+	 * Reads a whole shader file into a null terminated string.
+	 * @param fileName The file to read.
+	 * @return The file's contents, which must be freed with free, or NULL if the file could not be read.
+	 */
+	static char* loadShaderSource(const char* fileName)
+	{
+		File file(fileName, true);
+		if (!file.DataLoaded())
+		{
+			return NULL;
+		}
+		int length = file.Size();
+		char* data = (char*)malloc((length + 1) * sizeof(char));
+		memcpy(data, file.Data(), length);
+		data[length] = '\0';
+		return data;
+	}
+
+	std::string addShaderDefines(const char* source, const char* defines)
+	{
+		const char* body = source;
+		while (*body == ' ' || *body == '\t' || *body == '\r' || *body == '\n')
+		{
+			body += 1;
+		}
+		if (strncmp(body, "#version", 8) == 0)
+		{
+			const char* lineEnd = strchr(body, '\n');
+			body = (lineEnd != NULL) ? lineEnd + 1 : body + strlen(body);
+		}
+		else
+		{
+			body = source;
+		}
+		std::string result(source, body - source);
+		if (result.size() > 0 && result[result.size() - 1] != '\n')
+		{
+			result += '\n';
+		}
+		result += defines;
+		result += '\n';
+		result += body;
+		return result;
+	}
+
+	/**
+	 * Checks whether the current context can save and load program binaries.
+	 * @return Returns true if it can, false otherwise.
+	 */
+	static bool programBinariesSupported()
+	{
+		if (pv_glGetProgramBinary == NULL || pv_glProgramBinary == NULL || pv_glProgramParameteri == NULL)
+		{
+			return false;
+		}
+		int formats = 0;
+		glGetIntegerv(PV_GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		return formats > 0;
+	}
+
+	/**
+	 * Loads a cached program binary into a program.
+	 * @param program The program to load the binary into.
+	 * @param path The cached program's file.
+	 * @param key The hash the file is named after.
+	 * @return Returns true if the program was loaded and linked, false if there was no usable binary.
+	 */
+	static bool loadProgramBinary(unsigned int program, const char* path, unsigned long long key)
+	{
+		File file(path, true);
+		if (!file.DataLoaded() || file.Size() < sizeof(ProgramCacheHeader))
+		{
+			return false;
+		}
+		ProgramCacheHeader header;
+		memcpy(&header, file.Data(), sizeof(header));
+		if (header.magic != PV_PROGRAM_CACHE_MAGIC || header.key != key || header.length != file.Size() - sizeof(header))
+		{
+			return false;
+		}
+		pv_glProgramBinary(program, header.format, file.Data() + sizeof(header), header.length);
+		int linked = GL_FALSE;
+		pv_glGetProgramiv(program, PV_GL_LINK_STATUS, &linked);
+		if (linked == GL_FALSE)
+		{
+			printf("The driver rejected the cached program %s, compiling it again.\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Saves a linked program's binary to the cache.
+	 * @param program The program to save.
+	 * @param path The file to save it to.
+	 * @param key The hash the file is named after.
+	 */
+	static void saveProgramBinary(unsigned int program, const char* path, unsigned long long key)
+	{
+		int length = 0;
+		pv_glGetProgramiv(program, PV_GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+		{
+			return;
+		}
+		ProgramCacheHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = PV_PROGRAM_CACHE_MAGIC;
+		header.key = key;
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		pv_glGetProgramBinary(program, length, &length, &format, &binary[0]);
+		header.format = format;
+		header.length = length;
+
+		FILE* file = fopen(path, "wb");
+		if (file == NULL)
+		{
+			printf("Could not write the cached program %s!\n", path);
+			return;
+		}
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(&binary[0], 1, length, file);
+		fclose(file);
+	}
+
+	/**
+	 * Works out where a program would be cached.
+	 * @param vertexSource The vertex shader's source code.
+	 * @param fragmentSource The fragment shader's source code.
+	 * @param defines The definitions added to both, or NULL.
+	 * @param key Set to the hash the cached program is named after.
+	 * @param path Set to the cached program's file.
+	 * @return Returns true if programs are being cached, false otherwise.
+	 */
+	static bool programCachePath(const char* vertexSource, const char* fragmentSource, const char* defines, unsigned long long& key, std::string& path)
+	{
+		if (shaderCacheDirectory.empty() || !programBinariesSupported())
+		{
+			return false;
+		}
+		// The key covers everything that changes the binary, the driver included, since binaries are only good on
+		// the driver that made them.
+		key = 14695981039346656037ULL;
+		key = hashString(key, vertexSource);
+		key = hashString(key, fragmentSource);
+		key = hashString(key, defines);
+		key = hashString(key, (const char*)glGetString(GL_VENDOR));
+		key = hashString(key, (const char*)glGetString(GL_RENDERER));
+		key = hashString(key, (const char*)glGetString(GL_VERSION));
+		char fileName[32];
+		sprintf(fileName, "/%016llx.pvpb", key);
+		path = shaderCacheDirectory + fileName;
+		return true;
+	}
+
+	void printShaderLog(unsigned int shader, const char* kind)
+	{
+		int compiled = GL_FALSE;
+		pv_glGetShaderiv(shader, PV_GL_COMPILE_STATUS, &compiled);
+		if (compiled == GL_FALSE)
+		{
+			int logLength = 0;
+			pv_glGetShaderiv(shader, PV_GL_INFO_LOG_LENGTH, &logLength);
+			std::vector<char> message(logLength + 1, '\0');
+			pv_glGetShaderInfoLog(shader, logLength, NULL, &message[0]);
+			fprintf(stdout, "%s\n%s shader failed to load!\n", &message[0], kind);
+		}
+	}
+
 	unsigned int createShaders(const char* vertexShader, const char* fragmentShader)
+	{
+		return createShaders(vertexShader, fragmentShader, NULL);
+	}
+
+	unsigned int createShaders(const char* vertexShader, const char* fragmentShader, const char* defines)
+	{
+		char* vertexSource = loadShaderSource(vertexShader);
+		if (vertexSource == NULL)
+		{
+			fprintf(stdout, "Could not find vertex shader file %s!\n", vertexShader);
+		}
+		char* fragmentSource = loadShaderSource(fragmentShader);
+		if (fragmentSource == NULL)
+		{
+			fprintf(stdout, "Could not find fragment shader file %s!\n", fragmentShader);
+		}
+		unsigned int program = createShadersFromSource((vertexSource != NULL) ? vertexSource : "", (fragmentSource != NULL) ? fragmentSource : "", defines);
+		free(vertexSource);
+		free(fragmentSource);
+		return program;
+	}
+
+	unsigned int createShadersFromSource(const char* vertexSource, const char* fragmentSource, const char* defines)
 	{
 		unsigned int program = pv_glCreateProgram();
+
+		std::string cachePath;
+		unsigned long long key = 0;
+		bool cached = programCachePath(vertexSource, fragmentSource, defines, key, cachePath);
+		if (cached)
+		{
+			if (loadProgramBinary(program, cachePath.c_str(), key))
+			{
+				return program;
+			}
+			pv_glProgramParameteri(program, PV_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
 		unsigned int vertex = pv_glCreateShader(PV_GL_VERTEX_SHADER);
 		unsigned int fragment = pv_glCreateShader(PV_GL_FRAGMENT_SHADER);
-		File* vertFile = new File(vertexShader, true);
-		if (vertFile->DataLoaded())
+		if (defines != NULL && defines[0] != '\0')
 		{
-			int length = vertFile->Size();
-			char* data = (char*)malloc((length + 1) * sizeof(char));
-			strncpy(data, vertFile->Data(), length);
-			data[length] = '\0';
-			compileShaders(vertex, data);
-			free(data);
+			compileShaders(vertex, addShaderDefines(vertexSource, defines).c_str());
+			compileShaders(fragment, addShaderDefines(fragmentSource, defines).c_str());
 		}
 		else
 		{
-			fprintf(stdout, "Could not find vertex shader file %s!\n", vertexShader);
+			compileShaders(vertex, vertexSource);
+			compileShaders(fragment, fragmentSource);
 		}
-		File* fragFile = new File(fragmentShader, true);
-		if (fragFile->DataLoaded())
+		linkShaders(program, vertex, fragment);
+
+		// The program keeps what it needs once linked, so the shaders can go.
+		pv_glDetachShader(program, vertex);
+		pv_glDetachShader(program, fragment);
+		pv_glDeleteShader(vertex);
+		pv_glDeleteShader(fragment);
+
+		int linked = GL_FALSE;
+		pv_glGetProgramiv(program, PV_GL_LINK_STATUS, &linked);
+		if (cached && linked != GL_FALSE)
 		{
-			int length = fragFile->Size();
-			char* data = (char*)malloc((length + 1) * sizeof(char));
-			strncpy(data, fragFile->Data(), length);
-			data[length] = '\0';
-			compileShaders(fragment, data);
-			free(data);
+			saveProgramBinary(program, cachePath.c_str(), key);
 		}
-		else
+		return program;
+	}
+
+	void setShaderCacheDirectory(const char* directory)
+	{
+		shaderCacheDirectory = (directory != NULL) ? directory : "";
+	}
+
+	bool hasGLExtension(const char* name)
+	{
+		int count = 0;
+		if (pv_glGetStringi != NULL)
+		{
+			glGetIntegerv(PV_GL_NUM_EXTENSIONS, &count);
+		}
+		// Contexts older than OpenGL 3.0 only list their extensions in one long string.
+		if (count <= 0)
+		{
+			const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+			size_t length = strlen(name);
+			for (const char* found = (extensions != NULL) ? strstr(extensions, name) : NULL; found != NULL; found = strstr(found + length, name))
+			{
+				if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		for (int i = 0; i < count; i += 1)
+		{
+			const char* extension = (const char*)pv_glGetStringi(GL_EXTENSIONS, i);
+			if (extension != NULL && strcmp(extension, name) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	ShaderBatch::ShaderBatch()
+	{
+		this->parallel = false;
+		this->pending = 0;
+	}
+
+	unsigned int ShaderBatch::Add(const char* vertexSource, const char* fragmentSource, const char* defines)
+	{
+		Entry entry;
+		entry.vertexSource = (defines != NULL && defines[0] != '\0') ? addShaderDefines(vertexSource, defines) : vertexSource;
+		entry.fragmentSource = (defines != NULL && defines[0] != '\0') ? addShaderDefines(fragmentSource, defines) : fragmentSource;
+		entry.program = 0;
+		entry.vertex = 0;
+		entry.fragment = 0;
+		entry.state = ProgramQueued;
+		entry.key = 0;
+		entry.cached = programCachePath(vertexSource, fragmentSource, defines, entry.key, entry.cachePath);
+		this->entries.push_back(entry);
+		return (unsigned int)this->entries.size() - 1;
+	}
+
+	unsigned int ShaderBatch::AddFiles(const char* vertexShader, const char* fragmentShader, const char* defines)
+	{
+		char* vertexSource = loadShaderSource(vertexShader);
+		if (vertexSource == NULL)
+		{
+			fprintf(stdout, "Could not find vertex shader file %s!\n", vertexShader);
+		}
+		char* fragmentSource = loadShaderSource(fragmentShader);
+		if (fragmentSource == NULL)
 		{
 			fprintf(stdout, "Could not find fragment shader file %s!\n", fragmentShader);
 		}
-		linkShaders(program, vertex, fragment);
-		return program;
+		unsigned int index = this->Add((vertexSource != NULL) ? vertexSource : "", (fragmentSource != NULL) ? fragmentSource : "", defines);
+		free(vertexSource);
+		free(fragmentSource);
+		return index;
 	}
 
-	void createPerspectiveMatrix(float* array, float fieldOfView, float aspectRatio, float nearValue, float farValue)
+	void ShaderBatch::Submit()
 	{
-		float width = (nearValue * tanf(fieldOfView * (float)M_PI / 360.0f)) - -(nearValue * tanf(fieldOfView * (float)M_PI / 360.0f));
-		float height = (nearValue * tanf(fieldOfView * (float)M_PI / 360.0f)) - -(nearValue * tanf(fieldOfView * (float)M_PI / 360.0f));
-		float depth = farValue - nearValue;
+		this->parallel = hasGLExtension("GL_KHR_parallel_shader_compile") || hasGLExtension("GL_ARB_parallel_shader_compile");
+		if (this->parallel && pv_glMaxShaderCompilerThreadsKHR != NULL && hasGLExtension("GL_KHR_parallel_shader_compile"))
+		{
+			// Let the driver use as many compiler threads as it likes.
+			pv_glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		}
 
-		for (int i = 0; i < 16; i += 1)
+		// Everything is compiled before anything is linked, and nothing is asked about until Poll, since any query
+		// about a shader or program waits for the driver to finish it.
+		for (size_t i = 0; i < this->entries.size(); i += 1)
 		{
-			switch (i)
+			Entry& entry = this->entries[i];
+			if (entry.state != ProgramQueued)
+			{
+				continue;
+			}
+			entry.program = pv_glCreateProgram();
+			if (entry.cached && loadProgramBinary(entry.program, entry.cachePath.c_str(), entry.key))
+			{
+				entry.state = ProgramReady;
+				continue;
+			}
+			const char* vertexSource = entry.vertexSource.c_str();
+			const char* fragmentSource = entry.fragmentSource.c_str();
+			entry.vertex = pv_glCreateShader(PV_GL_VERTEX_SHADER);
+			entry.fragment = pv_glCreateShader(PV_GL_FRAGMENT_SHADER);
+			pv_glShaderSource(entry.vertex, 1, &vertexSource, NULL);
+			pv_glShaderSource(entry.fragment, 1, &fragmentSource, NULL);
+			pv_glCompileShader(entry.vertex);
+			pv_glCompileShader(entry.fragment);
+			entry.state = ProgramCompiling;
+			this->pending += 1;
+		}
+		for (size_t i = 0; i < this->entries.size(); i += 1)
+		{
+			Entry& entry = this->entries[i];
+			if (entry.state != ProgramCompiling)
+			{
+				continue;
+			}
+			pv_glAttachShader(entry.program, entry.vertex);
+			pv_glAttachShader(entry.program, entry.fragment);
+			if (entry.cached)
+			{
+				pv_glProgramParameteri(entry.program, PV_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
+			pv_glLinkProgram(entry.program);
+		}
+	}
+
+	unsigned int ShaderBatch::Poll()
+	{
+		unsigned int finished = 0;
+		for (size_t i = 0; i < this->entries.size() && this->pending > 0; i += 1)
+		{
+			Entry& entry = this->entries[i];
+			if (entry.state != ProgramCompiling)
+			{
+				continue;
+			}
+			if (this->parallel)
+			{
+				int complete = GL_FALSE;
+				pv_glGetProgramiv(entry.program, PV_GL_COMPLETION_STATUS_KHR, &complete);
+				if (complete == GL_FALSE)
+				{
+					continue;
+				}
+			}
+			this->finish(entry);
+			finished += 1;
+			// Without the extension, finishing a program may wait for it, so only one is finished per poll.
+			if (!this->parallel)
 			{
-			case 0:
-				array[i] = (2 * nearValue / width) / aspectRatio;
-				break;
-			case 5:
-				array[i] = 2 * nearValue / height;
-				break;
-			case 10:
-				array[i] = -(farValue + nearValue) / depth;
-				break;
-			case 11:
-				array[i] = -1;
-				break;
-			case 14:
-				array[i] = -2 * (farValue * nearValue) / depth;
-				break;
-			default:
-				array[i] = 0;
 				break;
 			}
 		}
+		return finished;
 	}
-	void createPerspectiveMatrix(PV::Math::Matrix<float> &matrix, float fieldOfView, float aspectRatio, float nearValue, float farValue)
+
+	void ShaderBatch::Wait()
 	{
-		float width = (nearValue * tanf(fieldOfView * (float)M_PI / 360.0f)) - -(nearValue * tanf(fieldOfView * (float)M_PI / 360.0f));
-		float height = (nearValue * tanf(fieldOfView * (float)M_PI / 360.0f)) - -(nearValue * tanf(fieldOfView * (float)M_PI / 360.0f));
-		float depth = farValue - nearValue;
+		for (size_t i = 0; i < this->entries.size(); i += 1)
+		{
+			if (this->entries[i].state == ProgramCompiling)
+			{
+				this->finish(this->entries[i]);
+			}
+		}
+	}
+
+	const bool ShaderBatch::IsComplete() const
+	{
+		return this->pending == 0;
+	}
+
+	const bool ShaderBatch::IsParallel() const
+	{
+		return this->parallel;
+	}
+
+	const unsigned int ShaderBatch::GetCount() const
+	{
+		return (unsigned int)this->entries.size();
+	}
 
-		matrix = PV::Math::Matrix <float>(4, 4);
-		matrix = new float[16];
-		for (int i = 0; i < 16; i += 1)
+	const ShaderProgramState ShaderBatch::GetState(unsigned int index) const
+	{
+		return this->entries[index].state;
+	}
+
+	const unsigned int ShaderBatch::GetProgram(unsigned int index) const
+	{
+		return (this->entries[index].state == ProgramReady) ? this->entries[index].program : 0;
+	}
+
+	void ShaderBatch::finish(Entry& entry)
+	{
+		int linked = GL_FALSE;
+		pv_glGetProgramiv(entry.program, PV_GL_LINK_STATUS, &linked);
+		if (linked == GL_FALSE)
+		{
+			printShaderLog(entry.vertex, "Vertex");
+			printShaderLog(entry.fragment, "Fragment");
+			int logLength = 0;
+			pv_glGetProgramiv(entry.program, PV_GL_INFO_LOG_LENGTH, &logLength);
+			std::vector<char> message(logLength + 1, '\0');
+			pv_glGetProgramInfoLog(entry.program, logLength, NULL, &message[0]);
+			fprintf(stdout, "%s\nProgram link failed!\n", &message[0]);
+		}
+
+		// The program keeps what it needs once linked, so the shaders can go.
+		pv_glDetachShader(entry.program, entry.vertex);
+		pv_glDetachShader(entry.program, entry.fragment);
+		pv_glDeleteShader(entry.vertex);
+		pv_glDeleteShader(entry.fragment);
+		entry.vertex = 0;
+		entry.fragment = 0;
+
+		if (linked == GL_FALSE)
+		{
+			pv_glDeleteProgram(entry.program);
+			entry.program = 0;
+			entry.state = ProgramFailed;
+		}
+		else
 		{
-			switch (i)
+			if (entry.cached)
 			{
-			case 0:
-				matrix[i] = (2 * nearValue / width) / aspectRatio;
-				break;
-			case 5:
-				matrix[i] = 2 * nearValue / height;
-				break;
-			case 10:
-				matrix[i] = -(farValue + nearValue) / depth;
-				break;
-			case 11:
-				matrix[i] = -1;
-				break;
-			case 14:
-				matrix[i] = -2 * (farValue * nearValue) / depth;
-				break;
-			default:
-				matrix[i] = 0;
-				break;
+				saveProgramBinary(entry.program, entry.cachePath.c_str(), entry.key);
 			}
+			entry.state = ProgramReady;
 		}
+		this->pending -= 1;
 	}
-	void createLookAtMatrix(PV::Math::Matrix<float> &matrix, Math::vec3 eye, Math::vec3 target, Math::vec3 up)
+
+	void createPerspectiveMatrix(float* array, float fieldOfView, float aspectRatio, float nearValue, float farValue)
+	{
+		// The width and height at the near plane cancel out, leaving only the tangent of half the field of view.
+		float scale = 1.0f / tanf(fieldOfView * (float)M_PI / 360.0f);
+		float depth = farValue - nearValue;
+
+		array[0] = scale / aspectRatio;
+		array[1] = 0.0f;
+		array[2] = 0.0f;
+		array[3] = 0.0f;
+		array[4] = 0.0f;
+		array[5] = scale;
+		array[6] = 0.0f;
+		array[7] = 0.0f;
+		array[8] = 0.0f;
+		array[9] = 0.0f;
+		array[10] = -(farValue + nearValue) / depth;
+		array[11] = -1.0f;
+		array[12] = 0.0f;
+		array[13] = 0.0f;
+		array[14] = -2.0f * (farValue * nearValue) / depth;
+		array[15] = 0.0f;
+	}
+	void createPerspectiveMatrix(float* array, float upTan, float downTan, float leftTan, float rightTan, float nearValue, float farValue)
+	{
+		float width = leftTan + rightTan;
+		float height = upTan + downTan;
+		float depth = farValue - nearValue;
+
+		array[0] = 2.0f / width;
+		array[1] = 0.0f;
+		array[2] = 0.0f;
+		array[3] = 0.0f;
+		array[4] = 0.0f;
+		array[5] = 2.0f / height;
+		array[6] = 0.0f;
+		array[7] = 0.0f;
+		// Shifts the center of the view towards the wider side when the eye does not look through its middle.
+		array[8] = (rightTan - leftTan) / width;
+		array[9] = (upTan - downTan) / height;
+		array[10] = -(farValue + nearValue) / depth;
+		array[11] = -1.0f;
+		array[12] = 0.0f;
+		array[13] = 0.0f;
+		array[14] = -2.0f * (farValue * nearValue) / depth;
+		array[15] = 0.0f;
+	}
+	void createReverseDepthPerspectiveMatrix(float* array, float fieldOfView, float aspectRatio, float nearValue)
+	{
+		float scale = 1.0f / tanf(fieldOfView * (float)M_PI / 360.0f);
+		createReverseDepthPerspectiveMatrix(array, 1.0f / scale, 1.0f / scale, aspectRatio / scale, aspectRatio / scale, nearValue);
+	}
+	void createReverseDepthPerspectiveMatrix(float* array, float upTan, float downTan, float leftTan, float rightTan, float nearValue)
+	{
+		// The standard perspective with the far plane taken to infinity and the depth flipped, which leaves the depth
+		// as the near plane's distance over the point's.
+		createPerspectiveMatrix(array, upTan, downTan, leftTan, rightTan, nearValue, nearValue + 1.0f);
+		array[10] = 0.0f;
+		array[14] = nearValue;
+	}
+	void createPerspectiveMatrix(PV::Math::Matrix<float> &matrix, float fieldOfView, float aspectRatio, float nearValue, float farValue)
+	{
+		createPerspectiveMatrix(matrix.getArray(), fieldOfView, aspectRatio, nearValue, farValue);
+	}
+	void createLookAtMatrix(float* array, Math::vec3 eye, Math::vec3 target, Math::vec3 up)
 	{
 		Math::vec3 zAxis = { eye.x - target.x, eye.y - target.y, eye.z - target.z };
 		zAxis = Math::normalize(zAxis);
 		Math::vec3 xAxis = Math::normalize(Math::crossMultiply(up, zAxis));
 		Math::vec3 yAxis = Math::crossMultiply(zAxis, xAxis);
 
-		Math::Matrix<float> orientationMatrix(4, 4);
-		Math::Matrix<float> translationMatrix(4, 4);
-
-		orientationMatrix[0] = xAxis.x;
-		orientationMatrix[1] = yAxis.x;
-		orientationMatrix[2] = zAxis.x;
-		orientationMatrix[4] = xAxis.y;
-		orientationMatrix[5] = yAxis.y;
-		orientationMatrix[6] = zAxis.y;
-		orientationMatrix[8] = xAxis.z;
-		orientationMatrix[9] = yAxis.z;
-		orientationMatrix[10] = zAxis.z;
-
-		translationMatrix[12] = -eye.x;
-		translationMatrix[13] = -eye.y;
-		translationMatrix[14] = -eye.z;
+		// The orientation multiplied by the translation to the eye, so the translation is the eye in the camera's axes.
+		array[0] = xAxis.x;
+		array[1] = yAxis.x;
+		array[2] = zAxis.x;
+		array[3] = 0.0f;
+		array[4] = xAxis.y;
+		array[5] = yAxis.y;
+		array[6] = zAxis.y;
+		array[7] = 0.0f;
+		array[8] = xAxis.z;
+		array[9] = yAxis.z;
+		array[10] = zAxis.z;
+		array[11] = 0.0f;
+		array[12] = -(xAxis.x * eye.x + xAxis.y * eye.y + xAxis.z * eye.z);
+		array[13] = -(yAxis.x * eye.x + yAxis.y * eye.y + yAxis.z * eye.z);
+		array[14] = -(zAxis.x * eye.x + zAxis.y * eye.y + zAxis.z * eye.z);
+		array[15] = 1.0f;
+	}
+	void createLookAtMatrix(PV::Math::Matrix<float> &matrix, Math::vec3 eye, Math::vec3 target, Math::vec3 up)
+	{
+		createLookAtMatrix(matrix.getArray(), eye, target, up);
+	}
+	void createLookAtMatrix(float* array, Math::vec3 position, Math::vec3 rotation)
+	{
+		// Matrix::Rotate turns by the negated angles, rolling, then pitching, then yawing.
+		float cosPitch = cosf(-rotation.x), sinPitch = sinf(-rotation.x);
+		float cosYaw = cosf(-rotation.y), sinYaw = sinf(-rotation.y);
+		float cosRoll = cosf(-rotation.z), sinRoll = sinf(-rotation.z);
 
-		matrix = orientationMatrix * translationMatrix;
+		array[0] = cosRoll * cosYaw - sinRoll * sinPitch * sinYaw;
+		array[1] = sinRoll * cosYaw + cosRoll * sinPitch * sinYaw;
+		array[2] = -cosPitch * sinYaw;
+		array[3] = 0.0f;
+		array[4] = -sinRoll * cosPitch;
+		array[5] = cosRoll * cosPitch;
+		array[6] = sinPitch;
+		array[7] = 0.0f;
+		array[8] = cosRoll * sinYaw + sinRoll * sinPitch * cosYaw;
+		array[9] = sinRoll * sinYaw - cosRoll * sinPitch * cosYaw;
+		array[10] = cosPitch * cosYaw;
+		array[11] = 0.0f;
+		// Translating before rotating moves the camera by the position in its rotated axes.
+		array[12] = array[0] * position.x + array[4] * position.y + array[8] * position.z;
+		array[13] = array[1] * position.x + array[5] * position.y + array[9] * position.z;
+		array[14] = array[2] * position.x + array[6] * position.y + array[10] * position.z;
+		array[15] = 1.0f;
 	}
 	void createLookAtMatrix(PV::Math::Matrix<float> &matrix, Math::vec3 position, Math::vec3 rotation)
 	{
-		Math::Matrix<float> positionMatrix(4, 4);
-		Math::Matrix<float> rotationMatrix(4, 4);
+		createLookAtMatrix(matrix.getArray(), position, rotation);
+	}
+	/**
+	 * Fills in the view and view-projection of an eye whose projection has already been created.
+	 * @param eye The matrices to fill in, with the projection already in place.
+	 * @param headView The head's 4x4 column major view matrix.
+	 * @param viewAdjust The translation from the head's view to the eye's view.
+	 */
+	static void fillEyeMatrices(EyeMatrices& eye, const float* headView, Math::vec3 viewAdjust)
+	{
+		const float* projection = eye.projection;
 
-		positionMatrix.Translate(position.x, position.y, position.z);
-		rotationMatrix.Rotate(rotation.x, rotation.y, rotation.z);
+		// Each column is handled the same way, so the compiler can keep a whole column in one SIMD register.
+		for (int column = 0; column < 16; column += 4)
+		{
+			// Translating after the head's view adds the offset scaled by the bottom row.
+			float w = headView[column + 3];
+			float x = headView[column] + viewAdjust.x * w;
+			float y = headView[column + 1] + viewAdjust.y * w;
+			float z = headView[column + 2] + viewAdjust.z * w;
+			eye.view[column] = x;
+			eye.view[column + 1] = y;
+			eye.view[column + 2] = z;
+			eye.view[column + 3] = w;
 
-		matrix = rotationMatrix * positionMatrix;
+			// Only 7 elements of a perspective matrix are not zero, so the rest of the multiplication is skipped.
+			eye.viewProjection[column] = projection[0] * x + projection[8] * z;
+			eye.viewProjection[column + 1] = projection[5] * y + projection[9] * z;
+			eye.viewProjection[column + 2] = projection[10] * z + projection[14] * w;
+			eye.viewProjection[column + 3] = -z;
+		}
+	}
+	void createEyeMatrices(EyeMatrices& eye, const float* headView, Math::vec3 viewAdjust, float upTan, float downTan, float leftTan, float rightTan, float nearValue, float farValue)
+	{
+		createPerspectiveMatrix(eye.projection, upTan, downTan, leftTan, rightTan, nearValue, farValue);
+		fillEyeMatrices(eye, headView, viewAdjust);
+	}
+	void createReverseDepthEyeMatrices(EyeMatrices& eye, const float* headView, Math::vec3 viewAdjust, float upTan, float downTan, float leftTan, float rightTan, float nearValue)
+	{
+		createReverseDepthPerspectiveMatrix(eye.projection, upTan, downTan, leftTan, rightTan, nearValue);
+		fillEyeMatrices(eye, headView, viewAdjust);
 	}
-};
+};
\ No newline at end of file
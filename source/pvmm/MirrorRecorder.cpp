@@ -0,0 +1,159 @@
+#include "pvmm/MirrorRecorder.h"
+#include "pv/MinOpenGL.h"
+#include <string.h>
+#include <chrono>
+
+namespace PV
+{
+	MirrorRecorder::MirrorRecorder() : framesQueued(0), framesWritten(0), recording(false)
+	{
+		this->file = NULL;
+		this->width = 0;
+		this->height = 0;
+		this->readbacksIssued = 0;
+		this->framesDropped = 0;
+		for (int i = 0; i < PV_RECORDER_READBACKS; i += 1)
+		{
+			this->readbacks[i] = 0;
+		}
+	}
+
+	bool MirrorRecorder::Start(const char* fileName, int width, int height)
+	{
+		if (this->recording || width <= 0 || height <= 0)
+		{
+			return false;
+		}
+
+		this->file = fopen(fileName, "wb");
+		if (this->file == NULL)
+		{
+			printf("Error opening recording file %s!\n", fileName);
+			return false;
+		}
+
+		this->width = width;
+		this->height = height;
+		unsigned int size = width * height * 4;
+		pv_glGenBuffers(PV_RECORDER_READBACKS, this->readbacks);
+		for (int i = 0; i < PV_RECORDER_READBACKS; i += 1)
+		{
+			pv_glBindBuffer(PV_GL_PIXEL_PACK_BUFFER, this->readbacks[i]);
+			pv_glBufferData(PV_GL_PIXEL_PACK_BUFFER, size, NULL, PV_GL_STREAM_READ);
+		}
+		pv_glBindBuffer(PV_GL_PIXEL_PACK_BUFFER, 0);
+		for (int i = 0; i < PV_RECORDER_FRAMES; i += 1)
+		{
+			this->frames[i].resize(size);
+		}
+
+		this->readbacksIssued = 0;
+		this->framesQueued = 0;
+		this->framesWritten = 0;
+		this->framesDropped = 0;
+		this->recording = true;
+		this->thread = std::thread(&MirrorRecorder::run, this);
+		return true;
+	}
+
+	void MirrorRecorder::Capture()
+	{
+		if (!this->recording)
+		{
+			return;
+		}
+
+		// Start reading this frame back, the copy happens on the GPU whenever it gets to it.
+		pv_glBindFramebuffer(PV_GL_READ_FRAMEBUFFER, 0);
+		glReadBuffer(GL_BACK);
+		pv_glBindBuffer(PV_GL_PIXEL_PACK_BUFFER, this->readbacks[this->readbacksIssued % PV_RECORDER_READBACKS]);
+		glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		this->readbacksIssued += 1;
+
+		// The oldest read back was started a couple of frames ago, so it is done and mapping it does not stall.
+		if (this->readbacksIssued >= PV_RECORDER_READBACKS)
+		{
+			unsigned int size = this->width * this->height * 4;
+			pv_glBindBuffer(PV_GL_PIXEL_PACK_BUFFER, this->readbacks[this->readbacksIssued % PV_RECORDER_READBACKS]);
+			void* pixels = pv_glMapBufferRange(PV_GL_PIXEL_PACK_BUFFER, 0, size, PV_GL_MAP_READ_BIT);
+			if (pixels != NULL)
+			{
+				unsigned int queued = this->framesQueued.load(std::memory_order_relaxed);
+				if (queued - this->framesWritten.load(std::memory_order_acquire) < PV_RECORDER_FRAMES)
+				{
+					memcpy(&this->frames[queued % PV_RECORDER_FRAMES][0], pixels, size);
+					this->framesQueued.store(queued + 1, std::memory_order_release);
+				}
+				else
+				{
+					this->framesDropped.fetch_add(1, std::memory_order_relaxed);
+				}
+				pv_glUnmapBuffer(PV_GL_PIXEL_PACK_BUFFER);
+			}
+		}
+		pv_glBindBuffer(PV_GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	void MirrorRecorder::Stop()
+	{
+		if (!this->recording)
+		{
+			return;
+		}
+
+		this->recording = false;
+		this->thread.join();
+		fclose(this->file);
+		this->file = NULL;
+		pv_glDeleteBuffers(PV_RECORDER_READBACKS, this->readbacks);
+		for (int i = 0; i < PV_RECORDER_READBACKS; i += 1)
+		{
+			this->readbacks[i] = 0;
+		}
+	}
+
+	const bool MirrorRecorder::IsRecording() const
+	{
+		return this->recording;
+	}
+
+	const unsigned int MirrorRecorder::GetFramesWritten() const
+	{
+		return this->framesWritten.load(std::memory_order_acquire);
+	}
+
+	const unsigned int MirrorRecorder::GetFramesDropped() const
+	{
+		return this->framesDropped.load(std::memory_order_relaxed);
+	}
+
+	void MirrorRecorder::run()
+	{
+		unsigned int size = this->width * this->height * 4;
+		unsigned int written = 0;
+
+		// Keep writing until told to stop and everything queued so far is on disk.
+		while (this->recording || written != this->framesQueued.load(std::memory_order_acquire))
+		{
+			if (written == this->framesQueued.load(std::memory_order_acquire))
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+			fwrite(&this->frames[written % PV_RECORDER_FRAMES][0], 1, size, this->file);
+			written += 1;
+			this->framesWritten.store(written, std::memory_order_release);
+		}
+	}
+
+	MirrorRecorder::~MirrorRecorder()
+	{
+		if (this->recording)
+		{
+			// Without the OpenGL context the pixel buffers cannot be deleted here, only the file is finished.
+			this->recording = false;
+			this->thread.join();
+			fclose(this->file);
+		}
+	}
+};
@@ -0,0 +1,239 @@
+#include "pvmm/RenderCommandList.h"
+#include "pv/MinOpenGL.h"
+#include <string.h>
+
+namespace PV
+{
+	static const float identityMatrix[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+
+	void multiplyMatrices(float* output, const float* a, const float* b)
+	{
+		for (int column = 0; column < 4; column += 1)
+		{
+			for (int row = 0; row < 4; row += 1)
+			{
+				output[row + column * 4] = a[row] * b[column * 4] +
+					a[row + 4] * b[1 + column * 4] +
+					a[row + 8] * b[2 + column * 4] +
+					a[row + 12] * b[3 + column * 4];
+			}
+		}
+	}
+
+	unsigned long long createSortKey(unsigned int pass, unsigned int program, unsigned int texture, unsigned int vertexArray, float depth)
+	{
+		// Clamp the depth and quantize it to the bits available for it.
+		if (depth < 0.0f)
+		{
+			depth = 0.0f;
+		}
+		else if (depth > 1.0f)
+		{
+			depth = 1.0f;
+		}
+		unsigned long long depthBits = (unsigned long long)(depth * (float)((1 << PV_SORT_DEPTH_BITS) - 1));
+
+		unsigned long long key = pass & ((1 << PV_SORT_PASS_BITS) - 1);
+		key = (key << PV_SORT_PROGRAM_BITS) | (program & ((1 << PV_SORT_PROGRAM_BITS) - 1));
+		key = (key << PV_SORT_TEXTURE_BITS) | (texture & ((1 << PV_SORT_TEXTURE_BITS) - 1));
+		key = (key << PV_SORT_VERTEX_ARRAY_BITS) | (vertexArray & ((1 << PV_SORT_VERTEX_ARRAY_BITS) - 1));
+		key = (key << PV_SORT_DEPTH_BITS) | depthBits;
+		return key;
+	}
+
+	RenderCommandList::RenderCommandList()
+	{
+		this->sorted = false;
+		memcpy(this->viewMatrix, identityMatrix, sizeof(this->viewMatrix));
+	}
+
+	void RenderCommandList::Clear()
+	{
+		// Clearing a vector keeps its capacity, so the next frame records without allocating.
+		this->commands.clear();
+		this->sorted = false;
+		memcpy(this->viewMatrix, identityMatrix, sizeof(this->viewMatrix));
+	}
+
+	void RenderCommandList::SetViewMatrix(const float* matrix)
+	{
+		memcpy(this->viewMatrix, matrix, sizeof(this->viewMatrix));
+	}
+
+	const float* RenderCommandList::ViewMatrix() const
+	{
+		return this->viewMatrix;
+	}
+
+	void RenderCommandList::Draw(unsigned int program, int mvpLocation, unsigned int vertexArray, unsigned int texture,
+		unsigned int primitive, unsigned int first, unsigned int count, const float* modelMatrix)
+	{
+		this->Draw(0, 0.0f, program, mvpLocation, vertexArray, texture, primitive, first, count, modelMatrix);
+	}
+
+	void RenderCommandList::Draw(unsigned int pass, float depth, unsigned int program, int mvpLocation, unsigned int vertexArray, unsigned int texture,
+		unsigned int primitive, unsigned int first, unsigned int count, const float* modelMatrix)
+	{
+		DrawCommand command;
+		command.program = program;
+		command.mvpLocation = mvpLocation;
+		command.vertexArray = vertexArray;
+		command.texture = texture;
+		command.primitive = primitive;
+		command.first = first;
+		command.count = count;
+		command.sortKey = createSortKey(pass, program, texture, vertexArray, depth);
+		memcpy(command.modelMatrix, modelMatrix, sizeof(command.modelMatrix));
+		this->commands.push_back(command);
+		this->sorted = false;
+	}
+
+	void RenderCommandList::Sort()
+	{
+		unsigned int count = (unsigned int)this->commands.size();
+		if (count == 0)
+		{
+			this->sorted = true;
+			return;
+		}
+
+		this->sortEntries.resize(count);
+		this->sortScratch.resize(count);
+
+		// Count how often each byte value shows up in each byte of the keys, all in a single pass.
+		unsigned int histograms[8][256];
+		memset(histograms, 0, sizeof(histograms));
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			unsigned long long key = this->commands[i].sortKey;
+			this->sortEntries[i].key = key;
+			this->sortEntries[i].index = i;
+			for (int byte = 0; byte < 8; byte += 1)
+			{
+				histograms[byte][(key >> (byte * 8)) & 0xFF] += 1;
+			}
+		}
+
+		// Least significant byte first, each pass is stable so the earlier passes' order is kept for equal bytes.
+		SortEntry* source = &this->sortEntries[0];
+		SortEntry* destination = &this->sortScratch[0];
+		for (int byte = 0; byte < 8; byte += 1)
+		{
+			// A byte which is the same in every key would not move anything, so skip it.  With few distinct
+			// programs, textures and passes this skips most of the passes.
+			unsigned int* histogram = histograms[byte];
+			if (histogram[(source[0].key >> (byte * 8)) & 0xFF] == count)
+			{
+				continue;
+			}
+
+			unsigned int offsets[256];
+			unsigned int total = 0;
+			for (int value = 0; value < 256; value += 1)
+			{
+				offsets[value] = total;
+				total += histogram[value];
+			}
+			for (unsigned int i = 0; i < count; i += 1)
+			{
+				destination[offsets[(source[i].key >> (byte * 8)) & 0xFF]++] = source[i];
+			}
+
+			SortEntry* swap = source;
+			source = destination;
+			destination = swap;
+		}
+
+		this->order.resize(count);
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			this->order[i] = source[i].index;
+		}
+		this->sorted = true;
+	}
+
+	const bool RenderCommandList::IsSorted() const
+	{
+		return this->sorted;
+	}
+
+	const unsigned int RenderCommandList::Size() const
+	{
+		return (const unsigned int)this->commands.size();
+	}
+
+	const DrawCommand& RenderCommandList::operator[](const unsigned int index) const
+	{
+		return this->commands[index];
+	}
+
+	void RenderCommandList::Execute(const float* projectionMatrix, const float* eyeMatrix) const
+	{
+		this->Execute(projectionMatrix, eyeMatrix, NULL);
+	}
+
+	void RenderCommandList::Execute(const float* projectionMatrix, const float* eyeMatrix, RenderStats* stats) const
+	{
+		// Build the view-projection once for the whole frame, then only the model matrix changes per draw.
+		float view[16];
+		float viewProjection[16];
+		float mvp[16];
+		if (eyeMatrix != NULL)
+		{
+			multiplyMatrices(view, eyeMatrix, this->viewMatrix);
+			multiplyMatrices(viewProjection, projectionMatrix, view);
+		}
+		else
+		{
+			multiplyMatrices(viewProjection, projectionMatrix, this->viewMatrix);
+		}
+
+		// Nothing is assumed to be bound, so the first command always binds all of its state.
+		unsigned int count = (unsigned int)this->commands.size();
+		const DrawCommand* previous = NULL;
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			const DrawCommand& command = this->commands[(this->sorted) ? this->order[i] : i];
+			if (previous == NULL || previous->program != command.program)
+			{
+				pv_glUseProgram(command.program);
+				if (stats != NULL)
+				{
+					stats->programChanges += 1;
+				}
+			}
+			if (previous == NULL || previous->texture != command.texture)
+			{
+				glBindTexture(GL_TEXTURE_2D, command.texture);
+				if (stats != NULL)
+				{
+					stats->textureChanges += 1;
+				}
+			}
+			if (previous == NULL || previous->vertexArray != command.vertexArray)
+			{
+				pv_glBindVertexArray(command.vertexArray);
+				if (stats != NULL)
+				{
+					stats->vertexArrayChanges += 1;
+				}
+			}
+
+			multiplyMatrices(mvp, viewProjection, command.modelMatrix);
+			pv_glUniformMatrix4fv(command.mvpLocation, 1, false, mvp);
+			glDrawArrays(command.primitive, command.first, command.count);
+			if (stats != NULL)
+			{
+				stats->draws += 1;
+			}
+			previous = &command;
+		}
+		pv_glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+};
@@ -0,0 +1,139 @@
+#include "pvmm/ResourceLoader.h"
+#include "pvmm/WindowSystem.h"
+#include <stdio.h>
+#include <chrono>
+
+namespace PV
+{
+	ResourceLoader::ResourceLoader() : queued(0), uploaded(0), handedOver(0), running(false)
+	{
+		this->window = NULL;
+	}
+
+	bool ResourceLoader::Start(Window* window)
+	{
+		if (this->running)
+		{
+			return true;
+		}
+		if (window == NULL || !window->loaderContext)
+		{
+			printf("The window has no loader context to upload resources with!\n");
+			return false;
+		}
+		this->window = window;
+		this->running = true;
+		this->thread = std::thread(&ResourceLoader::run, this);
+		return true;
+	}
+
+	bool ResourceLoader::Queue(uploadCallback* upload, uploadReadyCallback* ready, void* userData)
+	{
+		unsigned int index = this->queued.load(std::memory_order_relaxed);
+		if (index - this->handedOver.load(std::memory_order_acquire) >= PV_LOADER_UPLOADS)
+		{
+			return false;
+		}
+		Upload& slot = this->uploads[index % PV_LOADER_UPLOADS];
+		slot.upload = upload;
+		slot.ready = ready;
+		slot.userData = userData;
+		slot.fence = NULL;
+		this->queued.store(index + 1, std::memory_order_release);
+		return true;
+	}
+
+	unsigned int ResourceLoader::Poll()
+	{
+		unsigned int count = 0;
+		unsigned int index = this->handedOver.load(std::memory_order_relaxed);
+		unsigned int uploaded = this->uploaded.load(std::memory_order_acquire);
+		for (; index != uploaded; index += 1)
+		{
+			Upload& slot = this->uploads[index % PV_LOADER_UPLOADS];
+			if (slot.fence != NULL)
+			{
+				// A timeout of 0 only asks whether the fence has been passed, so the render thread never stalls here.
+				GLenum status = pv_glClientWaitSync(slot.fence, 0, 0);
+				if (status == PV_GL_TIMEOUT_EXPIRED)
+				{
+					break;
+				}
+				if (status == PV_GL_WAIT_FAILED)
+				{
+					printf("Waiting on an upload's fence failed!\n");
+				}
+				pv_glDeleteSync(slot.fence);
+				slot.fence = NULL;
+			}
+			if (slot.ready != NULL)
+			{
+				slot.ready(slot.userData);
+			}
+			count += 1;
+			this->handedOver.store(index + 1, std::memory_order_release);
+		}
+		return count;
+	}
+
+	void ResourceLoader::Stop()
+	{
+		this->running = false;
+		if (this->thread.joinable())
+		{
+			this->thread.join();
+		}
+	}
+
+	const bool ResourceLoader::IsRunning() const
+	{
+		return this->running;
+	}
+
+	const unsigned int ResourceLoader::GetPendingCount() const
+	{
+		return this->queued.load(std::memory_order_acquire) - this->handedOver.load(std::memory_order_acquire);
+	}
+
+	void ResourceLoader::run()
+	{
+		// The loader context belongs to this thread for as long as it runs.
+		if (this->window->MakeCurrentLoaderGLContext() != OK)
+		{
+			this->running = false;
+			return;
+		}
+
+		while (this->running)
+		{
+			unsigned int index = this->uploaded.load(std::memory_order_relaxed);
+			if (index == this->queued.load(std::memory_order_acquire))
+			{
+				// Nothing to upload, so sleep rather than spinning a core the simulation or renderer could use.
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			Upload& slot = this->uploads[index % PV_LOADER_UPLOADS];
+			slot.upload(slot.userData);
+			if (pv_glFenceSync != NULL)
+			{
+				slot.fence = pv_glFenceSync(PV_GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				// Flushing makes sure the fence reaches the GPU, or the render thread could wait on it forever.
+				glFlush();
+			}
+			else
+			{
+				glFinish();
+			}
+			this->uploaded.store(index + 1, std::memory_order_release);
+		}
+
+		this->window->ReleaseLoaderGLContext();
+	}
+
+	ResourceLoader::~ResourceLoader()
+	{
+		this->Stop();
+	}
+};
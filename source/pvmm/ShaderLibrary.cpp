@@ -0,0 +1,254 @@
+#include "pvmm/ShaderLibrary.h"
+#include "pv/FileIO.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace PV
+{
+	ShaderLibrary::ShaderLibrary()
+	{
+		this->vertexMask = 0;
+		this->fragmentMask = 0;
+		this->parallel = false;
+		this->parallelChecked = false;
+	}
+
+	void ShaderLibrary::SetSource(const char* vertexSource, const char* fragmentSource)
+	{
+		this->vertexSource = vertexSource;
+		this->fragmentSource = fragmentSource;
+	}
+
+	bool ShaderLibrary::SetSourceFiles(const char* vertexShader, const char* fragmentShader)
+	{
+		File vertexFile(vertexShader, true);
+		File fragmentFile(fragmentShader, true);
+		if (!vertexFile.DataLoaded())
+		{
+			fprintf(stdout, "Could not find vertex shader file %s!\n", vertexShader);
+			return false;
+		}
+		if (!fragmentFile.DataLoaded())
+		{
+			fprintf(stdout, "Could not find fragment shader file %s!\n", fragmentShader);
+			return false;
+		}
+		this->vertexSource.assign(vertexFile.Data(), vertexFile.Size());
+		this->fragmentSource.assign(fragmentFile.Data(), fragmentFile.Size());
+		return true;
+	}
+
+	unsigned long long ShaderLibrary::AddFeature(const char* name, unsigned int stages)
+	{
+		if (this->features.size() >= PV_SHADER_MAX_FEATURES)
+		{
+			printf("A shader library can only have %d features, %s was not added!\n", PV_SHADER_MAX_FEATURES, name);
+			return 0;
+		}
+		unsigned long long bit = 1ULL << this->features.size();
+		this->features.push_back(name);
+		if (stages & ShaderStageVertex)
+		{
+			this->vertexMask |= bit;
+		}
+		if (stages & ShaderStageFragment)
+		{
+			this->fragmentMask |= bit;
+		}
+		return bit;
+	}
+
+	const unsigned long long ShaderLibrary::GetFeature(const char* name) const
+	{
+		for (size_t i = 0; i < this->features.size(); i += 1)
+		{
+			if (this->features[i] == name)
+			{
+				return 1ULL << i;
+			}
+		}
+		return 0;
+	}
+
+	void ShaderLibrary::Request(const unsigned long long* keys, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; i += 1)
+		{
+			this->submit(keys[i]);
+		}
+	}
+
+	unsigned int ShaderLibrary::Poll()
+	{
+		unsigned int finished = 0;
+		for (size_t i = 0; i < this->pending.size();)
+		{
+			Variant& variant = this->variants[this->pending[i]];
+			if (this->parallel)
+			{
+				int complete = GL_FALSE;
+				pv_glGetProgramiv(variant.program, PV_GL_COMPLETION_STATUS_KHR, &complete);
+				if (complete == GL_FALSE)
+				{
+					i += 1;
+					continue;
+				}
+			}
+			this->finish(this->pending[i], variant);
+			finished += 1;
+			// Order does not matter, so the last key fills the gap.
+			this->pending[i] = this->pending.back();
+			this->pending.pop_back();
+			// Without the extension, finishing a variant may wait for it, so only one is finished per poll.
+			if (!this->parallel)
+			{
+				break;
+			}
+		}
+		return finished;
+	}
+
+	unsigned int ShaderLibrary::GetProgram(unsigned long long key)
+	{
+		std::unordered_map<unsigned long long, Variant>::iterator found = this->variants.find(key);
+		if (found != this->variants.end() && found->second.state == ProgramReady)
+		{
+			return found->second.program;
+		}
+		if (found == this->variants.end())
+		{
+			this->submit(key);
+			found = this->variants.find(key);
+		}
+		if (found->second.state == ProgramCompiling)
+		{
+			for (size_t i = 0; i < this->pending.size(); i += 1)
+			{
+				if (this->pending[i] == key)
+				{
+					this->pending[i] = this->pending.back();
+					this->pending.pop_back();
+					break;
+				}
+			}
+			this->finish(key, found->second);
+		}
+		return found->second.program;
+	}
+
+	const bool ShaderLibrary::IsReady(unsigned long long key) const
+	{
+		std::unordered_map<unsigned long long, Variant>::const_iterator found = this->variants.find(key);
+		return found != this->variants.end() && found->second.state == ProgramReady;
+	}
+
+	const unsigned int ShaderLibrary::GetProgramCount() const
+	{
+		return (unsigned int)this->variants.size();
+	}
+
+	const unsigned int ShaderLibrary::GetShaderCount() const
+	{
+		return (unsigned int)(this->vertexShaders.size() + this->fragmentShaders.size());
+	}
+
+	void ShaderLibrary::Clear()
+	{
+		for (std::unordered_map<unsigned long long, Variant>::iterator i = this->variants.begin(); i != this->variants.end(); ++i)
+		{
+			if (i->second.program != 0)
+			{
+				pv_glDeleteProgram(i->second.program);
+			}
+		}
+		for (std::unordered_map<unsigned long long, unsigned int>::iterator i = this->vertexShaders.begin(); i != this->vertexShaders.end(); ++i)
+		{
+			pv_glDeleteShader(i->second);
+		}
+		for (std::unordered_map<unsigned long long, unsigned int>::iterator i = this->fragmentShaders.begin(); i != this->fragmentShaders.end(); ++i)
+		{
+			pv_glDeleteShader(i->second);
+		}
+		this->variants.clear();
+		this->vertexShaders.clear();
+		this->fragmentShaders.clear();
+		this->pending.clear();
+	}
+
+	unsigned int ShaderLibrary::getShader(ShaderStage stage, unsigned long long key)
+	{
+		std::unordered_map<unsigned long long, unsigned int>& shaders = (stage == ShaderStageVertex) ? this->vertexShaders : this->fragmentShaders;
+		unsigned long long stageKey = key & ((stage == ShaderStageVertex) ? this->vertexMask : this->fragmentMask);
+		std::unordered_map<unsigned long long, unsigned int>::iterator found = shaders.find(stageKey);
+		if (found != shaders.end())
+		{
+			return found->second;
+		}
+
+		std::string defines;
+		for (size_t i = 0; i < this->features.size(); i += 1)
+		{
+			if (stageKey & (1ULL << i))
+			{
+				defines += "#define " + this->features[i] + " 1\n";
+			}
+		}
+		const std::string& templateSource = (stage == ShaderStageVertex) ? this->vertexSource : this->fragmentSource;
+		std::string source = defines.empty() ? templateSource : addShaderDefines(templateSource.c_str(), defines.c_str());
+		const char* text = source.c_str();
+
+		// Only compiled here, since asking whether it worked would wait for it.  Linking reports any errors.
+		unsigned int shader = pv_glCreateShader((stage == ShaderStageVertex) ? PV_GL_VERTEX_SHADER : PV_GL_FRAGMENT_SHADER);
+		pv_glShaderSource(shader, 1, &text, NULL);
+		pv_glCompileShader(shader);
+		shaders[stageKey] = shader;
+		return shader;
+	}
+
+	void ShaderLibrary::submit(unsigned long long key)
+	{
+		if (this->variants.find(key) != this->variants.end())
+		{
+			return;
+		}
+		if (!this->parallelChecked)
+		{
+			this->parallel = hasGLExtension("GL_KHR_parallel_shader_compile") || hasGLExtension("GL_ARB_parallel_shader_compile");
+			this->parallelChecked = true;
+		}
+
+		Variant variant;
+		variant.program = pv_glCreateProgram();
+		variant.state = ProgramCompiling;
+		pv_glAttachShader(variant.program, this->getShader(ShaderStageVertex, key));
+		pv_glAttachShader(variant.program, this->getShader(ShaderStageFragment, key));
+		pv_glLinkProgram(variant.program);
+		this->variants[key] = variant;
+		this->pending.push_back(key);
+	}
+
+	void ShaderLibrary::finish(unsigned long long key, Variant& variant)
+	{
+		int linked = GL_FALSE;
+		pv_glGetProgramiv(variant.program, PV_GL_LINK_STATUS, &linked);
+		if (linked != GL_FALSE)
+		{
+			variant.state = ProgramReady;
+			return;
+		}
+
+		printf("Shader variant %016llx failed:\n", key);
+		printShaderLog(this->vertexShaders[key & this->vertexMask], "Vertex");
+		printShaderLog(this->fragmentShaders[key & this->fragmentMask], "Fragment");
+		int logLength = 0;
+		pv_glGetProgramiv(variant.program, PV_GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> message(logLength + 1, '\0');
+		pv_glGetProgramInfoLog(variant.program, logLength, NULL, &message[0]);
+		fprintf(stdout, "%s\nProgram link failed!\n", &message[0]);
+
+		// The variant stays in the library as failed, so drawing with it does not try again every frame.
+		pv_glDeleteProgram(variant.program);
+		variant.program = 0;
+		variant.state = ProgramFailed;
+	}
+};
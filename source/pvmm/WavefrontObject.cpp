@@ -1,9 +1,44 @@
 #include "pvmm/WavefrontObject.h"
 #include "pvmm/MidOpenGL.h"
+#include <stdio.h>
 
 using namespace PV;
 
 WavefrontObject::WavefrontObject(const char* filename)
+{
+	this->totalShapes = 0;
+	this->load(filename);
+	this->loaded = true;
+}
+
+WavefrontObject::WavefrontObject(const char* filename, ResourceLoader* loader) : filename(filename)
+{
+	this->totalShapes = 0;
+	this->loaded = false;
+	// Reading the file and decoding its textures happen on the loader thread too, not just the uploads.
+	if (!loader->Queue(upload, ready, this))
+	{
+		printf("Too many uploads are waiting to load %s!\n", filename);
+	}
+}
+
+void WavefrontObject::upload(void* object)
+{
+	WavefrontObject* wavefrontObject = (WavefrontObject*)object;
+	wavefrontObject->load(wavefrontObject->filename.c_str());
+}
+
+void WavefrontObject::ready(void* object)
+{
+	((WavefrontObject*)object)->loaded = true;
+}
+
+const bool WavefrontObject::IsLoaded() const
+{
+	return this->loaded;
+}
+
+void WavefrontObject::load(const char* filename)
 {
 	std::vector<tinyobj::shape_t> shapes;
 	LoadObj(shapes, filename);
@@ -97,6 +132,10 @@ void WavefrontObject::loadTexture(tinyobj::shape_t* shape, int spot)
 
 void WavefrontObject::Draw()
 {
+	if (!this->loaded)
+	{
+		return;
+	}
 	for (int i = 0; i < this->totalShapes; i += 1)
 	{
 		glBindTexture(GL_TEXTURE_2D, this->textures[i]);
@@ -1,16 +1,172 @@
-#include "pvmm/windowSystem.h"
+#include "pvmm/WindowSystem.h"
 #include "pv/MinOpenGL.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef __linux__
+#include <EGL/eglext.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <stdlib.h>
+#endif
 
 namespace PV
 {
+	ContextSettings GetDefaultContextSettings()
+	{
+		ContextSettings settings;
+		settings.majorVersion = 0;
+		settings.minorVersion = 0;
+		settings.profile = ProfileCompatibility;
+#ifdef _DEBUG
+		settings.debug = true;
+		settings.noError = false;
+#else
+		settings.debug = false;
+		settings.noError = true;
+#endif
+		settings.depthBits = 24;
+		settings.stencilBits = 8;
+		return settings;
+	}
+
+	/**
+	 * Prints the errors and warnings a debug context's driver sends.
+	 */
+	static void __stdcall debugOutput(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+	{
+		if (severity == PV_GL_DEBUG_SEVERITY_HIGH || severity == PV_GL_DEBUG_SEVERITY_MEDIUM)
+		{
+			printf("OpenGL %s: %s\n", (severity == PV_GL_DEBUG_SEVERITY_HIGH) ? "error" : "warning", message);
+		}
+	}
+
+	/**
+	 * Sets up the newly current context once it exists: turns debug output on for a debug context, then reads
+	 * back what the driver actually gave.  initMinGL has not run yet, so the functions needed here are loaded
+	 * into its pointers first; it loads them again later.
+	 * @param settings The requested settings, which are updated to the actual ones.
+	 */
+	static void finishContext(ContextSettings& settings)
+	{
+		GLint flags = 0;
+		GLint profile = 0;
+		glGetIntegerv(PV_GL_MAJOR_VERSION, &settings.majorVersion);
+		glGetIntegerv(PV_GL_MINOR_VERSION, &settings.minorVersion);
+		glGetIntegerv(PV_GL_CONTEXT_FLAGS, &flags);
+		if (settings.majorVersion > 3 || (settings.majorVersion == 3 && settings.minorVersion >= 2))
+		{
+			glGetIntegerv(PV_GL_CONTEXT_PROFILE_MASK, &profile);
+		}
+		settings.profile = (profile & PV_GL_CONTEXT_CORE_PROFILE_BIT) ? ProfileCore : ProfileCompatibility;
+		settings.debug = (flags & PV_GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+		settings.noError = (flags & PV_GL_CONTEXT_FLAG_NO_ERROR_BIT) != 0;
+
+		pv_glGetFramebufferAttachmentParameteriv = (pv_glGetFramebufferAttachmentParameterivFunction)glGetProcAddress("glGetFramebufferAttachmentParameteriv");
+		pv_glDebugMessageCallback = (pv_glDebugMessageCallbackFunction)glGetProcAddress("glDebugMessageCallback");
+		pv_glDebugMessageControl = (pv_glDebugMessageControlFunction)glGetProcAddress("glDebugMessageControl");
+
+		if (pv_glGetFramebufferAttachmentParameteriv != NULL)
+		{
+			pv_glGetFramebufferAttachmentParameteriv(PV_GL_FRAMEBUFFER, GL_DEPTH, PV_GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &settings.depthBits);
+			pv_glGetFramebufferAttachmentParameteriv(PV_GL_FRAMEBUFFER, GL_STENCIL, PV_GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &settings.stencilBits);
+		}
+
+		if (settings.debug && pv_glDebugMessageCallback != NULL)
+		{
+			// Synchronous, so a message is printed from inside the call that caused it and shows up in its stack trace.
+			glEnable(PV_GL_DEBUG_OUTPUT);
+			glEnable(PV_GL_DEBUG_OUTPUT_SYNCHRONOUS);
+			// The driver need not even build the low severity and informative messages, which are never printed.
+			if (pv_glDebugMessageControl != NULL)
+			{
+				pv_glDebugMessageControl(PV_GL_DONT_CARE, PV_GL_DONT_CARE, PV_GL_DEBUG_SEVERITY_LOW, 0, NULL, GL_FALSE);
+				pv_glDebugMessageControl(PV_GL_DONT_CARE, PV_GL_DONT_CARE, PV_GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+			}
+			pv_glDebugMessageCallback(debugOutput, NULL);
+		}
+	}
+
 #ifdef _WIN32
+	/**
+	 * The WGL_ARB_create_context attributes used to create a context with specific settings.
+	 */
+#define PV_WGL_CONTEXT_MAJOR_VERSION_ARB 0x2091
+#define PV_WGL_CONTEXT_MINOR_VERSION_ARB 0x2092
+#define PV_WGL_CONTEXT_FLAGS_ARB 0x2094
+#define PV_WGL_CONTEXT_PROFILE_MASK_ARB 0x9126
+#define PV_WGL_CONTEXT_DEBUG_BIT_ARB 0x0001
+#define PV_WGL_CONTEXT_CORE_PROFILE_BIT_ARB 0x0001
+#define PV_WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB 0x0002
+#define PV_WGL_CONTEXT_OPENGL_NO_ERROR_ARB 0x31B3
+
+	typedef HGLRC(__stdcall* PFNPVWGLCREATECONTEXTATTRIBSARBPROC)(HDC deviceContext, HGLRC shareContext, const int* attributes);
+	typedef BOOL(__stdcall* PFNPVWGLSWAPINTERVALEXTPROC)(int interval);
+	typedef int(__stdcall* PFNPVWGLGETSWAPINTERVALEXTPROC)();
+
+	/**
+	 * Creates an OpenGL context with the requested version, profile and flags through wglCreateContextAttribsARB,
+	 * which needs some OpenGL context to be current on the calling thread.
+	 * @param deviceContext The device context the context draws to.
+	 * @param shareContext The context to share textures and buffers with, or NULL.
+	 * @param settings The settings to create the context with.
+	 * @return The context, or NULL if the driver has no wglCreateContextAttribsARB or refused the settings.
+	 */
+	static HGLRC createContext(HDC deviceContext, HGLRC shareContext, const ContextSettings& settings)
+	{
+		PFNPVWGLCREATECONTEXTATTRIBSARBPROC createContextAttribs = (PFNPVWGLCREATECONTEXTATTRIBSARBPROC)wglGetProcAddress("wglCreateContextAttribsARB");
+		if (createContextAttribs == NULL)
+		{
+			return NULL;
+		}
+		int attributes[16];
+		int count = 0;
+		int majorVersion = settings.majorVersion;
+		int minorVersion = settings.minorVersion;
+		if (settings.profile == ProfileCore && (majorVersion < 3 || (majorVersion == 3 && minorVersion < 2)))
+		{
+			majorVersion = 3;
+			minorVersion = 2;
+		}
+		else if (majorVersion == 0 && settings.noError && !settings.debug)
+		{
+			// An unspecified version counts as 1.0, which is too old for KHR_no_error.  Asking for 2.0 still gives the
+			// newest compatible version.
+			majorVersion = 2;
+		}
+		if (majorVersion > 0)
+		{
+			attributes[count++] = PV_WGL_CONTEXT_MAJOR_VERSION_ARB;
+			attributes[count++] = majorVersion;
+			attributes[count++] = PV_WGL_CONTEXT_MINOR_VERSION_ARB;
+			attributes[count++] = minorVersion;
+		}
+		attributes[count++] = PV_WGL_CONTEXT_PROFILE_MASK_ARB;
+		attributes[count++] = (settings.profile == ProfileCore) ? PV_WGL_CONTEXT_CORE_PROFILE_BIT_ARB : PV_WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB;
+		attributes[count++] = PV_WGL_CONTEXT_FLAGS_ARB;
+		attributes[count++] = settings.debug ? PV_WGL_CONTEXT_DEBUG_BIT_ARB : 0;
+		int noErrorAttribute = count;
+		if (settings.noError && !settings.debug)
+		{
+			attributes[count++] = PV_WGL_CONTEXT_OPENGL_NO_ERROR_ARB;
+			attributes[count++] = 1;
+		}
+		attributes[count] = 0;
+
+		HGLRC context = createContextAttribs(deviceContext, shareContext, attributes);
+		if (context == NULL && count > noErrorAttribute)
+		{
+			// Drivers without KHR_no_error reject the attribute, so try again with error checking.
+			attributes[noErrorAttribute] = 0;
+			context = createContextAttribs(deviceContext, shareContext, attributes);
+		}
+		return context;
+	}
+
 	LRESULT CALLBACK defaultWindowProcess(HWND winHandle, UINT message, WPARAM windowParam, LPARAM messageParam)
 	{
 		switch (message)
 		{
-		case WM_SIZE:
-			glViewport(0, 0, LOWORD(messageParam), HIWORD(messageParam));
-			return 0;
 		case WM_CLOSE:
 			PostQuitMessage(0);
 			return 0;
@@ -21,6 +177,42 @@ namespace PV
 	Window::Window()
 	{
 		this->windowsClass.hInstance = NULL;
+		this->loaderContext = NULL;
+		this->loaderWindowHandle = NULL;
+		this->loaderDeviceContext = NULL;
+		this->contextSettings = GetDefaultContextSettings();
+		this->swapInterval = 1;
+		this->swapIntervalFunction = NULL;
+		this->getSwapIntervalFunction = NULL;
+		this->callback = defaultWindowProcess;
+		this->resetInput();
+	}
+
+	LRESULT CALLBACK Window::windowProcess(HWND winHandle, UINT message, WPARAM windowParam, LPARAM messageParam)
+	{
+		// The window is handed over when the handle is created, and kept with the handle from then on.
+		if (message == WM_NCCREATE)
+		{
+			SetWindowLongPtr(winHandle, GWLP_USERDATA, (LONG_PTR)((CREATESTRUCT*)messageParam)->lpCreateParams);
+		}
+		Window* window = (Window*)GetWindowLongPtr(winHandle, GWLP_USERDATA);
+		if (window == NULL)
+		{
+			return DefWindowProc(winHandle, message, windowParam, messageParam);
+		}
+
+		// These are sent straight to the window process rather than posted, so PumpEvents never sees them itself.
+		switch (message)
+		{
+		case WM_SIZE:
+			window->pendingInput.windowWidth = LOWORD(messageParam);
+			window->pendingInput.windowHeight = HIWORD(messageParam);
+			break;
+		case WM_KILLFOCUS:
+			window->releaseInput();
+			break;
+		}
+		return window->callback(winHandle, message, windowParam, messageParam);
 	}
 	/**
 	 * Creates a window using the given information and then returns its status.
@@ -65,8 +257,13 @@ namespace PV
 		// made full screen.
 		this->isFullscreen = false;
 
+		this->pendingInput.windowWidth = width;
+		this->pendingInput.windowHeight = height;
+
 		// Get a handle to the instance of the application.
 		appInstance = GetModuleHandle(NULL);
+		// Every window goes through the same window process, which passes messages on to the callback.
+		windowsClass.lpfnWndProc = Window::windowProcess;
 		// Set the style to redraw vertically and horizantally, as well as to own it's own device context.
 		windowsClass.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
 		// Extra bytes to allocate for the window-class structure.
@@ -110,7 +307,7 @@ namespace PV
 		AdjustWindowRectEx(&windowRectangle, windowStyle, false, windowExtendedStyle);
 
 		// Finally, the window is actually created and assigned to its handle.
-		if (!(this->windowHandle = CreateWindowEx(windowExtendedStyle, this->title, this->title, WS_CLIPSIBLINGS | WS_CLIPCHILDREN | windowStyle, 0, 0, windowRectangle.right - windowRectangle.left, windowRectangle.bottom - windowRectangle.top, NULL, NULL, appInstance, NULL)))
+		if (!(this->windowHandle = CreateWindowEx(windowExtendedStyle, this->title, this->title, WS_CLIPSIBLINGS | WS_CLIPCHILDREN | windowStyle, 0, 0, windowRectangle.right - windowRectangle.left, windowRectangle.bottom - windowRectangle.top, NULL, NULL, appInstance, this)))
 		{
 			// If the window cannot be created and assigned, the window is destroyed.
 			this->destroy();
@@ -229,8 +426,7 @@ namespace PV
 	 */
 	void Window::setWindowProcessCallback(windowProcessCallback callback)
 	{
-		// Set the callback casted.
-		windowsClass.lpfnWndProc = (WNDPROC)callback;
+		this->callback = callback;
 	}
 
 	/**
@@ -266,8 +462,108 @@ namespace PV
 	 */
 	void Window::Update()
 	{
-		// Swap the buffers to update the display for the device context.
+		// Swap the buffers to update the display for the device context, once the frame limit allows.
+		this->applySwapInterval();
+		this->pacer.BeginSwap();
 		SwapBuffers(deviceContext);
+		this->pacer.EndSwap();
+	}
+
+	void Window::PumpEvents()
+	{
+		MSG message;
+		while (PeekMessage(&message, NULL, 0, 0, PM_REMOVE))
+		{
+			this->pendingInput.events += 1;
+			switch (message.message)
+			{
+			case WM_QUIT:
+				this->pendingInput.closeRequested = true;
+				break;
+			case WM_KEYDOWN:
+			case WM_SYSKEYDOWN:
+				this->setKey((unsigned int)message.wParam, true);
+				break;
+			case WM_KEYUP:
+			case WM_SYSKEYUP:
+				this->setKey((unsigned int)message.wParam, false);
+				break;
+			case WM_MOUSEMOVE:
+				this->moveMouse((short)LOWORD(message.lParam), (short)HIWORD(message.lParam));
+				break;
+			case WM_LBUTTONDOWN:
+				this->pendingInput.mouseButtons |= PV_MOUSE_LEFT;
+				break;
+			case WM_LBUTTONUP:
+				this->pendingInput.mouseButtons &= ~PV_MOUSE_LEFT;
+				break;
+			case WM_RBUTTONDOWN:
+				this->pendingInput.mouseButtons |= PV_MOUSE_RIGHT;
+				break;
+			case WM_RBUTTONUP:
+				this->pendingInput.mouseButtons &= ~PV_MOUSE_RIGHT;
+				break;
+			case WM_MBUTTONDOWN:
+				this->pendingInput.mouseButtons |= PV_MOUSE_MIDDLE;
+				break;
+			case WM_MBUTTONUP:
+				this->pendingInput.mouseButtons &= ~PV_MOUSE_MIDDLE;
+				break;
+			case WM_MOUSEWHEEL:
+				this->pendingInput.wheelDelta += GET_WHEEL_DELTA_WPARAM(message.wParam) / WHEEL_DELTA;
+				break;
+			}
+			if (message.message != WM_QUIT)
+			{
+				TranslateMessage(&message);
+				DispatchMessage(&message);
+			}
+		}
+		this->publishInput();
+	}
+
+	bool Window::SetSwapInterval(int interval)
+	{
+		PFNPVWGLSWAPINTERVALEXTPROC swapIntervalEXT = (PFNPVWGLSWAPINTERVALEXTPROC)this->swapIntervalFunction;
+		if (swapIntervalEXT == NULL)
+		{
+			return false;
+		}
+		// Negative intervals need WGL_EXT_swap_control_tear, and are refused without it.
+		if (!swapIntervalEXT(interval))
+		{
+			if (interval >= 0 || !swapIntervalEXT(1))
+			{
+				return false;
+			}
+			interval = 1;
+		}
+		this->swapInterval = interval;
+		return true;
+	}
+
+	const int Window::GetSwapInterval()
+	{
+		return this->swapInterval;
+	}
+
+	void Window::applySwapInterval()
+	{
+		PFNPVWGLGETSWAPINTERVALEXTPROC getSwapIntervalEXT = (PFNPVWGLGETSWAPINTERVALEXTPROC)this->getSwapIntervalFunction;
+		if (getSwapIntervalEXT != NULL && getSwapIntervalEXT() != this->swapInterval)
+		{
+			((PFNPVWGLSWAPINTERVALEXTPROC)this->swapIntervalFunction)(this->swapInterval);
+		}
+	}
+
+	void Window::SetFrameLimit(double framesPerSecond)
+	{
+		this->pacer.SetFrameLimit(framesPerSecond);
+	}
+
+	const FrameStats Window::GetFrameStats()
+	{
+		return this->pacer.GetStats();
 	}
 
 	/**
@@ -279,7 +575,7 @@ namespace PV
 		// Create a variable for storing the pixel format of the window.
 		int pixelFormat;
 		// Setup the pixel format descriptor.
-		static PIXELFORMATDESCRIPTOR pixelFormatDesc =
+		PIXELFORMATDESCRIPTOR pixelFormatDesc =
 		{
 			// Set the size of the descriptor.
 			sizeof(PIXELFORMATDESCRIPTOR),
@@ -295,8 +591,9 @@ namespace PV
 			0,
 			0,
 			0, 0, 0, 0,
-			16,
-			16,
+			// Set the depth and stencil buffers to the requested sizes.
+			(BYTE)this->contextSettings.depthBits,
+			(BYTE)this->contextSettings.stencilBits,
 			0,
 			PFD_MAIN_PLANE,
 			0,
@@ -389,9 +686,39 @@ namespace PV
 			 */
 			return WCGL_SET_CONTEXT_ERROR;
 		}
+
+		// The legacy context above is only good for finding wglCreateContextAttribsARB, which creates the real one.
+		HGLRC modernContext = createContext(deviceContext, NULL, this->contextSettings);
+		if (modernContext != NULL && wglMakeCurrent(deviceContext, modernContext))
+		{
+			wglDeleteContext(renderingContext);
+			renderingContext = modernContext;
+		}
+		else
+		{
+			printf("Could not create the requested OpenGL context, keeping a legacy one.\n");
+			if (modernContext != NULL)
+			{
+				wglDeleteContext(modernContext);
+			}
+			wglMakeCurrent(deviceContext, renderingContext);
+		}
+		finishContext(this->contextSettings);
+		this->swapIntervalFunction = wglGetProcAddress("wglSwapIntervalEXT");
+		this->getSwapIntervalFunction = wglGetProcAddress("wglGetSwapIntervalEXT");
 		return OK;
 	}
 
+	void Window::setContextSettings(const ContextSettings& settings)
+	{
+		this->contextSettings = settings;
+	}
+
+	const ContextSettings Window::GetContextSettings()
+	{
+		return this->contextSettings;
+	}
+
 	/**
 	 * Makes this window the current OpenGL context for rendering.
 	 * @return Return OK if there is no error, otherwise return the error.
@@ -422,6 +749,131 @@ namespace PV
 		return OK;
 	}
 
+	/**
+	 * Releases this window's OpenGL context from the calling thread.
+	 * @return Return OK if there is no error, otherwise return the error.
+	 */
+	int Window::ReleaseGLContext()
+	{
+		// Check that there is an OpenGL rendering context.
+		if (renderingContext)
+		{
+			// Clear the current OpenGL context so another thread is free to make it current.
+			if (!wglMakeCurrent(NULL, NULL))
+			{
+				// Return an error indicating that the OpenGL context couldn't be changed.
+				return WDGL_CHANGE_CONTEXT_ERROR;
+			}
+		}
+		// Return OK otherwise.
+		return OK;
+	}
+
+	int Window::createLoaderGLContext()
+	{
+		if (!renderingContext)
+		{
+			return WCGL_CREATE_CONTEXT_ERROR;
+		}
+		if (this->loaderContext)
+		{
+			return OK;
+		}
+
+		// The loader gets a hidden window of its own with the same pixel format, so the two threads never share a
+		// device context.  Its class does nothing with messages, so it cannot touch the window's viewport.
+		WNDCLASS loaderClass;
+		memset(&loaderClass, 0, sizeof(loaderClass));
+		loaderClass.style = CS_OWNDC;
+		loaderClass.lpfnWndProc = DefWindowProc;
+		loaderClass.hInstance = appInstance;
+		loaderClass.lpszClassName = L"PV Loader";
+		if (!RegisterClass(&loaderClass) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS)
+		{
+			printf("Error registering the loader window class!\n");
+			return REGISTER_ERROR;
+		}
+		PIXELFORMATDESCRIPTOR pixelFormatDesc;
+		int pixelFormat = GetPixelFormat(deviceContext);
+		DescribePixelFormat(deviceContext, pixelFormat, sizeof(pixelFormatDesc), &pixelFormatDesc);
+		if (!(this->loaderWindowHandle = CreateWindowEx(0, L"PV Loader", this->title, WS_POPUP, 0, 0, 1, 1, NULL, NULL, appInstance, NULL)) ||
+			!(this->loaderDeviceContext = GetDC(this->loaderWindowHandle)) ||
+			!SetPixelFormat(this->loaderDeviceContext, pixelFormat, &pixelFormatDesc))
+		{
+			printf("Error creating the loader's hidden window!\n");
+			this->destroyLoaderGLContext();
+			return WCGL_SET_PF_ERROR;
+		}
+
+		// Created with the settings the window's context actually got, since shared contexts have to match.
+		this->loaderContext = createContext(this->loaderDeviceContext, renderingContext, this->contextSettings);
+		if (this->loaderContext == NULL)
+		{
+			// Without wglCreateContextAttribsARB the window's context is a legacy one, which shares through wglShareLists.
+			this->loaderContext = wglCreateContext(this->loaderDeviceContext);
+			if (this->loaderContext != NULL && !wglShareLists(renderingContext, this->loaderContext))
+			{
+				wglDeleteContext(this->loaderContext);
+				this->loaderContext = NULL;
+			}
+		}
+		if (this->loaderContext == NULL)
+		{
+			printf("Error creating a loader context sharing with the window's!\n");
+			this->destroyLoaderGLContext();
+			return WCGL_CREATE_CONTEXT_ERROR;
+		}
+
+		// Debug output is set up per context, so the loader reports its own driver messages.
+		ContextSettings loaderSettings = this->contextSettings;
+		wglMakeCurrent(this->loaderDeviceContext, this->loaderContext);
+		finishContext(loaderSettings);
+		wglMakeCurrent(deviceContext, renderingContext);
+		return OK;
+	}
+
+	int Window::MakeCurrentLoaderGLContext()
+	{
+		if (!this->loaderContext)
+		{
+			return WCGL_SET_CONTEXT_ERROR;
+		}
+		if (!wglMakeCurrent(this->loaderDeviceContext, this->loaderContext))
+		{
+			printf("Error making the loader context the current one!\n");
+			return WCGL_SET_CONTEXT_ERROR;
+		}
+		return OK;
+	}
+
+	int Window::ReleaseLoaderGLContext()
+	{
+		if (this->loaderContext && !wglMakeCurrent(NULL, NULL))
+		{
+			return WDGL_CHANGE_CONTEXT_ERROR;
+		}
+		return OK;
+	}
+
+	void Window::destroyLoaderGLContext()
+	{
+		if (this->loaderContext)
+		{
+			wglDeleteContext(this->loaderContext);
+			this->loaderContext = NULL;
+		}
+		if (this->loaderDeviceContext)
+		{
+			ReleaseDC(this->loaderWindowHandle, this->loaderDeviceContext);
+			this->loaderDeviceContext = NULL;
+		}
+		if (this->loaderWindowHandle)
+		{
+			DestroyWindow(this->loaderWindowHandle);
+			this->loaderWindowHandle = NULL;
+		}
+	}
+
 	/**
 	 * Gets the window's handle object.
 	 *
@@ -599,6 +1051,8 @@ namespace PV
 	 */
 	void Window::destroyGLSystem()
 	{
+		// The loader context shares the window's objects, so it goes first.
+		this->destroyLoaderGLContext();
 		// Check if there is a rendering context associated with the window.
 		if (renderingContext)
 		{
@@ -630,5 +1084,807 @@ namespace PV
 	}
 #elif __APPLE__
 #elif __linux__
+	Window::Window()
+	{
+		this->eglDisplay = EGL_NO_DISPLAY;
+		this->renderingContext = EGL_NO_CONTEXT;
+		this->surface = EGL_NO_SURFACE;
+		this->loaderContext = EGL_NO_CONTEXT;
+		this->loaderSurface = EGL_NO_SURFACE;
+		this->config = NULL;
+		this->display = NULL;
+		this->windowHandle = 0;
+		this->width = 0;
+		this->height = 0;
+		this->active = false;
+		this->isFullscreen = false;
+		this->headless = false;
+		this->bitsPerPixel = DEFAULT_BITS_PER_PIXEL;
+		this->title = L"";
+		this->callback = NULL;
+		this->deleteMessage = 0;
+		this->contextSettings = GetDefaultContextSettings();
+		this->swapInterval = 1;
+		this->resetInput();
+	}
+
+	/**
+	 * Creates a window using the given information and then returns its status.
+	 *
+	 * @param title The title to be displayed in the window.
+	 * @param width An unsigned integer for the width of the window.
+	 * @param height An unsigned integer for the height of the window.
+	 * @param fullscreen If true, the window will cover the whole screen.
+	 * @param bitsPerPixel The bits per pixel to use for the window.
+	 * @return On success, this method will return 1.
+	 * On fail, it will return an error code.
+	 */
+	WINDOW_ERRORS Window::create(const wchar_t* title, unsigned int width, unsigned int height, bool fullscreen, int bitsPerPixel)
+	{
+		this->width = width;
+		this->height = height;
+		this->title = title;
+		this->bitsPerPixel = bitsPerPixel;
+		this->headless = false;
+		this->isFullscreen = false;
+		this->active = false;
+		this->pendingInput.windowWidth = width;
+		this->pendingInput.windowHeight = height;
+
+		// The render thread swaps through the same connection the window's thread reads events from.
+		XInitThreads();
+		// Connect to the display named by the DISPLAY environment variable.
+		if (!(this->display = XOpenDisplay(NULL)))
+		{
+			printf("Error creating window: cannot connect to an X11 display.  Use createHeadless to render without one.\n");
+			return CREATION_ERROR;
+		}
+
+		// Ask for the events the window handles itself or passes on to the callback.
+		int screen = DefaultScreen(this->display);
+		XSetWindowAttributes attributes;
+		attributes.background_pixel = BlackPixel(this->display, screen);
+		attributes.event_mask = StructureNotifyMask | ExposureMask | FocusChangeMask | KeyPressMask | KeyReleaseMask |
+			ButtonPressMask | ButtonReleaseMask | PointerMotionMask;
+		if (!(this->windowHandle = XCreateWindow(this->display, RootWindow(this->display, screen), 0, 0, width, height, 0, CopyFromParent,
+			InputOutput, CopyFromParent, CWBackPixel | CWEventMask, &attributes)))
+		{
+			printf("Error creating window!\n");
+			this->destroy();
+			return CREATION_ERROR;
+		}
+
+		// X11 titles are multibyte strings.
+		char multibyteTitle[256];
+		size_t length = wcstombs(multibyteTitle, title, sizeof(multibyteTitle) - 1);
+		multibyteTitle[(length == (size_t)-1) ? 0 : length] = '\0';
+		XStoreName(this->display, this->windowHandle, multibyteTitle);
+
+		// Have the window manager tell the window when the user closes it, rather than killing the connection.
+		Atom deleteMessage = XInternAtom(this->display, "WM_DELETE_WINDOW", False);
+		XSetWMProtocols(this->display, this->windowHandle, &deleteMessage, 1);
+		this->deleteMessage = deleteMessage;
+
+		// Show the window.
+		XMapWindow(this->display, this->windowHandle);
+		XFlush(this->display);
+		this->active = true;
+
+		if (fullscreen)
+		{
+			this->SetFullscreen(true);
+		}
+
+		// Return that everything went okay.
+		return OK;
+	}
+
+	WINDOW_ERRORS Window::create(const wchar_t* title, unsigned int width, unsigned int height, bool fullscreen, windowProcessCallback callback)
+	{
+		this->setWindowProcessCallback(callback);
+		// Create the window returning any errors that come up.
+		return this->create(title, width, height, fullscreen, DEFAULT_BITS_PER_PIXEL);
+	}
+
+	WINDOW_ERRORS Window::create(const wchar_t* title, bool fullscreen, windowProcessCallback callback)
+	{
+		this->setWindowProcessCallback(callback);
+		// Create the window returning any errors that come up.
+		return this->create(title, 1280, 800, fullscreen, DEFAULT_BITS_PER_PIXEL);
+	}
+
+	WINDOW_ERRORS Window::create(const wchar_t* title, windowProcessCallback callback)
+	{
+		this->setWindowProcessCallback(callback);
+		// Create the window returning any errors that come up.
+		return this->create(title, 1280, 800, false, DEFAULT_BITS_PER_PIXEL);
+	}
+
+	WINDOW_ERRORS Window::create(const wchar_t* title)
+	{
+		// Create the window returning any errors that come up.
+		return this->create(title, NULL);
+	}
+
+	WINDOW_ERRORS Window::createHeadless(unsigned int width, unsigned int height)
+	{
+		this->width = width;
+		this->height = height;
+		this->title = L"";
+		this->bitsPerPixel = DEFAULT_BITS_PER_PIXEL;
+		this->headless = true;
+		this->pendingInput.windowWidth = width;
+		this->pendingInput.windowHeight = height;
+		this->isFullscreen = false;
+		this->display = NULL;
+		this->windowHandle = 0;
+		// There is nothing for the user to close, so a headless window stays active until it is destroyed.
+		this->active = true;
+		return OK;
+	}
+
+	void Window::setWindowProcessCallback(windowProcessCallback callback)
+	{
+		this->callback = callback;
+	}
+
+	int Window::setVisible(bool visible)
+	{
+		if (this->display == NULL)
+		{
+			return 0;
+		}
+		XWindowAttributes attributes;
+		XGetWindowAttributes(this->display, this->windowHandle, &attributes);
+		if (visible)
+		{
+			XMapWindow(this->display, this->windowHandle);
+		}
+		else
+		{
+			XUnmapWindow(this->display, this->windowHandle);
+		}
+		XFlush(this->display);
+		return (attributes.map_state == IsViewable) ? 1 : 0;
+	}
+
+	int Window::Focus()
+	{
+		if (this->display == NULL)
+		{
+			return 0;
+		}
+		// Make sure the window is visible first.
+		this->setVisible(true);
+		XRaiseWindow(this->display, this->windowHandle);
+		XSetInputFocus(this->display, this->windowHandle, RevertToParent, CurrentTime);
+		XFlush(this->display);
+		return 1;
+	}
+
+	void Window::Update()
+	{
+		// Swap the buffers to update the display, or just push the commands out when drawing only into framebuffer
+		// objects, once the frame limit allows.
+		this->pacer.BeginSwap();
+		if (this->surface != EGL_NO_SURFACE)
+		{
+			eglSwapBuffers(this->eglDisplay, this->surface);
+		}
+		else if (this->renderingContext != EGL_NO_CONTEXT)
+		{
+			glFlush();
+		}
+		this->pacer.EndSwap();
+	}
+
+	/**
+	 * Turns an X11 key symbol into a key code, which is the same as Windows' virtual key code.
+	 * @param symbol The key symbol.
+	 * @return The key code, or PV_KEY_COUNT if the key has none.
+	 */
+	static unsigned int toKeyCode(KeySym symbol)
+	{
+		if (symbol >= XK_a && symbol <= XK_z)
+		{
+			return (unsigned int)('A' + (symbol - XK_a));
+		}
+		if (symbol >= XK_A && symbol <= XK_Z)
+		{
+			return (unsigned int)('A' + (symbol - XK_A));
+		}
+		if (symbol >= XK_0 && symbol <= XK_9)
+		{
+			return (unsigned int)('0' + (symbol - XK_0));
+		}
+		if (symbol >= XK_F1 && symbol <= XK_F12)
+		{
+			return PV_KEY_F1 + (unsigned int)(symbol - XK_F1);
+		}
+		switch (symbol)
+		{
+		case XK_BackSpace: return PV_KEY_BACKSPACE;
+		case XK_Tab: return PV_KEY_TAB;
+		case XK_Return: return PV_KEY_ENTER;
+		case XK_Shift_L: case XK_Shift_R: return PV_KEY_SHIFT;
+		case XK_Control_L: case XK_Control_R: return PV_KEY_CONTROL;
+		case XK_Alt_L: case XK_Alt_R: return PV_KEY_ALT;
+		case XK_Escape: return PV_KEY_ESCAPE;
+		case XK_space: return PV_KEY_SPACE;
+		case XK_Left: return PV_KEY_LEFT;
+		case XK_Up: return PV_KEY_UP;
+		case XK_Right: return PV_KEY_RIGHT;
+		case XK_Down: return PV_KEY_DOWN;
+		}
+		return PV_KEY_COUNT;
+	}
+
+	void Window::PumpEvents()
+	{
+		if (this->display == NULL)
+		{
+			this->publishInput();
+			return;
+		}
+		// Handle whatever has arrived since the last pump, without waiting for more.
+		while (XPending(this->display) > 0)
+		{
+			XEvent event;
+			XNextEvent(this->display, &event);
+			this->pendingInput.events += 1;
+			switch (event.type)
+			{
+			case KeyPress:
+				this->setKey(toKeyCode(XLookupKeysym(&event.xkey, 0)), true);
+				break;
+			case KeyRelease:
+				// Auto repeat sends a release immediately followed by a press with the same time, which is not a release.
+				if (XEventsQueued(this->display, QueuedAfterReading) > 0)
+				{
+					XEvent next;
+					XPeekEvent(this->display, &next);
+					if (next.type == KeyPress && next.xkey.keycode == event.xkey.keycode && next.xkey.time == event.xkey.time)
+					{
+						XNextEvent(this->display, &next);
+						break;
+					}
+				}
+				this->setKey(toKeyCode(XLookupKeysym(&event.xkey, 0)), false);
+				break;
+			case MotionNotify:
+				this->moveMouse(event.xmotion.x, event.xmotion.y);
+				break;
+			case ButtonPress:
+			case ButtonRelease:
+				// Buttons 4 and 5 are the wheel turning, which only sends presses that matter.
+				if (event.xbutton.button == Button4 || event.xbutton.button == Button5)
+				{
+					if (event.type == ButtonPress)
+					{
+						this->pendingInput.wheelDelta += (event.xbutton.button == Button4) ? 1 : -1;
+					}
+				}
+				else
+				{
+					unsigned int button = (event.xbutton.button == Button1) ? PV_MOUSE_LEFT : ((event.xbutton.button == Button3) ? PV_MOUSE_RIGHT : PV_MOUSE_MIDDLE);
+					if (event.type == ButtonPress)
+					{
+						this->pendingInput.mouseButtons |= button;
+					}
+					else
+					{
+						this->pendingInput.mouseButtons &= ~button;
+					}
+				}
+				break;
+			case FocusOut:
+				this->releaseInput();
+				break;
+			case ConfigureNotify:
+				this->width = event.xconfigure.width;
+				this->height = event.xconfigure.height;
+				this->pendingInput.windowWidth = this->width;
+				this->pendingInput.windowHeight = this->height;
+				break;
+			case ClientMessage:
+				if ((unsigned long)event.xclient.data.l[0] == this->deleteMessage)
+				{
+					this->pendingInput.closeRequested = true;
+					this->active = false;
+				}
+				break;
+			}
+			if (this->callback != NULL)
+			{
+				this->callback(&event);
+			}
+		}
+		this->publishInput();
+	}
+
+	/**
+	 * Creates an OpenGL context with the requested version, profile and flags through EGL_KHR_create_context.
+	 * @param eglDisplay The EGL display to create the context on.
+	 * @param config The config of the surfaces the context draws to.
+	 * @param shareContext The context to share textures and buffers with, or EGL_NO_CONTEXT.
+	 * @param settings The settings to create the context with.
+	 * @return The context, or EGL_NO_CONTEXT if the driver refused the settings.
+	 */
+	static EGLContext createContext(EGLDisplay eglDisplay, EGLConfig config, EGLContext shareContext, const ContextSettings& settings)
+	{
+		EGLint attributes[16];
+		int count = 0;
+		int majorVersion = settings.majorVersion;
+		int minorVersion = settings.minorVersion;
+		if (settings.profile == ProfileCore && (majorVersion < 3 || (majorVersion == 3 && minorVersion < 2)))
+		{
+			majorVersion = 3;
+			minorVersion = 2;
+		}
+		else if (majorVersion == 0 && settings.noError && !settings.debug)
+		{
+			// An unspecified version counts as 1.0, which is too old for KHR_no_error.  Asking for 2.0 still gives the
+			// newest compatible version.
+			majorVersion = 2;
+		}
+		if (majorVersion > 0)
+		{
+			attributes[count++] = EGL_CONTEXT_MAJOR_VERSION_KHR;
+			attributes[count++] = majorVersion;
+			attributes[count++] = EGL_CONTEXT_MINOR_VERSION_KHR;
+			attributes[count++] = minorVersion;
+			attributes[count++] = EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR;
+			attributes[count++] = (settings.profile == ProfileCore) ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR;
+		}
+		attributes[count++] = EGL_CONTEXT_FLAGS_KHR;
+		attributes[count++] = settings.debug ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR : 0;
+		int noErrorAttribute = count;
+		if (settings.noError && !settings.debug)
+		{
+			attributes[count++] = EGL_CONTEXT_OPENGL_NO_ERROR_KHR;
+			attributes[count++] = EGL_TRUE;
+		}
+		attributes[count] = EGL_NONE;
+
+		EGLContext context = eglCreateContext(eglDisplay, config, shareContext, attributes);
+		if (context == EGL_NO_CONTEXT && count > noErrorAttribute)
+		{
+			// Drivers without KHR_no_error reject the attribute, so try again with error checking.
+			attributes[noErrorAttribute] = EGL_NONE;
+			context = eglCreateContext(eglDisplay, config, shareContext, attributes);
+		}
+		return context;
+	}
+
+	int Window::setWindowDrawingStateGL()
+	{
+		// Headless windows ask Mesa for a display with no window system behind it, falling back to the default display.
+		if (this->headless)
+		{
+			const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+			PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+			if (extensions != NULL && strstr(extensions, "EGL_MESA_platform_surfaceless") != NULL && getPlatformDisplay != NULL)
+			{
+				this->eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			}
+			if (this->eglDisplay == EGL_NO_DISPLAY)
+			{
+				this->eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			}
+		}
+		else
+		{
+			this->eglDisplay = eglGetDisplay((EGLNativeDisplayType)this->display);
+		}
+		if (this->eglDisplay == EGL_NO_DISPLAY || !eglInitialize(this->eglDisplay, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API))
+		{
+			printf("Error getting an EGL display with desktop OpenGL!\n");
+			this->eglDisplay = EGL_NO_DISPLAY;
+			this->destroyGLSystem();
+			this->destroy();
+			return WCGL_GET_CONTEXT_ERROR;
+		}
+
+		// Pick an RGB(A) format with the requested depth and stencil buffers.
+		EGLint surfaceType = this->headless ? EGL_PBUFFER_BIT : EGL_WINDOW_BIT;
+		EGLint attributes[] = {
+			EGL_SURFACE_TYPE, surfaceType,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, (this->bitsPerPixel >= 32) ? 8 : 0,
+			EGL_DEPTH_SIZE, this->contextSettings.depthBits,
+			EGL_STENCIL_SIZE, this->contextSettings.stencilBits,
+			EGL_NONE
+		};
+		EGLConfig configs[64];
+		EGLint configCount = 0;
+		if ((!eglChooseConfig(this->eglDisplay, attributes, configs, 64, &configCount) || configCount == 0) && this->headless)
+		{
+			// Without pbuffers, a headless context can still draw into framebuffer objects with no surface at all.
+			attributes[1] = 0;
+			surfaceType = 0;
+			eglChooseConfig(this->eglDisplay, attributes, configs, 64, &configCount);
+		}
+		if (configCount == 0)
+		{
+			printf("Error finding a usable EGL config!\n");
+			this->destroyGLSystem();
+			this->destroy();
+			return WCGL_GET_PF_ERROR;
+		}
+
+		// A window surface needs a config matching the window's visual.
+		EGLConfig config = configs[0];
+		if (!this->headless)
+		{
+			XWindowAttributes windowAttributes;
+			XGetWindowAttributes(this->display, this->windowHandle, &windowAttributes);
+			VisualID visual = XVisualIDFromVisual(windowAttributes.visual);
+			for (EGLint i = 0; i < configCount; i += 1)
+			{
+				EGLint nativeVisual = 0;
+				eglGetConfigAttrib(this->eglDisplay, configs[i], EGL_NATIVE_VISUAL_ID, &nativeVisual);
+				if ((VisualID)nativeVisual == visual)
+				{
+					config = configs[i];
+					break;
+				}
+			}
+			this->surface = eglCreateWindowSurface(this->eglDisplay, config, (EGLNativeWindowType)this->windowHandle, NULL);
+		}
+		else if (surfaceType == EGL_PBUFFER_BIT)
+		{
+			EGLint pbufferAttributes[] = { EGL_WIDTH, (EGLint)this->width, EGL_HEIGHT, (EGLint)this->height, EGL_NONE };
+			this->surface = eglCreatePbufferSurface(this->eglDisplay, config, pbufferAttributes);
+		}
+		if (this->surface == EGL_NO_SURFACE && surfaceType != 0)
+		{
+			printf("Error creating an EGL surface!\n");
+			this->destroyGLSystem();
+			this->destroy();
+			return WCGL_SET_PF_ERROR;
+		}
+
+		// Attempt to create an OpenGL context and store it.
+		this->config = config;
+		this->renderingContext = createContext(this->eglDisplay, config, EGL_NO_CONTEXT, this->contextSettings);
+		if (this->renderingContext == EGL_NO_CONTEXT)
+		{
+			printf("Error creating rendering context!\n");
+			this->destroyGLSystem();
+			this->destroy();
+			return WCGL_CREATE_CONTEXT_ERROR;
+		}
+		// Try to set the current OpenGL context.
+		if (!eglMakeCurrent(this->eglDisplay, this->surface, this->surface, this->renderingContext))
+		{
+			printf("Error making rendering context the current one!\n");
+			this->destroyGLSystem();
+			this->destroy();
+			return WCGL_SET_CONTEXT_ERROR;
+		}
+		glViewport(0, 0, this->width, this->height);
+		finishContext(this->contextSettings);
+		return OK;
+	}
+
+	void Window::setContextSettings(const ContextSettings& settings)
+	{
+		this->contextSettings = settings;
+	}
+
+	const ContextSettings Window::GetContextSettings()
+	{
+		return this->contextSettings;
+	}
+
+	bool Window::SetSwapInterval(int interval)
+	{
+		// EGL has no adaptive vertical sync, and would clamp a negative interval to never waiting.
+		if (interval < 0)
+		{
+			interval = 1;
+		}
+		if (this->eglDisplay == EGL_NO_DISPLAY || !eglSwapInterval(this->eglDisplay, interval))
+		{
+			return false;
+		}
+		this->swapInterval = interval;
+		return true;
+	}
+
+	const int Window::GetSwapInterval()
+	{
+		return this->swapInterval;
+	}
+
+	void Window::SetFrameLimit(double framesPerSecond)
+	{
+		this->pacer.SetFrameLimit(framesPerSecond);
+	}
+
+	const FrameStats Window::GetFrameStats()
+	{
+		return this->pacer.GetStats();
+	}
+
+	int Window::MakeCurrentGLContext()
+	{
+		// Check that there is an OpenGL rendering context.
+		if (this->renderingContext != EGL_NO_CONTEXT)
+		{
+			// Try to set the current OpenGL context.
+			if (!eglMakeCurrent(this->eglDisplay, this->surface, this->surface, this->renderingContext))
+			{
+				printf("Error making rendering context the current one!\n");
+				// If setting the OpenGL context fails, destroy the OpenGL system and the window.
+				this->destroyGLSystem();
+				this->destroy();
+				return WCGL_SET_CONTEXT_ERROR;
+			}
+		}
+		// Return OK otherwise.
+		return OK;
+	}
+
+	int Window::ReleaseGLContext()
+	{
+		// Check that there is an OpenGL rendering context.
+		if (this->renderingContext != EGL_NO_CONTEXT)
+		{
+			// Clear the current OpenGL context so another thread is free to make it current.
+			if (!eglMakeCurrent(this->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT))
+			{
+				return WDGL_CHANGE_CONTEXT_ERROR;
+			}
+		}
+		// Return OK otherwise.
+		return OK;
+	}
+
+	int Window::createLoaderGLContext()
+	{
+		if (this->renderingContext == EGL_NO_CONTEXT)
+		{
+			return WCGL_CREATE_CONTEXT_ERROR;
+		}
+		if (this->loaderContext != EGL_NO_CONTEXT)
+		{
+			return OK;
+		}
+
+		// Created with the settings the window's context actually got, since shared contexts have to match.
+		this->loaderContext = createContext(this->eglDisplay, this->config, this->renderingContext, this->contextSettings);
+		if (this->loaderContext == EGL_NO_CONTEXT)
+		{
+			printf("Error creating a loader context sharing with the window's!\n");
+			return WCGL_CREATE_CONTEXT_ERROR;
+		}
+		// The loader only draws into textures, so a tiny pbuffer does, or no surface at all where the config has none.
+		EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		this->loaderSurface = eglCreatePbufferSurface(this->eglDisplay, this->config, pbufferAttributes);
+
+		// Debug output is set up per context, so the loader reports its own driver messages.
+		EGLContext current = eglGetCurrentContext();
+		EGLSurface currentDraw = eglGetCurrentSurface(EGL_DRAW);
+		EGLSurface currentRead = eglGetCurrentSurface(EGL_READ);
+		if (!eglMakeCurrent(this->eglDisplay, this->loaderSurface, this->loaderSurface, this->loaderContext))
+		{
+			printf("Error making the loader context the current one!\n");
+			this->destroyLoaderGLContext();
+			return WCGL_SET_CONTEXT_ERROR;
+		}
+		ContextSettings loaderSettings = this->contextSettings;
+		finishContext(loaderSettings);
+		eglMakeCurrent(this->eglDisplay, currentDraw, currentRead, current);
+		return OK;
+	}
+
+	int Window::MakeCurrentLoaderGLContext()
+	{
+		if (this->loaderContext == EGL_NO_CONTEXT)
+		{
+			return WCGL_SET_CONTEXT_ERROR;
+		}
+		if (!eglMakeCurrent(this->eglDisplay, this->loaderSurface, this->loaderSurface, this->loaderContext))
+		{
+			printf("Error making the loader context the current one!\n");
+			return WCGL_SET_CONTEXT_ERROR;
+		}
+		return OK;
+	}
+
+	int Window::ReleaseLoaderGLContext()
+	{
+		if (this->loaderContext != EGL_NO_CONTEXT && !eglMakeCurrent(this->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT))
+		{
+			return WDGL_CHANGE_CONTEXT_ERROR;
+		}
+		return OK;
+	}
+
+	void Window::destroyLoaderGLContext()
+	{
+		if (this->loaderContext != EGL_NO_CONTEXT)
+		{
+			eglDestroyContext(this->eglDisplay, this->loaderContext);
+			this->loaderContext = EGL_NO_CONTEXT;
+		}
+		if (this->loaderSurface != EGL_NO_SURFACE)
+		{
+			eglDestroySurface(this->eglDisplay, this->loaderSurface);
+			this->loaderSurface = EGL_NO_SURFACE;
+		}
+	}
+
+	const bool Window::IsActive()
+	{
+		return this->active;
+	}
+
+	const bool Window::IsHeadless()
+	{
+		return this->headless;
+	}
+
+	const bool Window::IsFullscreen()
+	{
+		return this->isFullscreen;
+	}
+
+	void Window::SetFullscreen(bool fullscreen)
+	{
+		if (this->display == NULL)
+		{
+			return;
+		}
+		this->isFullscreen = fullscreen;
+
+		// Ask the window manager through the extended window manager hints, which every modern one supports.
+		XEvent event;
+		memset(&event, 0, sizeof(event));
+		event.type = ClientMessage;
+		event.xclient.window = this->windowHandle;
+		event.xclient.message_type = XInternAtom(this->display, "_NET_WM_STATE", False);
+		event.xclient.format = 32;
+		event.xclient.data.l[0] = fullscreen ? 1 : 0;
+		event.xclient.data.l[1] = XInternAtom(this->display, "_NET_WM_STATE_FULLSCREEN", False);
+		event.xclient.data.l[3] = 1;
+		XSendEvent(this->display, DefaultRootWindow(this->display), False, SubstructureRedirectMask | SubstructureNotifyMask, &event);
+		XFlush(this->display);
+	}
+
+	const int Window::BitsPerPixel()
+	{
+		return this->bitsPerPixel;
+	}
+
+	const wchar_t* Window::Title()
+	{
+		return this->title;
+	}
+
+	void Window::destroy()
+	{
+		if (this->display != NULL)
+		{
+			if (this->windowHandle != 0)
+			{
+				XDestroyWindow(this->display, this->windowHandle);
+				this->windowHandle = 0;
+			}
+			XCloseDisplay(this->display);
+			this->display = NULL;
+		}
+		this->isFullscreen = false;
+		this->active = false;
+	}
+
+	void Window::destroyGLSystem()
+	{
+		if (this->eglDisplay == EGL_NO_DISPLAY)
+		{
+			return;
+		}
+		// Get rid of the current OpenGL context.
+		if (!eglMakeCurrent(this->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT))
+		{
+			printf("Changing window OpenGL context failed!\n");
+		}
+		// The loader context shares the window's objects, so it goes first.
+		this->destroyLoaderGLContext();
+		if (this->renderingContext != EGL_NO_CONTEXT && !eglDestroyContext(this->eglDisplay, this->renderingContext))
+		{
+			printf("Error destroying the OpenGL context!\n");
+		}
+		if (this->surface != EGL_NO_SURFACE)
+		{
+			eglDestroySurface(this->eglDisplay, this->surface);
+		}
+		eglTerminate(this->eglDisplay);
+		this->renderingContext = EGL_NO_CONTEXT;
+		this->surface = EGL_NO_SURFACE;
+		this->eglDisplay = EGL_NO_DISPLAY;
+	}
+#endif
+
+#if defined(_WIN32) || defined(__linux__)
+	const InputSnapshot Window::GetInput()
+	{
+		return this->input.GetState();
+	}
+
+	void Window::resetInput()
+	{
+		memset(&this->pendingInput, 0, sizeof(this->pendingInput));
+		this->mousePositionKnown = false;
+		// Publish into both slots so reading before the first pump gives no input.
+		this->input.SetState(this->pendingInput);
+		this->input.SetState(this->pendingInput);
+	}
+
+	void Window::setKey(unsigned int key, bool down)
+	{
+		if (key >= PV_KEY_COUNT)
+		{
+			return;
+		}
+		unsigned int bit = 1u << (key % 32);
+		if (down)
+		{
+			// Held keys repeat their key down events, which are not new presses.
+			if (!(this->pendingInput.keysDown[key / 32] & bit))
+			{
+				this->pendingInput.keysPressed[key / 32] |= bit;
+			}
+			this->pendingInput.keysDown[key / 32] |= bit;
+		}
+		else
+		{
+			this->pendingInput.keysDown[key / 32] &= ~bit;
+			this->pendingInput.keysReleased[key / 32] |= bit;
+		}
+	}
+
+	void Window::releaseInput()
+	{
+		for (int i = 0; i < PV_KEY_COUNT / 32; i += 1)
+		{
+			this->pendingInput.keysReleased[i] |= this->pendingInput.keysDown[i];
+			this->pendingInput.keysDown[i] = 0;
+		}
+		this->pendingInput.mouseButtons = 0;
+	}
+
+	void Window::moveMouse(int x, int y)
+	{
+		if (this->mousePositionKnown)
+		{
+			this->pendingInput.mouseDeltaX += x - this->pendingInput.mouseX;
+			this->pendingInput.mouseDeltaY += y - this->pendingInput.mouseY;
+		}
+		this->pendingInput.mouseX = x;
+		this->pendingInput.mouseY = y;
+		this->mousePositionKnown = true;
+	}
+
+	void Window::publishInput()
+	{
+		InputSnapshot& snapshot = this->pendingInput;
+		snapshot.previousTime = snapshot.time;
+		snapshot.time = ovr_GetTimeInSeconds();
+		snapshot.frameIndex += 1;
+		this->input.SetState(snapshot);
+
+		// Held keys, buttons and the mouse position carry over, while everything that counts changes starts again.
+		memset(snapshot.keysPressed, 0, sizeof(snapshot.keysPressed));
+		memset(snapshot.keysReleased, 0, sizeof(snapshot.keysReleased));
+		snapshot.mouseDeltaX = 0;
+		snapshot.mouseDeltaY = 0;
+		snapshot.wheelDelta = 0;
+		snapshot.events = 0;
+	}
 #endif
 };